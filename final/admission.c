@@ -0,0 +1,156 @@
+#include <string.h>
+#include <pthread.h>
+#include "admission.h"
+
+// Live orders are placed but not yet delivered or cancelled. Their wait is
+// predicted by Little's law: live orders times the average time between
+// two deliveries. Intake closes at the high watermark (or the wait limit)
+// and opens again only at the low one, so it does not flap per order.
+static AdmissionConfig config = { ADMISSION_OFF, 0, 0, 0.0 };
+static void (*open_hook)(void) = NULL;
+static pthread_mutex_t admission_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int open = 1;
+static int live = 0;
+static double completion_interval = 0.0; // EWMA, seconds between completions
+static double last_release = 0.0;
+static AdmissionStats stats;
+
+int admission_parse_mode(const char* name) {
+    if (strcmp(name, "off") == 0) {
+        return ADMISSION_OFF;
+    }
+    if (strcmp(name, "pause") == 0) {
+        return ADMISSION_PAUSE;
+    }
+    if (strcmp(name, "reject") == 0) {
+        return ADMISSION_REJECT;
+    }
+    return -1;
+}
+
+void admission_init(const AdmissionConfig* new_config, void (*on_open)(void)) {
+    config = *new_config;
+    if (config.low_watermark > config.high_watermark) {
+        config.low_watermark = config.high_watermark;
+    }
+    open_hook = on_open;
+}
+
+static double predicted_wait(void) {
+    return live * completion_interval;
+}
+
+// Called with admission_mutex held after live went up
+static void close_if_full(void) {
+    if (config.mode == ADMISSION_OFF || !open) {
+        return;
+    }
+    if ((config.high_watermark > 0 && live >= config.high_watermark) ||
+        (config.max_wait > 0 && predicted_wait() > config.max_wait)) {
+        open = 0;
+        stats.pauses++;
+    }
+}
+
+// Called with admission_mutex held after live went down. Returns 1 if it opened.
+static int open_if_drained(void) {
+    if (open || (config.high_watermark > 0 && live > config.low_watermark) ||
+        (config.max_wait > 0 && predicted_wait() > config.max_wait)) {
+        return 0;
+    }
+    open = 1;
+    return 1;
+}
+
+int admission_accepting(void) {
+    pthread_mutex_lock(&admission_mutex);
+    int accepting = open;
+    pthread_mutex_unlock(&admission_mutex);
+    return accepting;
+}
+
+// Time until the backlog is down to the low watermark
+static int retry_after_ms(void) {
+    if (completion_interval == 0.0) {
+        return 100;
+    }
+    double ms = (live - config.low_watermark) * completion_interval * 1000.0;
+    if (ms < ADMISSION_MIN_RETRY_MS) {
+        return ADMISSION_MIN_RETRY_MS;
+    }
+    return ms > ADMISSION_MAX_RETRY_MS ? ADMISSION_MAX_RETRY_MS : (int)ms;
+}
+
+int admission_try(void) {
+    pthread_mutex_lock(&admission_mutex);
+    // Pause mode stops reading before an order frame while closed, so only
+    // the rest of a batch that crossed the watermark is turned away here
+    if (config.mode != ADMISSION_OFF && !open) {
+        stats.rejected++;
+        int retry = retry_after_ms();
+        pthread_mutex_unlock(&admission_mutex);
+        return retry;
+    }
+    live++;
+    stats.admitted++;
+    if (live > stats.max_live) {
+        stats.max_live = live;
+    }
+    close_if_full();
+    pthread_mutex_unlock(&admission_mutex);
+    return 0;
+}
+
+void admission_add(int count) {
+    pthread_mutex_lock(&admission_mutex);
+    live += count;
+    if (live > stats.max_live) {
+        stats.max_live = live;
+    }
+    close_if_full();
+    int opened = count < 0 && open_if_drained();
+    pthread_mutex_unlock(&admission_mutex);
+    if (opened && open_hook != NULL) {
+        open_hook();
+    }
+}
+
+void admission_release(double now) {
+    pthread_mutex_lock(&admission_mutex);
+    if (live > 0) {
+        live--;
+    }
+    if (last_release > 0) {
+        double interval = now - last_release;
+        completion_interval = completion_interval == 0.0 ? interval : completion_interval + ADMISSION_EWMA_WEIGHT * (interval - completion_interval);
+    }
+    last_release = now;
+
+    int opened = open_if_drained();
+    pthread_mutex_unlock(&admission_mutex);
+    if (opened && open_hook != NULL) {
+        open_hook();
+    }
+}
+
+// A disconnect cancels a whole client at once; those near-zero intervals
+// would drag the EWMA down and reopen intake though the kitchen is no faster
+void admission_cancel(void) {
+    pthread_mutex_lock(&admission_mutex);
+    if (live > 0) {
+        live--;
+    }
+    int opened = open_if_drained();
+    pthread_mutex_unlock(&admission_mutex);
+    if (opened && open_hook != NULL) {
+        open_hook();
+    }
+}
+
+void admission_get_stats(AdmissionStats* out) {
+    pthread_mutex_lock(&admission_mutex);
+    *out = stats;
+    out->live = live;
+    out->predicted_wait = predicted_wait();
+    pthread_mutex_unlock(&admission_mutex);
+}
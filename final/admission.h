@@ -0,0 +1,37 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#define ADMISSION_OFF 0    // Take everything, as before
+#define ADMISSION_PAUSE 1  // Stop reading the client's socket, TCP pushes back; the rest of a batch is retried
+#define ADMISSION_REJECT 2 // Answer FRAME_RETRY_AFTER, the client sends again later
+
+#define ADMISSION_MIN_RETRY_MS 10
+#define ADMISSION_MAX_RETRY_MS 5000
+#define ADMISSION_EWMA_WEIGHT 0.05
+
+typedef struct {
+    int mode;
+    int high_watermark;  // Live orders at which intake stops, 0 = no depth limit
+    int low_watermark;   // Intake starts again at or below this
+    double max_wait;     // Seconds of predicted wait at which intake stops, 0 = no limit
+} AdmissionConfig;
+
+typedef struct {
+    long admitted;
+    long rejected;
+    long pauses;      // Times intake closed
+    int live;
+    int max_live;
+    double predicted_wait; // Seconds, for an order arriving now
+} AdmissionStats;
+
+int admission_parse_mode(const char* name);
+void admission_init(const AdmissionConfig* config, void (*on_open)(void));
+int admission_accepting(void);       // 0 while intake is closed
+int admission_try(void);             // 0 admitted, else retry-after in ms
+void admission_add(int count);       // Orders placed without asking (journal replay), or taken back
+void admission_release(double now);  // An order was delivered, its interval feeds the prediction
+void admission_cancel(void);         // An order was cancelled, it says nothing about kitchen speed
+void admission_get_stats(AdmissionStats* stats);
+
+#endif
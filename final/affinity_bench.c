@@ -0,0 +1,114 @@
+// Worker layout benchmark: threads bump their own counters the way cooks
+// and couriers bump work_count, with the state either packed into one
+// malloc'd array like the original Cook/DeliveryPerson arrays or on
+// node-local pages of its own, and with the threads unpinned, compact or
+// scattered over the CPUs.
+//   ./affinity_bench [threads] [iterations]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "topology.h"
+
+typedef struct {
+    int id;
+    int work_count;
+    double busy_seconds;
+} PackedWorker; // 16 bytes, four to a cache line
+
+static int thread_count = 8;
+static long iterations = 20000000;
+static pthread_barrier_t barrier;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* worker(void* arg) {
+    volatile PackedWorker* self = arg;
+    pthread_barrier_wait(&barrier);
+    for (long i = 0; i < iterations; ++i) {
+        self->work_count++;
+        self->busy_seconds += 1e-9;
+    }
+    return NULL;
+}
+
+static double run(int local, int mode) {
+    PackedWorker* packed = NULL;
+    PackedWorker** workers = malloc(thread_count * sizeof(PackedWorker*));
+    pthread_t* threads = malloc(thread_count * sizeof(pthread_t));
+    if (workers == NULL || threads == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    if (!local) {
+        packed = calloc(thread_count, sizeof(PackedWorker));
+        if (packed == NULL) {
+            perror("calloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        workers[i] = local ? topology_alloc_local(sizeof(PackedWorker), topology_node_of(topology_cpu_for(mode, i))) : &packed[i];
+        if (workers[i] == NULL) {
+            exit(EXIT_FAILURE);
+        }
+        workers[i]->id = i;
+    }
+
+    pthread_barrier_init(&barrier, NULL, thread_count + 1);
+    for (int i = 0; i < thread_count; ++i) {
+        if (topology_create_thread(&threads[i], topology_cpu_for(mode, i), worker, workers[i]) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    pthread_barrier_wait(&barrier);
+    double start = now_seconds();
+    for (int i = 0; i < thread_count; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now_seconds() - start;
+    pthread_barrier_destroy(&barrier);
+
+    long total = 0;
+    for (int i = 0; i < thread_count; ++i) {
+        total += workers[i]->work_count;
+        if (local) {
+            topology_free_local(workers[i], sizeof(PackedWorker));
+        }
+    }
+    free(packed);
+    free(workers);
+    free(threads);
+    return total / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        thread_count = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        iterations = atol(argv[2]);
+    }
+    if (thread_count < 1 || iterations < 1) {
+        fprintf(stderr, "Usage: %s [threads] [iterations]\n", argv[0]);
+        return 1;
+    }
+    if (topology_init() < 0) {
+        fprintf(stderr, "Cannot read the CPU topology\n");
+        return 1;
+    }
+    topology_print();
+    printf("%d threads, %ld updates each\n", thread_count, iterations);
+    printf("%8s | %14s %14s\n", "", "packed Mops/s", "local Mops/s");
+    for (int mode = AFFINITY_NONE; mode <= AFFINITY_SCATTER; ++mode) {
+        double packed = run(0, mode);
+        double local = run(1, mode);
+        printf("%8s | %14.1f %14.1f\n", topology_affinity_name(mode), packed / 1e6, local / 1e6);
+    }
+    return 0;
+}
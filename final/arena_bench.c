@@ -0,0 +1,151 @@
+// Allocation benchmark: batches of orders are stored, once the way the
+// original server did it (per-batch socket and PID arrays, a malloc'd
+// thread argument per order, a realloc-grown order array) and once through
+// per-session arenas over the chunked order store. Allocator calls are
+// counted by wrapping malloc, calloc and realloc at link time. Then one
+// session that never runs dry: its committed chunks must follow the live
+// orders, not the total.
+//   ./arena_bench [batches] [orders_per_batch]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/types.h>
+#include "orderstore.h"
+
+long allocator_calls = 0; // Not static: calls into malloc must be seen to change it
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    allocator_calls++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    allocator_calls++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    allocator_calls++;
+    return __real_realloc(ptr, size);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void fill(Order* order, int id) {
+    order->order_id = id;
+    order->customer_x = id % 97;
+    order->customer_y = id % 89;
+    order->state = 0;
+}
+
+static long legacy(int batches, int per_batch, double* elapsed) {
+    Order* orders = NULL;
+    size_t capacity = 0;
+    size_t count = 0;
+    long before = allocator_calls;
+    double start = now_seconds();
+    for (int b = 0; b < batches; ++b) {
+        int* client_sockets = malloc(per_batch * sizeof(int));
+        pid_t* client_pids = malloc(per_batch * sizeof(pid_t));
+        for (int i = 0; i < per_batch; ++i) {
+            int* argument = malloc(sizeof(int)); // handle_client thread argument
+            *argument = i;
+            if (count == capacity) {
+                capacity = capacity == 0 ? 10 : capacity * 2;
+                orders = realloc(orders, capacity * sizeof(Order));
+            }
+            fill(&orders[count++], i);
+            client_sockets[i] = *argument;
+            client_pids[i] = b;
+            free(argument);
+        }
+        free(client_sockets);
+        free(client_pids);
+    }
+    *elapsed = now_seconds() - start;
+    free(orders);
+    return allocator_calls - before;
+}
+
+static long arena(int batches, int per_batch, double* elapsed) {
+    long before = allocator_calls;
+    double start = now_seconds();
+    Order* orders = order_store_init();
+    if (orders == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    OrderArena session = { 0 };
+    for (int b = 0; b < batches; ++b) {
+        for (int i = 0; i < per_batch; ++i) {
+            int slot = order_arena_alloc(&session);
+            if (slot < 0) {
+                fprintf(stderr, "Order store is full\n");
+                exit(EXIT_FAILURE);
+            }
+            fill(&orders[slot], i);
+        }
+        order_arena_reset(&session); // Batch delivered
+    }
+    *elapsed = now_seconds() - start;
+    OrderStoreStats stats;
+    order_store_get_stats(&stats);
+    printf("store: %ld chunks committed, %ld refills, %ld resets\n", stats.chunks_committed, stats.chunk_takes, stats.arena_resets);
+    order_store_destroy();
+    return allocator_calls - before;
+}
+
+// Orders finish oldest first but some always stay live, so the session's
+// arena is never reset as a whole
+static void long_lived(long total, int live) {
+    if (order_store_init() == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    int* window = __real_malloc(live * sizeof(int));
+    OrderArena session = { 0 };
+    for (long i = 0; i < total; ++i) {
+        if (i >= live) {
+            order_arena_free(&session, window[i % live]);
+        }
+        window[i % live] = order_arena_alloc(&session);
+        if (window[i % live] < 0) {
+            fprintf(stderr, "Order store is full after %ld orders\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    OrderStoreStats stats;
+    order_store_get_stats(&stats);
+    long bound = live / ORDER_CHUNK_SIZE + 2;
+    printf("long-lived session: %ld orders, %d live at a time, %ld chunks committed (bound %ld), %ld reclaimed: %s\n", total, live,
+           stats.chunks_committed, bound, stats.chunks_reclaimed, stats.chunks_committed <= bound ? "ok" : "MISSED");
+    free(window);
+    order_store_destroy();
+}
+
+int main(int argc, char* argv[]) {
+    int batches = argc > 1 ? atoi(argv[1]) : 1000;
+    int per_batch = argc > 2 ? atoi(argv[2]) : 1000;
+    if (batches < 1 || per_batch < 1) {
+        fprintf(stderr, "Usage: %s [batches] [orders_per_batch]\n", argv[0]);
+        return 1;
+    }
+    long orders = (long)batches * per_batch;
+
+    double legacy_time, arena_time;
+    long legacy_calls = legacy(batches, per_batch, &legacy_time);
+    long arena_calls = arena(batches, per_batch, &arena_time);
+
+    printf("%ld orders in %d batches\n", orders, batches);
+    printf("%8s | %14s %12s | %10s\n", "", "allocator", "per order", "ns/order");
+    printf("%8s | %14ld %12.4f | %10.1f\n", "legacy", legacy_calls, (double)legacy_calls / orders, legacy_time * 1e9 / orders);
+    printf("%8s | %14ld %12.4f | %10.1f\n", "arena", arena_calls, (double)arena_calls / orders, arena_time * 1e9 / orders);
+    long_lived(orders * 4, per_batch);
+    return 0;
+}
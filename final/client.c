@@ -5,19 +5,78 @@
 #include <signal.h>
 #include <time.h>
 #include <string.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include "protocol.h"
+#include "loadgen.h"
 
-#define BUFFER_SIZE 2048
 
-int client_socket;
-int *client_sockets = NULL; // All client sockets
+int client_socket = -1; // Persistent order connection
+int status_socket = -1; // Persistent status subscription
+int completion_socket = -1; // Receives FRAME_COMPLETE for our orders
 int number_of_clients = 0; // Number of clients
 void handle_signal(int signal);
+int send_all(int socket, const void* data, size_t length);
 
-void receive_completion_status(const char* ipaddress, int port);
+void receive_completion_status(void);
+int subscribe(const char* ipaddress, int port, pid_t pid);
+void* follow_status(void* arg);
+void* resend_retries(void* arg);
+
+// Sunucu geri çevirdiği siparişleri FRAME_RETRY_AFTER ile bildirir; tekrar
+// göndermek için konumlar saklanır. Ana iş parçacığı ile aynı soketi paylaşır.
+int* order_x = NULL;
+int* order_y = NULL;
+pthread_mutex_t order_send_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Open-loop yük modu, -r verilince
+double load_rate = 0.0;
+int load_threads = 1;
+int load_arrival = ARRIVAL_POISSON;
+int load_burst = LOAD_DEFAULT_BURST;
+const char* load_csv = NULL;
+int load_retries = LOAD_DEFAULT_RETRIES;
+
+// Optional flags after the positional arguments
+int parse_options(int argc, char* argv[], int first) {
+    for (int i = first; i < argc; ++i) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            load_rate = atof(argv[++i]);
+            if (load_rate <= 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            load_threads = atoi(argv[++i]);
+            if (load_threads < 1 || load_threads > LOAD_MAX_THREADS) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-A") == 0 && i + 1 < argc) {
+            load_arrival = loadgen_parse_arrival(argv[++i]);
+            if (load_arrival < 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc) {
+            load_burst = atoi(argv[++i]);
+            if (load_burst < 1) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            load_csv = argv[++i];
+        } else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc) {
+            load_retries = atoi(argv[++i]);
+            if (load_retries < 0) {
+                return -1;
+            }
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
-    if (argc != 6) {
-        fprintf(stderr, "Kullanım: %s [ipaddress] [port] [numberOfClients] [p] [q]\n", argv[0]);
+    if (argc < 6 || parse_options(argc, argv, 6) < 0) {
+        fprintf(stderr, "Kullanım: %s [ipaddress] [port] [numberOfClients] [p] [q] [-r ordersPerSec] [-t threads] [-A constant|poisson|bursty] [-B burstSize] [-o series.csv] [-M maxRetries]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -35,11 +94,20 @@ int main(int argc, char* argv[]) {
     signal(SIGINT, handle_signal);
     signal(SIGTERM, handle_signal);
 
-    client_sockets = (int*)malloc(number_of_clients * sizeof(int));
+    // Yük modu: siparişler zamanlamaya göre gönderilir, cevap beklenmeden
+    if (load_rate > 0) {
+        if (number_of_clients < 1 || p < 1 || q < 1) {
+            fprintf(stderr, "> numberOfClients, p and q must be positive\n");
+            exit(EXIT_FAILURE);
+        }
+        LoadConfig load_config = { ipaddress, port, number_of_clients, p, q, load_threads, load_rate, load_arrival,
+                                   load_burst, load_csv, (unsigned int)time(NULL), load_retries };
+        exit(loadgen_run(&load_config) < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
 
-    // First, send the number of clients and p, q values to the server
-    int init_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (init_socket < 0) {
+    // Tüm siparişler tek bir kalıcı bağlantı üzerinden gönderilir
+    client_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (client_socket < 0) {
         perror("Soket oluşturulamadı");
         exit(EXIT_FAILURE);
     }
@@ -49,100 +117,287 @@ int main(int argc, char* argv[]) {
     server_address.sin_port = htons(port); // Kullanıcıdan alınan port numarası
     server_address.sin_addr.s_addr = inet_addr(ipaddress); // Kullanıcıdan alınan IP adresi
 
-    if (connect(init_socket, (struct sockaddr*)&server_address, sizeof(server_address)) < 0) {
+    if (connect(client_socket, (struct sockaddr*)&server_address, sizeof(server_address)) < 0) {
         perror("Sunucuya bağlanılamadı");
-        close(init_socket);
+        close(client_socket);
         exit(EXIT_FAILURE);
     }
 
-    send(init_socket, &number_of_clients, sizeof(int), 0); // Send number of clients to server
-    send(init_socket, &p, sizeof(int), 0); // Send p value
-    send(init_socket, &q, sizeof(int), 0); // Send q value
-    close(init_socket);
+    // Siparişlerimizin durumunu canlı takip et
+    pthread_t status_thread;
+    status_socket = subscribe(ipaddress, port + 1, getpid());
+    int following = status_socket != -1 && pthread_create(&status_thread, NULL, follow_status, NULL) == 0;
 
-    for (int i = 0; i < number_of_clients; ++i) {
-        client_sockets[i] = socket(AF_INET, SOCK_STREAM, 0);
-        if (client_sockets[i] < 0) {
-            perror("Soket oluşturulamadı");
-            exit(EXIT_FAILURE);
-        }
-
-        if (connect(client_sockets[i], (struct sockaddr*)&server_address, sizeof(server_address)) < 0) {
-            perror("Sunucuya bağlanılamadı");
-            close(client_sockets[i]);
-            exit(EXIT_FAILURE);
-        }
+    // Tamamlanma bildirimi için siparişlerden önce abone ol
+    completion_socket = subscribe(ipaddress, port + 2, getpid());
+    if (completion_socket == -1) {
+        exit(EXIT_FAILURE);
+    }
 
-        pid_t client_pid = getpid(); // Get current process ID (PID)
-        send(client_sockets[i], &client_pid, sizeof(pid_t), 0); // Send PID to server
+    struct timeval start_time, end_time;
+    gettimeofday(&start_time, NULL);
 
-        int order_id = i + 1;
-        int customer_x = rand() % p;
-        int customer_y = rand() % q;
-        char buffer[BUFFER_SIZE];
-        snprintf(buffer, sizeof(buffer), "%d %d %d %d", order_id, customer_x, customer_y, client_pid);
+    // First, send the number of clients and p, q values to the server
+    pid_t client_pid = getpid(); // Get current process ID (PID)
+    unsigned char hello[FRAME_HEADER_SIZE + HELLO_PAYLOAD_SIZE];
+    size_t offset = put_frame_header(hello, FRAME_HELLO, HELLO_PAYLOAD_SIZE);
+    put_u32(hello + offset, (uint32_t)client_pid);
+    put_u32(hello + offset + 4, (uint32_t)number_of_clients);
+    put_u32(hello + offset + 8, (uint32_t)p);
+    put_u32(hello + offset + 12, (uint32_t)q);
+    if (send_all(client_socket, hello, sizeof(hello)) < 0) {
+        perror("send");
+        exit(EXIT_FAILURE);
+    }
 
-        send(client_sockets[i], buffer, strlen(buffer), 0);
-        printf("> Sipariş verildi: ID %d, Konum (%d, %d)\n", order_id, customer_x, customer_y);
+    // Siparişleri BATCH_MAX_ORDERS'lık paketler halinde gönder
+    unsigned char* frame = malloc(FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD);
+    order_x = malloc(number_of_clients * sizeof(int));
+    order_y = malloc(number_of_clients * sizeof(int));
+    if (frame == NULL || order_x == NULL || order_y == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    pthread_t retry_thread;
+    if (pthread_create(&retry_thread, NULL, resend_retries, NULL) != 0) {
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+    }
+    for (int first = 0; first < number_of_clients; first += BATCH_MAX_ORDERS) {
+        int count = number_of_clients - first < BATCH_MAX_ORDERS ? number_of_clients - first : BATCH_MAX_ORDERS;
+        uint32_t payload_length = BATCH_HEADER_SIZE + count * BATCH_ENTRY_SIZE;
+        offset = put_frame_header(frame, FRAME_ORDER_BATCH, payload_length);
+        put_u32(frame + offset, (uint32_t)client_pid);
+        put_u32(frame + offset + 4, (uint32_t)count);
+        offset += BATCH_HEADER_SIZE;
 
-  
+        for (int i = first; i < first + count; ++i) {
+            int order_id = i + 1;
+            int customer_x = rand() % p;
+            int customer_y = rand() % q;
+            order_x[i] = customer_x;
+            order_y[i] = customer_y;
+            put_u32(frame + offset, (uint32_t)order_id);
+            put_u32(frame + offset + 4, (uint32_t)customer_x);
+            put_u32(frame + offset + 8, (uint32_t)customer_y);
+            offset += BATCH_ENTRY_SIZE;
+            printf("> Sipariş verildi: ID %d, Konum (%d, %d)\n", order_id, customer_x, customer_y);
+        }
 
-        close(client_sockets[i]);
+        pthread_mutex_lock(&order_send_mutex);
+        int sent = send_all(client_socket, frame, offset);
+        pthread_mutex_unlock(&order_send_mutex);
+        if (sent < 0) {
+            perror("send");
+            exit(EXIT_FAILURE);
+        }
     }
+    free(frame);
+
+    gettimeofday(&end_time, NULL);
+    double elapsed = (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_usec - start_time.tv_usec) / 1000000.0;
+    printf("> %d sipariş %.3f ms'de gönderildi (%.0f orders/sec)\n", number_of_clients, elapsed * 1000.0, elapsed > 0 ? number_of_clients / elapsed : 0.0);
 
     // Siparişlerin tamamlandığını bekle
-    receive_completion_status(ipaddress, port + 2);
+    receive_completion_status();
 
     printf("> Tüm siparişler tamamlandı\n");
-    free(client_sockets);
+    if (following) {
+        pthread_join(status_thread, NULL); // Son durum penceresini de al
+    }
+    shutdown(client_socket, SHUT_RDWR);
+    pthread_join(retry_thread, NULL);
+    close(client_socket);
+    free(order_x);
+    free(order_y);
     return 0;
 }
 
-void receive_completion_status(const char* ipaddress, int port) {
-    int completion_socket;
-    struct sockaddr_in server_address;
-    char buffer[BUFFER_SIZE];
+static int read_all(int socket, unsigned char* data, size_t length);
 
-    completion_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (completion_socket < 0) {
-        perror("Soket oluşturulamadı");
+// Blocks until the server pushes FRAME_COMPLETE for this process
+void receive_completion_status(void) {
+    unsigned char frame[FRAME_HEADER_SIZE + COMPLETE_PAYLOAD_SIZE];
+    if (read_all(completion_socket, frame, sizeof(frame)) < 0 || frame[5] != FRAME_COMPLETE) {
+        fprintf(stderr, "> Tamamlanma bildirimi alınamadı\n");
         exit(EXIT_FAILURE);
     }
+    printf("> All orders completed (%u delivered, %u cancelled)\n", get_u32(frame + FRAME_HEADER_SIZE + 4), get_u32(frame + FRAME_HEADER_SIZE + 8));
+    close(completion_socket);
+    completion_socket = -1;
+}
 
+// Connects to a status or completion port and sends FRAME_SUBSCRIBE, returns the socket
+int subscribe(const char* ipaddress, int port, pid_t pid) {
+    struct sockaddr_in server_address;
     server_address.sin_family = AF_INET;
-    server_address.sin_port = htons(port); // Sipariş tamamlanma durumlarını dinleyecek port
-    server_address.sin_addr.s_addr = inet_addr(ipaddress); // Kullanıcıdan alınan IP adresi
+    server_address.sin_port = htons(port);
+    server_address.sin_addr.s_addr = inet_addr(ipaddress);
 
-    if (connect(completion_socket, (struct sockaddr*)&server_address, sizeof(server_address)) < 0) {
+    int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (socket_fd < 0) {
+        perror("Soket oluşturulamadı");
+        return -1;
+    }
+    if (connect(socket_fd, (struct sockaddr*)&server_address, sizeof(server_address)) < 0) {
         perror("Sunucuya bağlanılamadı");
-        close(completion_socket);
-        exit(EXIT_FAILURE);
+        close(socket_fd);
+        return -1;
+    }
+
+    unsigned char frame[FRAME_HEADER_SIZE + SUBSCRIBE_PAYLOAD_SIZE];
+    size_t offset = put_frame_header(frame, FRAME_SUBSCRIBE, SUBSCRIBE_PAYLOAD_SIZE);
+    put_u32(frame + offset, (uint32_t)pid);
+    if (send_all(socket_fd, frame, sizeof(frame)) < 0) {
+        perror("send");
+        close(socket_fd);
+        return -1;
+    }
+    return socket_fd;
+}
+
+static int read_all(int socket, unsigned char* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = read(socket, data, length);
+        if (n <= 0) {
+            return -1;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+// Orders the server turned away come back after the time it asked for,
+// as one batch. Ends when the order connection is shut down.
+void* resend_retries(void* arg) {
+    (void)arg;
+    unsigned char* payload = malloc(FRAME_MAX_PAYLOAD);
+    unsigned char* frame = malloc(FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD);
+    if (payload == NULL || frame == NULL) {
+        free(payload);
+        free(frame);
+        return NULL;
     }
 
-    while (1) {
-        int valread = read(completion_socket, buffer, BUFFER_SIZE);
-        if (valread > 0) {
-            buffer[valread] = '\0';
-            printf("> %s\n", buffer);
-            if (strcmp(buffer, "All orders completed") == 0) {
-                // Mesajı aldıktan sonra istemciyi kapat
-                close(completion_socket);
-                break;
+    unsigned char header[FRAME_HEADER_SIZE];
+    while (read_all(client_socket, header, sizeof(header)) == 0) {
+        uint32_t length = get_u32(header);
+        if (header[4] != PROTOCOL_VERSION || length > FRAME_MAX_PAYLOAD || read_all(client_socket, payload, length) < 0) {
+            break;
+        }
+        if (header[5] != FRAME_RETRY_AFTER || length < RETRY_HEADER_SIZE) {
+            continue;
+        }
+        uint32_t retry_ms = get_u32(payload + 4);
+        uint32_t count = get_u32(payload + 8);
+        if (count > (length - RETRY_HEADER_SIZE) / RETRY_ENTRY_SIZE || count > BATCH_MAX_ORDERS) {
+            break;
+        }
+        printf("> Sunucu dolu: %u sipariş %u ms sonra tekrar gönderilecek\n", count, retry_ms);
+        usleep(retry_ms * 1000);
+
+        size_t offset = put_frame_header(frame, FRAME_ORDER_BATCH, BATCH_HEADER_SIZE + count * BATCH_ENTRY_SIZE);
+        put_u32(frame + offset, (uint32_t)getpid());
+        put_u32(frame + offset + 4, count);
+        offset += BATCH_HEADER_SIZE;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t order_id = get_u32(payload + RETRY_HEADER_SIZE + i * RETRY_ENTRY_SIZE);
+            if (order_id < 1 || order_id > (uint32_t)number_of_clients) {
+                continue;
             }
+            put_u32(frame + offset, order_id);
+            put_u32(frame + offset + 4, (uint32_t)order_x[order_id - 1]);
+            put_u32(frame + offset + 8, (uint32_t)order_y[order_id - 1]);
+            offset += BATCH_ENTRY_SIZE;
+        }
+        pthread_mutex_lock(&order_send_mutex);
+        int sent = send_all(client_socket, frame, offset);
+        pthread_mutex_unlock(&order_send_mutex);
+        if (sent < 0) {
+            break;
         }
     }
+
+    free(payload);
+    free(frame);
+    return NULL;
+}
+
+// Prints each FRAME_STATUS_BATCH entry until all our orders are delivered or cancelled
+void* follow_status(void* arg) {
+    (void)arg;
+    int delivered = 0;
+    static const char* state_names[] = { "verildi", "hazırlandı", "pişti", "yolda", "teslim edildi", "iptal edildi" };
+    unsigned char* frame = malloc(FRAME_MAX_PAYLOAD);
+    if (frame == NULL) {
+        return NULL;
+    }
+
+    unsigned char header[FRAME_HEADER_SIZE];
+    while (delivered < number_of_clients && read_all(status_socket, header, sizeof(header)) == 0) {
+        uint32_t length = get_u32(header);
+        if (header[4] != PROTOCOL_VERSION || length > FRAME_MAX_PAYLOAD ||
+            read_all(status_socket, frame, length) < 0) {
+            break;
+        }
+        if (header[5] != FRAME_STATUS_BATCH || length < STATUS_HEADER_SIZE) {
+            continue;
+        }
+
+        uint32_t count = get_u32(frame);
+        if (count > (length - STATUS_HEADER_SIZE) / STATUS_ENTRY_SIZE) {
+            break;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            const unsigned char* entry = frame + STATUS_HEADER_SIZE + i * STATUS_ENTRY_SIZE;
+            uint32_t state = get_u32(entry + 8);
+            printf("> Sipariş %u %s\n", get_u32(entry + 4), state <= STATE_CANCELLED ? state_names[state] : "?");
+            if (state == STATE_COMPLETED || state == STATE_CANCELLED) {
+                delivered++;
+            }
+        }
+    }
+
+    free(frame);
+    close(status_socket);
+    status_socket = -1;
+    return NULL;
 }
 
 void handle_signal(int signal) {
     if (signal == SIGINT || signal == SIGTERM) {
         printf("\n> ^C sinyali alındı.. siparişler iptal ediliyor..\n");
-        // Sipariş iptali işlemleri
-        for (int i = 0; i < number_of_clients; ++i) {
-            if (client_sockets[i] != -1) {
-                close(client_sockets[i]);
-            }
+        // Sipariş iptali işlemleri: sunucu bağlantı kopunca da iptal eder, ama açıkça söyle
+        if (client_socket != -1) {
+            unsigned char frame[FRAME_HEADER_SIZE + CANCEL_PAYLOAD_SIZE];
+            size_t offset = put_frame_header(frame, FRAME_CANCEL, CANCEL_PAYLOAD_SIZE);
+            put_u32(frame + offset, (uint32_t)getpid());
+            put_u32(frame + offset + 4, 0);
+            send(client_socket, frame, sizeof(frame), MSG_NOSIGNAL);
+            close(client_socket);
+        }
+        loadgen_cancel_all();
+        if (status_socket != -1) {
+            close(status_socket);
+        }
+        if (completion_socket != -1) {
+            close(completion_socket);
         }
-        free(client_sockets);
         exit(EXIT_SUCCESS);
     }
 }
+
+// send() may write less than asked on a busy socket
+int send_all(int socket, const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    while (length > 0) {
+        ssize_t sent = send(socket, bytes, length, 0);
+        if (sent < 0) {
+            return -1;
+        }
+        bytes += sent;
+        length -= (size_t)sent;
+    }
+    return 0;
+}
@@ -0,0 +1,403 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cookpool.h"
+#include "deadline.h"
+
+#define PARK_TIMEOUT_MS 100 // Parked cooks look around again even without a signal
+
+// SCHEDULE_EDF: every cook keeps a heap of its orders, smallest key on top.
+// Deadlines are global, so a cook takes the earliest top of all the heaps,
+// its own or another cook's, and only locks the heap it takes from.
+typedef struct {
+    double key;
+    long seq; // Equal keys leave in submit order
+    int slot;
+} DueOrder;
+
+typedef struct {
+    _Alignas(COOKPOOL_CACHE_LINE) pthread_mutex_t mutex;
+    DueOrder* items;
+    int count;
+    int capacity;
+    _Atomic double top_key; // items[0], read without the lock to pick a heap
+    atomic_long top_seq;
+    atomic_int size;
+} DueHeap;
+
+typedef struct {
+    WorkDeque deque;
+    CookInbox inbox;
+    DueHeap due;
+    _Alignas(COOKPOOL_CACHE_LINE) long local;
+    long stolen;
+} CookSlot;
+
+static CookSlot* slots = NULL;
+static int cook_count = 0;
+static int placement_mode = COOKPOOL_ROUND_ROBIN;
+static int schedule_mode = SCHEDULE_FIFO;
+static atomic_uint next_cook = 0;
+static atomic_long due_seq = 0;
+
+// Idle cooks park here; producers only take the lock when someone is parked
+static atomic_int sleepers = 0;
+static pthread_mutex_t park_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t park_cond = PTHREAD_COND_INITIALIZER;
+
+static DequeArray* deque_array_new(long size) {
+    DequeArray* array = malloc(sizeof(DequeArray) + size * sizeof(atomic_int));
+    if (array == NULL) {
+        perror("Failed to allocate work deque");
+        exit(EXIT_FAILURE);
+    }
+    array->size = size;
+    array->retired = NULL;
+    return array;
+}
+
+int deque_init(WorkDeque* deque) {
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    atomic_init(&deque->array, deque_array_new(COOKPOOL_DEQUE_CAPACITY));
+    return 0;
+}
+
+// Owner only
+void deque_push(WorkDeque* deque, int item) {
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    DequeArray* array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+    if (b - t > array->size - 1) {
+        DequeArray* bigger = deque_array_new(array->size * 2);
+        for (long i = t; i < b; ++i) {
+            atomic_store_explicit(&bigger->items[i & (bigger->size - 1)],
+                                  atomic_load_explicit(&array->items[i & (array->size - 1)], memory_order_relaxed),
+                                  memory_order_relaxed);
+        }
+        bigger->retired = array;
+        atomic_store_explicit(&deque->array, bigger, memory_order_release);
+        array = bigger;
+    }
+    atomic_store_explicit(&array->items[b & (array->size - 1)], item, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+}
+
+// Any thread, the owner included
+int deque_steal(WorkDeque* deque) {
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (t >= b) {
+        return COOKPOOL_EMPTY;
+    }
+    DequeArray* array = atomic_load_explicit(&deque->array, memory_order_acquire);
+    int item = atomic_load_explicit(&array->items[t & (array->size - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        return COOKPOOL_ABORT;
+    }
+    return item;
+}
+
+void deque_destroy(WorkDeque* deque) {
+    DequeArray* array = atomic_load(&deque->array);
+    while (array != NULL) {
+        DequeArray* retired = array->retired;
+        free(array);
+        array = retired;
+    }
+    atomic_store(&deque->array, NULL);
+}
+
+// Moves everything in the inbox to the bottom of this cook's deque
+static int drain_inbox(CookInbox* inbox, WorkDeque* deque, int blocking) {
+    if (blocking) {
+        pthread_mutex_lock(&inbox->mutex);
+    } else if (pthread_mutex_trylock(&inbox->mutex) != 0) {
+        return 0;
+    }
+    int count = inbox->count;
+    for (int i = 0; i < count; ++i) {
+        deque_push(deque, inbox->items[i]);
+    }
+    inbox->count = 0;
+    pthread_mutex_unlock(&inbox->mutex);
+    return count;
+}
+
+static int take_local(CookSlot* self) {
+    int item;
+    do {
+        item = deque_steal(&self->deque);
+    } while (item == COOKPOOL_ABORT);
+    return item;
+}
+
+// Own work first, then the other cooks' deques, then their inboxes
+static int find_work(int cook) {
+    CookSlot* self = &slots[cook];
+    drain_inbox(&self->inbox, &self->deque, 1);
+    int item = take_local(self);
+    if (item >= 0) {
+        self->local++;
+        return item;
+    }
+
+    for (int i = 1; i < cook_count; ++i) {
+        CookSlot* victim = &slots[(cook + i) % cook_count];
+        do {
+            item = deque_steal(&victim->deque);
+        } while (item == COOKPOOL_ABORT);
+        if (item < 0 && drain_inbox(&victim->inbox, &self->deque, 0) > 0) {
+            item = take_local(self); // Its queued orders are ours now, others can steal them back
+        }
+        if (item >= 0) {
+            self->stolen++;
+            return item;
+        }
+    }
+    return COOKPOOL_EMPTY;
+}
+
+static int due_before(const DueOrder* a, const DueOrder* b) {
+    return a->key < b->key || (a->key == b->key && a->seq < b->seq);
+}
+
+// Caller holds heap->mutex. size is stored last, so a cook that sees it
+// also sees the key and seq of the new top.
+static void due_publish(DueHeap* heap) {
+    if (heap->count > 0) {
+        atomic_store_explicit(&heap->top_key, heap->items[0].key, memory_order_relaxed);
+        atomic_store_explicit(&heap->top_seq, heap->items[0].seq, memory_order_relaxed);
+    }
+    atomic_store(&heap->size, heap->count);
+}
+
+static void due_push(DueHeap* heap, int slot, double key) {
+    DueOrder order = { key, atomic_fetch_add_explicit(&due_seq, 1, memory_order_relaxed), slot };
+    pthread_mutex_lock(&heap->mutex);
+    if (heap->count == heap->capacity) {
+        int capacity = heap->capacity == 0 ? COOKPOOL_DEQUE_CAPACITY : heap->capacity * 2;
+        DueOrder* grown = realloc(heap->items, capacity * sizeof(DueOrder));
+        if (grown == NULL) {
+            perror("Failed to grow deadline heap");
+            exit(EXIT_FAILURE);
+        }
+        heap->items = grown;
+        heap->capacity = capacity;
+    }
+    int child = heap->count++;
+    while (child > 0) {
+        int parent = (child - 1) / 2;
+        if (!due_before(&order, &heap->items[parent])) {
+            break;
+        }
+        heap->items[child] = heap->items[parent];
+        child = parent;
+    }
+    heap->items[child] = order;
+    due_publish(heap);
+    pthread_mutex_unlock(&heap->mutex);
+}
+
+// Caller holds heap->mutex and the heap is not empty
+static int due_pop(DueHeap* heap) {
+    int slot = heap->items[0].slot;
+    DueOrder last = heap->items[--heap->count];
+    int parent = 0;
+    while (1) {
+        int child = 2 * parent + 1;
+        if (child >= heap->count) {
+            break;
+        }
+        if (child + 1 < heap->count && due_before(&heap->items[child + 1], &heap->items[child])) {
+            child++;
+        }
+        if (!due_before(&heap->items[child], &last)) {
+            break;
+        }
+        heap->items[parent] = heap->items[child];
+        parent = child;
+    }
+    heap->items[parent] = last;
+    due_publish(heap);
+    return slot;
+}
+
+// Earliest top over every cook's heap. The tops are read without locks, so
+// the pick can be stale; the chosen heap is popped under its own lock, and
+// if another cook emptied it meanwhile we look again.
+static int find_due(int cook) {
+    while (1) {
+        int best = -1;
+        DueOrder top = { 0.0, 0, 0 };
+        for (int i = 0; i < cook_count; ++i) {
+            DueHeap* heap = &slots[(cook + i) % cook_count].due;
+            if (atomic_load(&heap->size) == 0) {
+                continue;
+            }
+            DueOrder candidate = { atomic_load_explicit(&heap->top_key, memory_order_relaxed),
+                                   atomic_load_explicit(&heap->top_seq, memory_order_relaxed), 0 };
+            if (best < 0 || due_before(&candidate, &top)) {
+                best = (cook + i) % cook_count;
+                top = candidate;
+            }
+        }
+        if (best < 0) {
+            return COOKPOOL_EMPTY;
+        }
+
+        DueHeap* heap = &slots[best].due;
+        pthread_mutex_lock(&heap->mutex);
+        if (heap->count == 0) {
+            pthread_mutex_unlock(&heap->mutex);
+            continue;
+        }
+        int slot = due_pop(heap);
+        pthread_mutex_unlock(&heap->mutex);
+        if (best == cook) {
+            slots[cook].local++;
+        } else {
+            slots[cook].stolen++;
+        }
+        return slot;
+    }
+}
+
+static int find_next(int cook) {
+    return schedule_mode == SCHEDULE_EDF ? find_due(cook) : find_work(cook);
+}
+
+int cook_pool_init(int cooks, int placement, int schedule) {
+    if (cooks < 1 || cooks > COOKPOOL_MAX_COOKS) {
+        fprintf(stderr, "Cook pool supports 1 to %d cooks\n", COOKPOOL_MAX_COOKS);
+        return -1;
+    }
+    slots = aligned_alloc(COOKPOOL_CACHE_LINE, cooks * sizeof(CookSlot));
+    if (slots == NULL) {
+        perror("Failed to allocate cook pool");
+        return -1;
+    }
+    memset(slots, 0, cooks * sizeof(CookSlot));
+    for (int i = 0; i < cooks; ++i) {
+        deque_init(&slots[i].deque);
+        pthread_mutex_init(&slots[i].inbox.mutex, NULL);
+        pthread_mutex_init(&slots[i].due.mutex, NULL);
+    }
+    cook_count = cooks;
+    placement_mode = placement;
+    schedule_mode = schedule;
+    atomic_store(&next_cook, 0);
+    atomic_store(&due_seq, 0);
+    return 0;
+}
+
+static void cook_inbox_push(CookInbox* inbox, int slot) {
+    pthread_mutex_lock(&inbox->mutex);
+    if (inbox->count == inbox->capacity) {
+        int capacity = inbox->capacity == 0 ? COOKPOOL_DEQUE_CAPACITY : inbox->capacity * 2;
+        int* items = realloc(inbox->items, capacity * sizeof(int));
+        if (items == NULL) {
+            perror("Failed to grow cook inbox");
+            exit(EXIT_FAILURE);
+        }
+        inbox->items = items;
+        inbox->capacity = capacity;
+    }
+    inbox->items[inbox->count++] = slot;
+    pthread_mutex_unlock(&inbox->mutex);
+}
+
+void cook_pool_submit(int slot, unsigned int locality, double key) {
+    unsigned int cook = placement_mode == COOKPOOL_LOCALITY ? locality * 2654435761u
+                                                            : atomic_fetch_add_explicit(&next_cook, 1, memory_order_relaxed);
+    if (schedule_mode == SCHEDULE_EDF) {
+        due_push(&slots[cook % cook_count].due, slot, key);
+    } else {
+        cook_inbox_push(&slots[cook % cook_count].inbox, slot);
+    }
+
+    // The owner may be busy; wake an idle cook to steal it
+    if (atomic_load(&sleepers) > 0) {
+        pthread_mutex_lock(&park_mutex);
+        pthread_cond_signal(&park_cond);
+        pthread_mutex_unlock(&park_mutex);
+    }
+}
+
+
+int cook_pool_take(int cook) {
+    while (1) {
+        int item = find_next(cook);
+        if (item >= 0) {
+            return item;
+        }
+
+        pthread_mutex_lock(&park_mutex);
+        atomic_fetch_add(&sleepers, 1);
+        item = find_next(cook); // A submit that missed our sleepers count is seen here
+        if (item < 0) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += PARK_TIMEOUT_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&park_cond, &park_mutex, &deadline);
+        }
+        atomic_fetch_sub(&sleepers, 1);
+        pthread_mutex_unlock(&park_mutex);
+        if (item >= 0) {
+            return item;
+        }
+    }
+}
+
+int cook_pool_try_take(int cook) {
+    return find_next(cook);
+}
+
+// Counters are written by their own cook only, so this is a close estimate
+void cook_pool_get_stats(CookPoolStats* stats) {
+    stats->local = 0;
+    stats->stolen = 0;
+    for (int i = 0; i < cook_count; ++i) {
+        stats->local += slots[i].local;
+        stats->stolen += slots[i].stolen;
+    }
+}
+
+void cook_pool_print_stats(void) {
+    CookPoolStats stats;
+    cook_pool_get_stats(&stats);
+    long total = stats.local + stats.stolen;
+    printf("> Cook pool (%s%s): %ld orders, %ld stolen (%.1f%%)\n", schedule_mode == SCHEDULE_EDF ? "edf, " : "",
+           placement_mode == COOKPOOL_LOCALITY ? "locality" : "round-robin", total, stats.stolen,
+           total > 0 ? 100.0 * stats.stolen / total : 0.0);
+}
+
+int cook_pool_parse_placement(const char* name) {
+    if (strcmp(name, "rr") == 0) {
+        return COOKPOOL_ROUND_ROBIN;
+    }
+    if (strcmp(name, "client") == 0) {
+        return COOKPOOL_LOCALITY;
+    }
+    return -1;
+}
+
+void cook_pool_destroy(void) {
+    for (int i = 0; i < cook_count; ++i) {
+        deque_destroy(&slots[i].deque);
+        pthread_mutex_destroy(&slots[i].inbox.mutex);
+        free(slots[i].inbox.items);
+        pthread_mutex_destroy(&slots[i].due.mutex);
+        free(slots[i].due.items);
+    }
+    free(slots);
+    slots = NULL;
+    cook_count = 0;
+}
@@ -0,0 +1,61 @@
+#ifndef COOKPOOL_H
+#define COOKPOOL_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define COOKPOOL_CACHE_LINE 64
+#define COOKPOOL_MAX_COOKS 64
+#define COOKPOOL_DEQUE_CAPACITY 64 // Initial slots, the deque doubles when full
+
+// Where a new order goes
+#define COOKPOOL_ROUND_ROBIN 0 // Next cook in turn
+#define COOKPOOL_LOCALITY 1    // Same cook for every order of a client
+
+#define COOKPOOL_EMPTY -1
+#define COOKPOOL_ABORT -2 // Lost a race with another thief, try again
+
+typedef struct DequeArray {
+    long size; // Power of two
+    struct DequeArray* retired; // Older arrays, thieves may still read them
+    atomic_int items[];
+} DequeArray;
+
+// Chase-Lev work-stealing deque of order slots. Only the owning cook
+// pushes at the bottom; anyone takes from the top with a CAS, the owner
+// included, so a cook's own orders are still cooked oldest first.
+typedef struct {
+    _Alignas(COOKPOOL_CACHE_LINE) atomic_long top;
+    _Alignas(COOKPOOL_CACHE_LINE) atomic_long bottom;
+    _Atomic(DequeArray*) array;
+} WorkDeque;
+
+// Orders handed to a cook by the event loops. Its own lock, so producers
+// only ever contend with this cook and with a thief emptying it.
+typedef struct {
+    _Alignas(COOKPOOL_CACHE_LINE) pthread_mutex_t mutex;
+    int* items;
+    int count;
+    int capacity;
+} CookInbox;
+
+typedef struct {
+    long local;  // Taken from the cook's own deque
+    long stolen; // Taken from another cook's deque or inbox
+} CookPoolStats;
+
+int deque_init(WorkDeque* deque);
+void deque_push(WorkDeque* deque, int item);
+int deque_steal(WorkDeque* deque);
+void deque_destroy(WorkDeque* deque);
+
+int cook_pool_init(int cooks, int placement, int schedule); // schedule: SCHEDULE_FIFO | SCHEDULE_EDF
+void cook_pool_submit(int slot, unsigned int locality, double key); // locality picks the cook in COOKPOOL_LOCALITY, key orders SCHEDULE_EDF
+int cook_pool_take(int cook); // Blocks until there is an order for this cook
+int cook_pool_try_take(int cook); // Same search, COOKPOOL_EMPTY instead of parking
+void cook_pool_get_stats(CookPoolStats* stats);
+void cook_pool_print_stats(void);
+int cook_pool_parse_placement(const char* name);
+void cook_pool_destroy(void);
+
+#endif
@@ -0,0 +1,215 @@
+// Cook dispatch benchmark: a producer hands out orders and 1 to 64 cooks
+// take them through the work-stealing cook pool, the pool's EDF heaps, the
+// original global mutex + condition variable queue, and the shared lock-free
+// ring (ring.c) the pool replaced. Each order costs a short spin so dispatch
+// overhead shows up.
+//   ./cookpool_bench [orders] [work_ns] [producers]
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include "cookpool.h"
+#include "ring.h"
+#include "deadline.h"
+
+#define BENCH_MAX_PRODUCERS 16
+#define BENCH_LEGACY -1 // run() placements besides COOKPOOL_*
+#define BENCH_RING -2
+#define BENCH_EDF -3 // Pool with SCHEDULE_EDF, round-robin heaps
+
+static int order_count = 200000;
+static int work_ns = 1000;
+static int producer_count = 2;
+static atomic_long done = 0;
+static volatile double sink = 0.0;
+
+static pthread_mutex_t legacy_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t legacy_cond = PTHREAD_COND_INITIALIZER;
+static int* legacy_queue = NULL;
+static long legacy_head = 0;
+static long legacy_tail = 0;
+static OrderRing ring;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void cook_order(int slot) {
+    double start = now_seconds();
+    double x = slot;
+    while ((now_seconds() - start) * 1e9 < work_ns) {
+        x = x * 1.0000001 + 1.0;
+    }
+    sink = x;
+}
+
+static void* pool_producer(void* arg) {
+    long id = (long)arg;
+    for (int i = id; i < order_count; i += producer_count) {
+        cook_pool_submit(i, (unsigned int)i / 64, (double)i); // Clients of 64 orders, due in submit order
+    }
+    return NULL;
+}
+
+static void* pool_cook(void* arg) {
+    int id = (int)(long)arg;
+    while (1) {
+        int slot = cook_pool_take(id);
+        if (slot == order_count) {
+            return NULL; // Stop marker, one per cook
+        }
+        cook_order(slot);
+        atomic_fetch_add(&done, 1);
+    }
+}
+
+static void* legacy_producer(void* arg) {
+    long id = (long)arg;
+    for (int i = id; i < order_count; i += producer_count) {
+        pthread_mutex_lock(&legacy_mutex);
+        legacy_queue[legacy_tail++] = i;
+        pthread_cond_signal(&legacy_cond);
+        pthread_mutex_unlock(&legacy_mutex);
+    }
+    return NULL;
+}
+
+static void* legacy_cook(void* arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&legacy_mutex);
+        while (legacy_head == legacy_tail) {
+            pthread_cond_wait(&legacy_cond, &legacy_mutex);
+        }
+        int slot = legacy_queue[legacy_head++];
+        pthread_mutex_unlock(&legacy_mutex);
+        if (slot == order_count) {
+            return NULL;
+        }
+        cook_order(slot);
+        atomic_fetch_add(&done, 1);
+    }
+}
+
+// Every cook and producer on one ring, as client_queues were
+static void* ring_producer(void* arg) {
+    long id = (long)arg;
+    Order order = { 0 };
+    for (int i = id; i < order_count; i += producer_count) {
+        order.order_id = i;
+        ring_enqueue(&ring, &order);
+    }
+    return NULL;
+}
+
+static void* ring_cook(void* arg) {
+    (void)arg;
+    while (1) {
+        Order order = ring_dequeue(&ring);
+        if (order.order_id == order_count) {
+            return NULL;
+        }
+        cook_order(order.order_id);
+        atomic_fetch_add(&done, 1);
+    }
+}
+
+static double run(int cooks, int placement) {
+    pthread_t producers[BENCH_MAX_PRODUCERS];
+    pthread_t threads[COOKPOOL_MAX_COOKS];
+    atomic_store(&done, 0);
+    void* (*cook)(void*) = pool_cook;
+    void* (*producer)(void*) = pool_producer;
+    int pool = placement >= 0 || placement == BENCH_EDF;
+    if (placement >= 0) {
+        cook_pool_init(cooks, placement, SCHEDULE_FIFO);
+    } else if (placement == BENCH_EDF) {
+        cook_pool_init(cooks, COOKPOOL_ROUND_ROBIN, SCHEDULE_EDF);
+    } else if (placement == BENCH_LEGACY) {
+        legacy_head = legacy_tail = 0;
+        cook = legacy_cook;
+        producer = legacy_producer;
+    } else {
+        cook = ring_cook;
+        producer = ring_producer;
+    }
+
+    double start = now_seconds();
+    for (long i = 0; i < cooks; ++i) {
+        pthread_create(&threads[i], NULL, cook, (void*)i);
+    }
+    for (long i = 0; i < producer_count; ++i) {
+        pthread_create(&producers[i], NULL, producer, (void*)i);
+    }
+    for (int i = 0; i < producer_count; ++i) {
+        pthread_join(producers[i], NULL);
+    }
+    while (atomic_load(&done) < order_count) {
+        struct timespec pause = { 0, 100000 };
+        nanosleep(&pause, NULL);
+    }
+    double elapsed = now_seconds() - start;
+
+    for (int i = 0; i < cooks; ++i) {
+        if (pool) {
+            cook_pool_submit(order_count, (unsigned int)i, (double)order_count);
+        } else if (placement == BENCH_RING) {
+            Order stop = { 0 };
+            stop.order_id = order_count;
+            ring_enqueue(&ring, &stop);
+        } else {
+            pthread_mutex_lock(&legacy_mutex);
+            legacy_queue[legacy_tail++] = order_count;
+            pthread_cond_broadcast(&legacy_cond);
+            pthread_mutex_unlock(&legacy_mutex);
+        }
+    }
+    for (int i = 0; i < cooks; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    if (pool) {
+        if (cooks == COOKPOOL_MAX_COOKS) {
+            cook_pool_print_stats();
+        }
+        cook_pool_destroy();
+    }
+    return order_count / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        order_count = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        work_ns = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        producer_count = atoi(argv[3]);
+    }
+    if (order_count < 1 || producer_count < 1 || producer_count > BENCH_MAX_PRODUCERS) {
+        fprintf(stderr, "Usage: %s [orders] [work_ns] [producers 1-%d]\n", argv[0], BENCH_MAX_PRODUCERS);
+        return 1;
+    }
+    legacy_queue = malloc((order_count + COOKPOOL_MAX_COOKS) * sizeof(int));
+    if (legacy_queue == NULL || ring_init(&ring, RING_CAPACITY) < 0) {
+        perror("malloc");
+        return 1;
+    }
+
+    printf("%d orders, %d ns each, %d producers\n", order_count, work_ns, producer_count);
+    printf("%5s | %12s | %12s | %12s | %12s | %12s\n", "cooks", "legacy/s", "ring/s", "rr/s", "client/s", "edf/s");
+    for (int cooks = 1; cooks <= COOKPOOL_MAX_COOKS; cooks *= 2) {
+        double legacy = run(cooks, BENCH_LEGACY);
+        double shared_ring = run(cooks, BENCH_RING);
+        double round_robin = run(cooks, COOKPOOL_ROUND_ROBIN);
+        double locality = run(cooks, COOKPOOL_LOCALITY);
+        double edf = run(cooks, BENCH_EDF);
+        printf("%5d | %12.0f | %12.0f | %12.0f | %12.0f | %12.0f\n", cooks, legacy, shared_ring, round_robin, locality, edf);
+    }
+    ring_destroy(&ring);
+    free(legacy_queue);
+    return 0;
+}
@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "matrix.h"
+#include "pinv.h"
+#include "cooktime.h"
+
+// A measurement waiting for the compute pool, lives on the caller's stack
+typedef struct CookTimeJob {
+    int rows;
+    int cols;
+    double result;
+    int done;
+    struct CookTimeJob* next;
+} CookTimeJob;
+
+typedef struct {
+    int rows;
+    int cols;
+    double seconds;
+} CookTimeEntry;
+
+static int provider_mode = COOKTIME_LIVE;
+static int pinv_method = PINV_QR;
+static double cached_time = 0.0;
+
+static CookTimeEntry size_cache[COOKTIME_MAX_SIZES];
+static int size_cache_count = 0;
+static pthread_mutex_t size_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t pool_threads[COOKTIME_MAX_THREADS];
+static int pool_thread_count = 0;
+static CookTimeJob* job_head = NULL;
+static CookTimeJob* job_tail = NULL;
+static int pool_stopping = 0;
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+
+static CookTimeStats stats;
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Pseudo-inverse of a random rows x cols matrix, repeated and timed
+double cooktime_measure(int rows, int cols) {
+    CMatrix a, inverse;
+    PinvWorkspace ws;
+
+    if (cmatrix_alloc(&a, rows, cols) < 0 || cmatrix_alloc(&inverse, cols, rows) < 0 ||
+        pinv_workspace_init(&ws, rows, cols, pinv_method) < 0) {
+        exit(EXIT_FAILURE);
+    }
+    cmatrix_random(&a);
+
+    struct timeval start_time, end_time;
+    gettimeofday(&start_time, NULL);
+    for (int k = 0; k < COOKTIME_REPEATS; k++) {
+        pinv_compute(&a, &inverse, &ws);
+    }
+    gettimeofday(&end_time, NULL);
+
+    cmatrix_free(&a);
+    cmatrix_free(&inverse);
+    pinv_workspace_free(&ws);
+
+    double seconds = (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_usec - start_time.tv_usec) / 1000000.0;
+
+    pthread_mutex_lock(&stats_mutex);
+    stats.computations++;
+    stats.compute_total += seconds;
+    pthread_mutex_unlock(&stats_mutex);
+    return seconds;
+}
+
+static void* pool_function(void* arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&pool_mutex);
+        while (job_head == NULL && !pool_stopping) {
+            pthread_cond_wait(&job_ready, &pool_mutex);
+        }
+        if (job_head == NULL) {
+            pthread_mutex_unlock(&pool_mutex);
+            break;
+        }
+        CookTimeJob* job = job_head;
+        job_head = job->next;
+        if (job_head == NULL) {
+            job_tail = NULL;
+        }
+        pthread_mutex_unlock(&pool_mutex);
+
+        double result = cooktime_measure(job->rows, job->cols);
+
+        pthread_mutex_lock(&pool_mutex);
+        job->result = result;
+        job->done = 1;
+        pthread_cond_broadcast(&job_done);
+        pthread_mutex_unlock(&pool_mutex);
+    }
+    return NULL;
+}
+
+static double measure_on_pool(int rows, int cols) {
+    CookTimeJob job = { rows, cols, 0.0, 0, NULL };
+
+    pthread_mutex_lock(&pool_mutex);
+    if (job_tail == NULL) {
+        job_head = job_tail = &job;
+    } else {
+        job_tail->next = &job;
+        job_tail = &job;
+    }
+    pthread_cond_signal(&job_ready);
+    while (!job.done) {
+        pthread_cond_wait(&job_done, &pool_mutex);
+    }
+    pthread_mutex_unlock(&pool_mutex);
+    return job.result;
+}
+
+static double lookup_size(int rows, int cols) {
+    pthread_mutex_lock(&size_cache_mutex);
+    for (int i = 0; i < size_cache_count; ++i) {
+        if (size_cache[i].rows == rows && size_cache[i].cols == cols) {
+            double seconds = size_cache[i].seconds;
+            pthread_mutex_unlock(&size_cache_mutex);
+            return seconds;
+        }
+    }
+    pthread_mutex_unlock(&size_cache_mutex);
+
+    // Two cooks may race on a new size; both measure, the first one wins
+    double seconds = cooktime_measure(rows, cols);
+
+    pthread_mutex_lock(&size_cache_mutex);
+    for (int i = 0; i < size_cache_count; ++i) {
+        if (size_cache[i].rows == rows && size_cache[i].cols == cols) {
+            seconds = size_cache[i].seconds;
+            pthread_mutex_unlock(&size_cache_mutex);
+            return seconds;
+        }
+    }
+    if (size_cache_count < COOKTIME_MAX_SIZES) {
+        size_cache[size_cache_count].rows = rows;
+        size_cache[size_cache_count].cols = cols;
+        size_cache[size_cache_count].seconds = seconds;
+        size_cache_count++;
+    }
+    pthread_mutex_unlock(&size_cache_mutex);
+    return seconds;
+}
+
+int cooktime_init(int mode, int rows, int cols, int method, int pool_size) {
+    provider_mode = mode;
+    pinv_method = method;
+    memset(&stats, 0, sizeof(stats));
+
+    if (mode == COOKTIME_CACHED) {
+        cached_time = cooktime_measure(rows, cols);
+    } else if (mode == COOKTIME_POOL) {
+        if (pool_size < 1) {
+            pool_size = 1;
+        }
+        if (pool_size > COOKTIME_MAX_THREADS) {
+            pool_size = COOKTIME_MAX_THREADS;
+        }
+        for (int i = 0; i < pool_size; ++i) {
+            if (pthread_create(&pool_threads[i], NULL, pool_function, NULL) != 0) {
+                perror("pthread_create");
+                return -1;
+            }
+            pool_thread_count++;
+        }
+    }
+    return 0;
+}
+
+// Hazırlama süresi (saniye)
+double cooktime_get(int rows, int cols) {
+    pthread_mutex_lock(&stats_mutex);
+    stats.lookups++;
+    pthread_mutex_unlock(&stats_mutex);
+
+    switch (provider_mode) {
+        case COOKTIME_CACHED:
+            return cached_time;
+        case COOKTIME_PER_SIZE:
+            return lookup_size(rows, cols);
+        case COOKTIME_POOL:
+            return measure_on_pool(rows, cols);
+        default:
+            return cooktime_measure(rows, cols);
+    }
+}
+
+void cooktime_get_stats(CookTimeStats* out) {
+    pthread_mutex_lock(&stats_mutex);
+    *out = stats;
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+int cooktime_parse_mode(const char* name) {
+    if (strcmp(name, "live") == 0) {
+        return COOKTIME_LIVE;
+    }
+    if (strcmp(name, "cached") == 0) {
+        return COOKTIME_CACHED;
+    }
+    if (strcmp(name, "size") == 0) {
+        return COOKTIME_PER_SIZE;
+    }
+    if (strcmp(name, "pool") == 0) {
+        return COOKTIME_POOL;
+    }
+    return -1;
+}
+
+const char* cooktime_mode_name(int mode) {
+    switch (mode) {
+        case COOKTIME_LIVE: return "live";
+        case COOKTIME_CACHED: return "cached";
+        case COOKTIME_PER_SIZE: return "size";
+        case COOKTIME_POOL: return "pool";
+        default: return "?";
+    }
+}
+
+void cooktime_shutdown(void) {
+    pthread_mutex_lock(&pool_mutex);
+    pool_stopping = 1;
+    pthread_cond_broadcast(&job_ready);
+    pthread_mutex_unlock(&pool_mutex);
+    for (int i = 0; i < pool_thread_count; ++i) {
+        pthread_join(pool_threads[i], NULL);
+    }
+    pool_thread_count = 0;
+}
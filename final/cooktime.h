@@ -0,0 +1,28 @@
+#ifndef COOKTIME_H
+#define COOKTIME_H
+
+// Cook time provider modes
+#define COOKTIME_LIVE 0     // Every order measures its own pseudo-inverses (original)
+#define COOKTIME_CACHED 1   // Measure once at startup, reuse for every order
+#define COOKTIME_PER_SIZE 2 // Measure once per distinct matrix size
+#define COOKTIME_POOL 3     // Live measurement, run on a dedicated compute pool
+
+#define COOKTIME_REPEATS 10     // Pseudo-inverses per measurement
+#define COOKTIME_MAX_SIZES 64   // Entries in the per-size cache
+#define COOKTIME_MAX_THREADS 16 // Compute pool limit
+
+typedef struct {
+    long lookups;         // cooktime_get calls
+    long computations;    // Measurements actually run
+    double compute_total; // Seconds spent measuring
+} CookTimeStats;
+
+int cooktime_init(int mode, int rows, int cols, int method, int pool_size);
+double cooktime_get(int rows, int cols);
+double cooktime_measure(int rows, int cols);
+void cooktime_get_stats(CookTimeStats* stats);
+int cooktime_parse_mode(const char* name);
+const char* cooktime_mode_name(int mode);
+void cooktime_shutdown(void);
+
+#endif
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <string.h>
+#include "route.h"
+#include "deadline.h"
+
+// Every order is promised by a deadline: the client's, or one computed from
+// the distance to the shop. What the kitchen has to meet is the deadline
+// minus the ride there; EDF orders cooks and the oven by that. A key never
+// lies more than aging_limit after placement, so an order with a far
+// deadline is not passed over forever by a stream of urgent ones.
+
+int deadline_parse_mode(const char* name) {
+    if (strcmp(name, "fifo") == 0) {
+        return SCHEDULE_FIFO;
+    }
+    if (strcmp(name, "edf") == 0) {
+        return SCHEDULE_EDF;
+    }
+    return -1;
+}
+
+const char* deadline_mode_name(int mode) {
+    return mode == SCHEDULE_EDF ? "edf" : "fifo";
+}
+
+double deadline_travel(int x, int y, int p, int q, int speed) {
+    RoutePoint shop = { p / 2, q / 2 };
+    RoutePoint customer = { x, y };
+    return route_distance(shop, customer) / speed;
+}
+
+double deadline_promise(const DeadlineConfig* config, double travel) {
+    return config->kitchen_allowance + DEADLINE_TRAVEL_FACTOR * travel;
+}
+
+double deadline_key(const DeadlineConfig* config, double placed_at, double deadline, double travel) {
+    double due = deadline - travel;
+    double aged = placed_at + config->aging_limit;
+    return due < aged ? due : aged;
+}
+
+void deadline_record(DeadlineStats* stats, double delivered_at, double deadline) {
+    stats->delivered++;
+    if (delivered_at <= deadline) {
+        stats->on_time++;
+        return;
+    }
+    double late = delivered_at - deadline;
+    stats->lateness_total += late;
+    if (late > stats->lateness_max) {
+        stats->lateness_max = late;
+    }
+}
+
+void deadline_print(const DeadlineConfig* config, const DeadlineStats* stats) {
+    long late = stats->delivered - stats->on_time;
+    printf("> Deadlines (%s): %ld of %ld delivered on time (%.1f%%), late by avg %.3f s max %.3f s, %ld waited past the aging limit\n",
+           deadline_mode_name(config->mode), stats->on_time, stats->delivered,
+           stats->delivered > 0 ? 100.0 * stats->on_time / stats->delivered : 0.0,
+           late > 0 ? stats->lateness_total / late : 0.0, stats->lateness_max, stats->aged);
+}
@@ -0,0 +1,34 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+// Which order a free cook (and a free oven slot) takes next
+#define SCHEDULE_FIFO 0 // Oldest first, work-stealing cook pool (original)
+#define SCHEDULE_EDF 1  // Earliest kitchen deadline first, with aging
+
+#define DEADLINE_KITCHEN_SLACK 8.0  // Computed promise: kitchen time times this, plus travel
+#define DEADLINE_TRAVEL_FACTOR 3.0  // The courier visits other stops of the tour on the way
+#define DEADLINE_AGING_FACTOR 4.0   // Aging limit in kitchen allowances
+
+typedef struct {
+    int mode;
+    double kitchen_allowance; // Seconds a computed promise leaves for queue, prepare and bake
+    double aging_limit;       // Seconds after placement at which any order counts as due
+} DeadlineConfig;
+
+typedef struct {
+    long delivered;
+    long on_time;
+    long aged;             // Waited for a cook past the aging limit
+    double lateness_total; // Seconds, late orders only
+    double lateness_max;
+} DeadlineStats;
+
+int deadline_parse_mode(const char* name);
+const char* deadline_mode_name(int mode);
+double deadline_travel(int x, int y, int p, int q, int speed); // Shop at the centre of the map
+double deadline_promise(const DeadlineConfig* config, double travel);
+double deadline_key(const DeadlineConfig* config, double placed_at, double deadline, double travel);
+void deadline_record(DeadlineStats* stats, double delivered_at, double deadline);
+void deadline_print(const DeadlineConfig* config, const DeadlineStats* stats);
+
+#endif
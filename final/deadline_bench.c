@@ -0,0 +1,83 @@
+// Deadline scheduling benchmark: the discrete-event shop at a sweep of
+// loads around kitchen capacity, each load once with FIFO cooks and oven
+// and once with EDF, same seed and same cook time. Prints the fraction of
+// orders delivered by their promise: first with computed promises only,
+// then with a share of express orders whose client promise is tighter.
+// The map and courier speed are chosen so the ride to the edge takes about
+// one kitchen allowance, which is what makes computed promises differ.
+//   ./deadline_bench [orders] [cooks] [expressShare]
+#include <stdio.h>
+#include <stdlib.h>
+#include "pideshop.h"
+#include "pinv.h"
+#include "cooktime.h"
+#include "deadline.h"
+#include "kitchen.h"
+#include "cookpool.h"
+#include "sim.h"
+
+#define BENCH_MAP 20
+#define BENCH_COURIERS 64 // Enough that couriers are never the bottleneck
+#define BENCH_SEED 12345
+#define EXPRESS_PROMISE 1.5 // Kitchen allowances, ride included
+
+static const double loads[] = { 0.7, 0.8, 0.9, 0.95, 1.0, 1.05, 1.1, 1.2 };
+
+static double on_time(const SimResult* result) {
+    return result->deadlines.delivered > 0 ? 100.0 * result->deadlines.on_time / result->deadlines.delivered : 0.0;
+}
+
+static double mean_lateness_ms(const SimResult* result) {
+    long late = result->deadlines.delivered - result->deadlines.on_time;
+    return late > 0 ? result->deadlines.lateness_total * 1000.0 / late : 0.0;
+}
+
+int main(int argc, char* argv[]) {
+    int order_count = argc > 1 ? atoi(argv[1]) : 20000;
+    int cook_count = argc > 2 ? atoi(argv[2]) : 4;
+    double express_share = argc > 3 ? atof(argv[3]) : 0.25;
+    if (order_count < 1 || cook_count < 1 || express_share < 0 || express_share > 1) {
+        fprintf(stderr, "Usage: %s [orders] [cooks] [expressShare]\n", argv[0]);
+        return 1;
+    }
+
+    // Measured once, so every run sees the same cook time
+    if (cooktime_init(COOKTIME_CACHED, DEFAULT_MATRIX_ROWS, DEFAULT_MATRIX_COLS, PINV_QR, 1) < 0) {
+        return 1;
+    }
+    double cook_time = cooktime_get(DEFAULT_MATRIX_ROWS, DEFAULT_MATRIX_COLS);
+    DeadlineConfig deadline = { SCHEDULE_FIFO, DEADLINE_KITCHEN_SLACK * cook_time * 1.5, 0.0 };
+    deadline.aging_limit = DEADLINE_AGING_FACTOR * deadline.kitchen_allowance;
+    int speed = (int)(BENCH_MAP / 2 / deadline.kitchen_allowance) + 1;
+
+    SimConfig config = { cook_count, BENCH_COURIERS, speed, order_count, 0.0, BENCH_MAP, BENCH_MAP, OVEN_CAPACITY, APPARATUS,
+                         KITCHEN_ONE_DOOR, DISPATCH_ROUTE, COOKPOOL_ROUND_ROBIN, DEFAULT_MATRIX_ROWS, DEFAULT_MATRIX_COLS,
+                         COOKTIME_CACHED, BENCH_SEED, deadline, 0.0, EXPRESS_PROMISE * deadline.kitchen_allowance, 0.0, 0.0, 1 };
+    SimResult result;
+    if (sim_run(&config, &result) < 0) {
+        return 1;
+    }
+    double capacity = result.delivered / result.seconds;
+    printf("cook time %.3f ms, kitchen allowance %.3f ms, aging limit %.3f ms, speed %d, capacity %.0f orders/s\n",
+           cook_time * 1000.0, deadline.kitchen_allowance * 1000.0, deadline.aging_limit * 1000.0, speed, capacity);
+
+    double shares[] = { 0.0, express_share };
+    for (int s = 0; s < 2; ++s) {
+        config.express_share = shares[s];
+        printf("\n%.0f%% express orders promised %.3f ms\n", shares[s] * 100.0, config.express_promise * 1000.0);
+        printf("%6s %10s %12s %12s %16s %16s\n", "load", "orders/s", "fifo on time", "edf on time", "fifo late avg ms", "edf late avg ms");
+        for (size_t i = 0; i < sizeof(loads) / sizeof(loads[0]); ++i) {
+            SimResult fifo, edf;
+            config.arrival_rate = loads[i] * capacity;
+            config.deadline.mode = SCHEDULE_FIFO;
+            sim_run(&config, &fifo);
+            config.deadline.mode = SCHEDULE_EDF;
+            sim_run(&config, &edf);
+            printf("%6.2f %10.0f %11.1f%% %11.1f%% %16.3f %16.3f\n", loads[i], config.arrival_rate, on_time(&fifo), on_time(&edf),
+                   mean_lateness_ms(&fifo), mean_lateness_ms(&edf));
+        }
+    }
+
+    cooktime_shutdown();
+    return 0;
+}
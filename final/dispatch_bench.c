@@ -0,0 +1,118 @@
+// Dispatch benchmark: a cook takes the next placed order, once the original
+// way (scan orders[] under order_mutex for the first state 0) and once from
+// the ready OrderIndexQueue. The scan gets slower the further it has to go,
+// so for each table size the first orders are already taken and the last
+// ones are timed one dispatch at a time.
+//   ./dispatch_bench [timedDispatches]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "shop.h"
+
+static pthread_mutex_t order_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int timed_count = 1000;
+static volatile int sink = 0;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Eski cook_function: ilk yerleştirilmiş siparişi ara
+static int scan_dispatch(Order* orders, int total_orders) {
+    int slot = -1;
+    pthread_mutex_lock(&order_mutex);
+    for (int i = 0; i < total_orders; ++i) {
+        if (orders[i].state == 0) {
+            orders[i].state = 1;
+            slot = i;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&order_mutex);
+    return slot;
+}
+
+static int queue_dispatch(OrderIndexQueue* ready, Order* orders) {
+    pthread_mutex_lock(&order_mutex);
+    int slot = ready->head;
+    if (slot != -1) {
+        remove_order_index(ready, orders, slot);
+        orders[slot].state = 1;
+    }
+    pthread_mutex_unlock(&order_mutex);
+    return slot;
+}
+
+static void report(const char* name, double* samples, int count, double* mean) {
+    double sum = 0.0;
+    for (int i = 0; i < count; ++i) {
+        sum += samples[i];
+    }
+    qsort(samples, count, sizeof(double), compare_double);
+    *mean = sum / count;
+    printf("  %-6s mean %10.0f ns  p99 %10.0f ns\n", name, *mean * 1e9, samples[count * 99 / 100] * 1e9);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        timed_count = atoi(argv[1]);
+    }
+    if (timed_count < 1) {
+        fprintf(stderr, "Usage: %s [timedDispatches]\n", argv[0]);
+        return 1;
+    }
+
+    static const int sizes[] = { 100000, 200000, 500000, 1000000 };
+    double* samples = malloc(timed_count * sizeof(double));
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        int total_orders = sizes[s];
+        int taken = total_orders - timed_count;
+        Order* orders = calloc(total_orders, sizeof(Order));
+        if (orders == NULL || samples == NULL || taken < 0) {
+            fprintf(stderr, "Cannot time %d of %d orders\n", timed_count, total_orders);
+            return 1;
+        }
+        printf("%d orders, last %d dispatches:\n", total_orders, timed_count);
+
+        for (int i = 0; i < total_orders; ++i) {
+            orders[i].state = i < taken ? 1 : 0;
+        }
+        for (int i = 0; i < timed_count; ++i) {
+            double start = now_seconds();
+            sink = scan_dispatch(orders, total_orders);
+            samples[i] = now_seconds() - start;
+        }
+        double scan_mean;
+        report("scan", samples, timed_count, &scan_mean);
+
+        OrderIndexQueue ready;
+        init_index_queue(&ready);
+        for (int i = 0; i < total_orders; ++i) {
+            orders[i].state = 0;
+            push_order_index(&ready, orders, i);
+        }
+        for (int i = 0; i < taken; ++i) {
+            queue_dispatch(&ready, orders);
+        }
+        for (int i = 0; i < timed_count; ++i) {
+            double start = now_seconds();
+            sink = queue_dispatch(&ready, orders);
+            samples[i] = now_seconds() - start;
+        }
+        double queue_mean;
+        report("queue", samples, timed_count, &queue_mean);
+        printf("  %.0fx faster\n", scan_mean / queue_mean);
+        free(orders);
+    }
+    free(samples);
+    return 0;
+}
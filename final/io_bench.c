@@ -0,0 +1,266 @@
+// I/O syscall benchmark: client threads send paced ORDER frames over
+// loopback to the reactor, which logs one line per order like the server.
+// Runs once with epoll and once with io_uring and counts the syscalls the
+// event loops and the log flusher make (linked with --wrap, client threads
+// are not counted). Target: io_uring needs a tenth of the syscalls per order.
+//   ./io_bench [connections] [ordersPerConnection] [ordersPerSec]
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include "protocol.h"
+#include "reactor.h"
+#include "logger.h"
+
+#define TARGET_RATIO 10.0
+#define BENCH_LOG "io_bench.log"
+
+enum { CALL_EPOLL_WAIT, CALL_READ, CALL_ACCEPT, CALL_EPOLL_CTL, CALL_URING_ENTER, CALL_WRITEV, CALL_FDATASYNC, CALL_OTHER, CALL_KINDS };
+static const char* call_names[CALL_KINDS] = { "epoll_wait", "read", "accept4", "epoll_ctl", "io_uring_enter", "writev", "fdatasync", "other" };
+
+static atomic_long calls[CALL_KINDS];
+static __thread int not_counted = 0; // Client threads and main
+static atomic_int received = 0;
+static int connection_count = 64;
+static int orders_per_connection = 2000;
+static double rate = 50000.0;
+static int port = 0;
+static double start_time;
+
+static void count(int kind) {
+    if (!not_counted) {
+        atomic_fetch_add_explicit(&calls[kind], 1, memory_order_relaxed);
+    }
+}
+
+ssize_t __real_read(int fd, void* buf, size_t n);
+ssize_t __wrap_read(int fd, void* buf, size_t n) {
+    count(CALL_READ);
+    return __real_read(fd, buf, n);
+}
+
+int __real_epoll_wait(int epfd, struct epoll_event* events, int max, int timeout);
+int __wrap_epoll_wait(int epfd, struct epoll_event* events, int max, int timeout) {
+    count(CALL_EPOLL_WAIT);
+    return __real_epoll_wait(epfd, events, max, timeout);
+}
+
+int __real_epoll_ctl(int epfd, int op, int fd, struct epoll_event* event);
+int __wrap_epoll_ctl(int epfd, int op, int fd, struct epoll_event* event) {
+    count(CALL_EPOLL_CTL);
+    return __real_epoll_ctl(epfd, op, fd, event);
+}
+
+int __real_accept4(int fd, struct sockaddr* addr, socklen_t* len, int flags);
+int __wrap_accept4(int fd, struct sockaddr* addr, socklen_t* len, int flags) {
+    count(CALL_ACCEPT);
+    return __real_accept4(fd, addr, len, flags);
+}
+
+ssize_t __real_writev(int fd, const struct iovec* iov, int n);
+ssize_t __wrap_writev(int fd, const struct iovec* iov, int n) {
+    count(CALL_WRITEV);
+    return __real_writev(fd, iov, n);
+}
+
+int __real_fdatasync(int fd);
+int __wrap_fdatasync(int fd) {
+    count(CALL_FDATASYNC);
+    return __real_fdatasync(fd);
+}
+
+// uring.c goes through syscall(); six arguments cover every call it makes
+long __real_syscall(long number, ...);
+long __wrap_syscall(long number, ...) {
+    va_list args;
+    va_start(args, number);
+    long a = va_arg(args, long), b = va_arg(args, long), c = va_arg(args, long);
+    long d = va_arg(args, long), e = va_arg(args, long), f = va_arg(args, long);
+    va_end(args);
+    count(number == __NR_io_uring_enter ? CALL_URING_ENTER : CALL_OTHER);
+    return __real_syscall(number, a, b, c, d, e, f);
+}
+
+// Reactor hooks: take every order and log it, as place_order does
+void reactor_on_init(int number_of_clients, int p, int q, pid_t pid, int promise_ms) {
+    (void)number_of_clients, (void)p, (void)q, (void)pid, (void)promise_ms;
+}
+
+int reactor_can_admit(void) {
+    return 1;
+}
+
+int reactor_on_order(int order_id, int customer_x, int customer_y, pid_t pid, int promise_ms) {
+    (void)promise_ms;
+    char message[128];
+    snprintf(message, sizeof(message), "Order %d of PID %d placed for (%d, %d)", order_id, pid, customer_x, customer_y);
+    logger_write(message);
+    atomic_fetch_add(&received, 1);
+    return 0;
+}
+
+void reactor_on_cancel(pid_t pid, int order_id) {
+    (void)pid, (void)order_id;
+}
+
+void reactor_on_subscribe(int port, int fd, pid_t pid) {
+    (void)port, (void)pid;
+    close(fd);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleep_until(double when) {
+    double wait = when - now_seconds();
+    if (wait > 0) {
+        struct timespec ts = { (time_t)wait, (long)((wait - (time_t)wait) * 1e9) };
+        nanosleep(&ts, NULL);
+    }
+}
+
+// One client: HELLO, then one ORDER frame per send on the shared schedule
+static void* client(void* arg) {
+    not_counted = 1;
+    int index = (int)(long)arg;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        perror("connect");
+        exit(EXIT_FAILURE);
+    }
+
+    pid_t pid = 1000 + index;
+    unsigned char frame[FRAME_HEADER_SIZE + ORDER_PAYLOAD_SIZE];
+    size_t offset = put_frame_header(frame, FRAME_HELLO, HELLO_PAYLOAD_SIZE);
+    put_u32(frame + offset, (uint32_t)pid);
+    put_u32(frame + offset + 4, (uint32_t)orders_per_connection);
+    put_u32(frame + offset + 8, 10);
+    put_u32(frame + offset + 12, 10);
+    send(fd, frame, FRAME_HEADER_SIZE + HELLO_PAYLOAD_SIZE, MSG_NOSIGNAL);
+
+    for (int id = 1; id <= orders_per_connection; ++id) {
+        sleep_until(start_time + ((double)(id - 1) * connection_count + index) / rate);
+        offset = put_frame_header(frame, FRAME_ORDER, ORDER_PAYLOAD_SIZE);
+        put_u32(frame + offset, (uint32_t)pid);
+        put_u32(frame + offset + 4, (uint32_t)id);
+        put_u32(frame + offset + 8, (uint32_t)(id % 10));
+        put_u32(frame + offset + 12, (uint32_t)(id / 10 % 10));
+        send(fd, frame, FRAME_HEADER_SIZE + ORDER_PAYLOAD_SIZE, MSG_NOSIGNAL);
+    }
+    return (void*)(long)fd;
+}
+
+// Syscalls per order for one backend, -1 if it could not run
+static double run(int listen_fd, int backend, double* seconds) {
+    for (int i = 0; i < CALL_KINDS; ++i) {
+        atomic_store(&calls[i], 0);
+    }
+    atomic_store(&received, 0);
+
+    LoggerConfig logger_config = { LOG_FLUSH_INTERVAL_MS, LOG_DURABILITY_FLUSH, LOG_FORMAT_TEXT, backend == REACTOR_URING };
+    int listen_fds[REACTOR_PORTS] = { listen_fd, -1, -1 };
+    if (logger_init(BENCH_LOG, &logger_config) < 0 || reactor_start(listen_fds, 1, backend) < 0) {
+        return -1;
+    }
+
+    int total = connection_count * orders_per_connection;
+    pthread_t* threads = malloc(connection_count * sizeof(pthread_t));
+    start_time = now_seconds() + 0.05;
+    for (int i = 0; i < connection_count; ++i) {
+        pthread_create(&threads[i], NULL, client, (void*)(long)i);
+    }
+    while (atomic_load(&received) < total) {
+        usleep(1000);
+    }
+    *seconds = now_seconds() - start_time;
+    // The flusher's last cycle still belongs to this run
+    usleep(LOG_FLUSH_INTERVAL_MS * 2000);
+
+    long counted[CALL_KINDS];
+    long sum = 0;
+    for (int i = 0; i < CALL_KINDS; ++i) {
+        counted[i] = atomic_load(&calls[i]);
+        sum += counted[i];
+    }
+    printf("%-8s %8d orders in %.2f s, %8ld syscalls, %.3f per order:", reactor_backend_name(backend), total, *seconds, sum, (double)sum / total);
+    for (int i = 0; i < CALL_KINDS; ++i) {
+        if (counted[i] > 0) {
+            printf(" %s %ld", call_names[i], counted[i]);
+        }
+    }
+    printf("\n");
+
+    for (int i = 0; i < connection_count; ++i) {
+        void* fd;
+        pthread_join(threads[i], &fd);
+        close((int)(long)fd);
+    }
+    free(threads);
+    reactor_stop();
+    logger_shutdown();
+    return (double)sum / total;
+}
+
+int main(int argc, char* argv[]) {
+    not_counted = 1;
+    if (argc > 1) {
+        connection_count = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        orders_per_connection = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        rate = atof(argv[3]);
+    }
+    if (connection_count < 1 || orders_per_connection < 1 || rate <= 0) {
+        fprintf(stderr, "Usage: %s [connections] [ordersPerConnection] [ordersPerSec]\n", argv[0]);
+        return 1;
+    }
+    if (reactor_pick_backend(REACTOR_AUTO) != REACTOR_URING) {
+        fprintf(stderr, "io_uring is not available here, nothing to compare\n");
+        return 1;
+    }
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (bind(listen_fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listen_fd, SOMAXCONN) < 0 ||
+        getsockname(listen_fd, (struct sockaddr*)&address, &length) < 0) {
+        perror("listen");
+        return 1;
+    }
+    port = ntohs(address.sin_port);
+
+    printf("%d connections, %d orders each, %.0f orders/s, log fdatasync every %d ms\n", connection_count, orders_per_connection, rate,
+           LOG_FLUSH_INTERVAL_MS);
+    double seconds;
+    double epoll_calls = run(listen_fd, REACTOR_EPOLL, &seconds);
+    double uring_calls = run(listen_fd, REACTOR_URING, &seconds);
+    close(listen_fd);
+    remove(BENCH_LOG);
+    if (epoll_calls < 0 || uring_calls < 0) {
+        return 1;
+    }
+    printf("syscalls per order: %.3f epoll, %.3f io_uring (%.1fx fewer), target %.0fx: %s\n", epoll_calls, uring_calls,
+           epoll_calls / uring_calls, TARGET_RATIO, epoll_calls >= TARGET_RATIO * uring_calls ? "ok" : "MISSED");
+    return 0;
+}
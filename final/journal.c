@@ -0,0 +1,549 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "protocol.h"
+#include "journal.h"
+
+#define JOURNAL_CAPACITY (JOURNAL_BUFFER_SIZE / sizeof(JournalRecord))
+
+// Group commit: appenders fill the active buffer under journal_mutex, the
+// committer swaps it with the standby one and writes plus fdatasyncs it
+// outside that lock, so appends never wait for the disk unless both
+// buffers are full.
+static JournalRecord* active = NULL;
+static JournalRecord* standby = NULL;
+static size_t active_count = 0;
+static int journal_fd = -1;
+static atomic_int running = 0;
+static JournalStats stats;
+static pthread_t committer_thread;
+static pthread_mutex_t journal_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t write_mutex = PTHREAD_MUTEX_INITIALIZER; // One batch on its way to disk at a time
+static pthread_cond_t wake_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t space_cond = PTHREAD_COND_INITIALIZER;
+
+static uint16_t record_check(const JournalRecord* record) {
+    JournalRecord copy = *record;
+    copy.check = 0;
+    const unsigned char* bytes = (const unsigned char*)&copy;
+    uint32_t hash = 2166136261u; // FNV-1a, folded
+    for (size_t i = 0; i < sizeof(copy); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    uint16_t check = (uint16_t)(hash ^ (hash >> 16));
+    return check != 0 ? check : 1; // An all-zero record (preallocated, never written) never passes
+}
+
+static int write_fully(int fd, const void* data, size_t length) {
+    const char* bytes = data;
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("journal write");
+            return -1;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+static void commit_batch(void) {
+    pthread_mutex_lock(&write_mutex);
+    pthread_mutex_lock(&journal_mutex);
+    JournalRecord* batch = active;
+    size_t count = active_count;
+    active = standby;
+    standby = batch;
+    active_count = 0;
+    pthread_cond_broadcast(&space_cond);
+    pthread_mutex_unlock(&journal_mutex);
+
+    if (count > 0 && journal_fd >= 0) {
+        write_fully(journal_fd, batch, count * sizeof(JournalRecord));
+        fdatasync(journal_fd);
+        stats.commits++;
+        if ((long)count > stats.largest_commit) {
+            stats.largest_commit = (long)count;
+        }
+    }
+    pthread_mutex_unlock(&write_mutex);
+}
+
+static void* committer_function(void* arg) {
+    (void)arg;
+
+    while (atomic_load(&running)) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += JOURNAL_COMMIT_INTERVAL_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&journal_mutex);
+        while (active_count < JOURNAL_CAPACITY / 2 && atomic_load(&running)) {
+            if (pthread_cond_timedwait(&wake_cond, &journal_mutex, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        pthread_mutex_unlock(&journal_mutex);
+        commit_batch();
+    }
+    return NULL;
+}
+
+static void append(JournalRecord* record) {
+    if (!atomic_load_explicit(&running, memory_order_relaxed)) {
+        return;
+    }
+    record->check = record_check(record);
+    pthread_mutex_lock(&journal_mutex);
+    while (active_count == JOURNAL_CAPACITY && atomic_load(&running)) {
+        stats.full_waits++;
+        pthread_cond_signal(&wake_cond);
+        pthread_cond_wait(&space_cond, &journal_mutex);
+    }
+    if (active_count < JOURNAL_CAPACITY) {
+        active[active_count++] = *record;
+        stats.records++;
+        if (active_count == JOURNAL_CAPACITY / 2) {
+            pthread_cond_signal(&wake_cond);
+        }
+    }
+    pthread_mutex_unlock(&journal_mutex);
+}
+
+void journal_session(pid_t pid, int orders, int p, int q) {
+    JournalRecord record = { JOURNAL_SESSION, 0, 0, (uint32_t)pid, (uint32_t)orders, p, q };
+    append(&record);
+}
+
+void journal_placed(pid_t pid, int order_id, int customer_x, int customer_y) {
+    JournalRecord record = { JOURNAL_PLACED, 0, 0, (uint32_t)pid, (uint32_t)order_id, customer_x, customer_y };
+    append(&record);
+}
+
+void journal_state(pid_t pid, int order_id, int state) {
+    JournalRecord record = { JOURNAL_STATE, (uint8_t)state, 0, (uint32_t)pid, (uint32_t)order_id, 0, 0 };
+    append(&record);
+}
+
+void journal_unsent(pid_t pid, int count) {
+    JournalRecord record = { JOURNAL_UNSENT, 0, 0, (uint32_t)pid, 0, count, 0 };
+    append(&record);
+}
+
+// Live state of the checkpoint, straight to the file before the committer runs
+static int write_checkpoint(int fd, const JournalReplay* checkpoint) {
+    JournalRecord chunk[4096];
+    size_t count = 0;
+#define EMIT(...) \
+    do { \
+        chunk[count] = (JournalRecord){ __VA_ARGS__ }; \
+        chunk[count].check = record_check(&chunk[count]); \
+        if (++count == sizeof(chunk) / sizeof(chunk[0])) { \
+            if (write_fully(fd, chunk, sizeof(chunk)) < 0) { \
+                return -1; \
+            } \
+            count = 0; \
+        } \
+    } while (0)
+
+    for (int i = 0; i < checkpoint->session_count; ++i) {
+        const JournalSession* session = &checkpoint->sessions[i];
+        EMIT(JOURNAL_SESSION, 0, 0, (uint32_t)session->pid, (uint32_t)session->received, session->p, session->q);
+        if (session->completed + session->cancelled > 0) {
+            EMIT(JOURNAL_SETTLED, 0, 0, (uint32_t)session->pid, 0, session->completed, session->cancelled);
+        }
+    }
+    for (int i = 0; i < checkpoint->order_count; ++i) {
+        const JournalOrder* order = &checkpoint->orders[i];
+        EMIT(JOURNAL_PLACED, 0, 0, (uint32_t)order->pid, (uint32_t)order->order_id, order->customer_x, order->customer_y);
+        if (order->state != STATE_PLACED) {
+            EMIT(JOURNAL_STATE, (uint8_t)order->state, 0, (uint32_t)order->pid, (uint32_t)order->order_id, 0, 0);
+        }
+    }
+#undef EMIT
+    return write_fully(fd, chunk, count * sizeof(JournalRecord));
+}
+
+int journal_start(const char* path, const JournalReplay* checkpoint) {
+    // The new journal is complete and durable before it replaces the old one
+    char temp_path[4096];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("open journal");
+        return -1;
+    }
+    if (write_fully(fd, JOURNAL_MAGIC, 8) < 0 || (checkpoint != NULL && write_checkpoint(fd, checkpoint) < 0) ||
+        fdatasync(fd) < 0 || rename(temp_path, path) < 0) {
+        perror("journal checkpoint");
+        close(fd);
+        return -1;
+    }
+
+    // The rename is durable once the directory is
+    char directory[4096];
+    snprintf(directory, sizeof(directory), "%s", path);
+    char* slash = strrchr(directory, '/');
+    if (slash == NULL) {
+        snprintf(directory, sizeof(directory), ".");
+    } else {
+        *(slash == directory ? slash + 1 : slash) = '\0';
+    }
+    int directory_fd = open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directory_fd >= 0) {
+        fsync(directory_fd);
+        close(directory_fd);
+    }
+
+    active = malloc(JOURNAL_BUFFER_SIZE);
+    standby = malloc(JOURNAL_BUFFER_SIZE);
+    if (active == NULL || standby == NULL) {
+        perror("Failed to allocate journal buffers");
+        close(fd);
+        return -1;
+    }
+    memset(&stats, 0, sizeof(stats));
+    active_count = 0;
+    journal_fd = fd;
+
+    atomic_store(&running, 1);
+    if (pthread_create(&committer_thread, NULL, committer_function, NULL) != 0) {
+        perror("pthread_create");
+        atomic_store(&running, 0);
+        return -1;
+    }
+    pthread_detach(committer_thread);
+    return 0;
+}
+
+// Commits what is left and closes the file. Called from the shutdown
+// thread (handle_signals), an ordinary thread, so it just takes the locks;
+// appenders only hold journal_mutex for a copy.
+void journal_stop(void) {
+    if (!atomic_exchange(&running, 0)) {
+        return;
+    }
+    pthread_mutex_lock(&write_mutex);
+    pthread_mutex_lock(&journal_mutex);
+    if (active_count > 0) {
+        write_fully(journal_fd, active, active_count * sizeof(JournalRecord));
+        stats.commits++;
+        active_count = 0;
+    }
+    pthread_cond_broadcast(&space_cond);
+    pthread_cond_signal(&wake_cond);
+    pthread_mutex_unlock(&journal_mutex);
+    fdatasync(journal_fd);
+    close(journal_fd);
+    journal_fd = -1;
+    pthread_mutex_unlock(&write_mutex);
+    // Buffers stay allocated: appenders may still be on their way out
+}
+
+void journal_get_stats(JournalStats* out) {
+    pthread_mutex_lock(&write_mutex);
+    pthread_mutex_lock(&journal_mutex);
+    *out = stats;
+    pthread_mutex_unlock(&journal_mutex);
+    pthread_mutex_unlock(&write_mutex);
+}
+
+// Replay. Sessions and orders go into open-addressing tables; a session
+// that finishes bumps its generation, which retires all of its orders at
+// once without walking them.
+
+typedef struct {
+    pid_t pid;
+    int active;
+    unsigned int generation;
+    int expected;
+    int received;
+    int completed;
+    int cancelled;
+    int unsent;
+    int p, q;
+    int live; // Filled by the final pass
+} ReplaySession;
+
+typedef struct {
+    pid_t pid;
+    int order_id;
+    int customer_x;
+    int customer_y;
+    int state;
+    int session;
+    unsigned int generation;
+} ReplayOrder;
+
+typedef struct {
+    int* slots; // Index into the entry array, -1 empty
+    size_t mask;
+} ReplayTable;
+
+static int table_init(ReplayTable* table, size_t entries) {
+    size_t capacity = 16;
+    while (capacity < entries * 2) {
+        capacity <<= 1;
+    }
+    table->slots = malloc(capacity * sizeof(int));
+    if (table->slots == NULL) {
+        return -1;
+    }
+    memset(table->slots, 0xff, capacity * sizeof(int));
+    table->mask = capacity - 1;
+    return 0;
+}
+
+static inline size_t hash_key(uint32_t pid, uint32_t order_id) {
+    uint64_t key = ((uint64_t)pid << 32) | order_id;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key;
+}
+
+static ReplaySession* replay_sessions;
+static int replay_session_count;
+static ReplayOrder* replay_orders;
+static int replay_order_count;
+
+static int find_session(ReplayTable* table, pid_t pid, int create) {
+    for (size_t i = hash_key((uint32_t)pid, 0) & table->mask;; i = (i + 1) & table->mask) {
+        int index = table->slots[i];
+        if (index == -1) {
+            if (!create) {
+                return -1;
+            }
+            index = replay_session_count++;
+            memset(&replay_sessions[index], 0, sizeof(ReplaySession));
+            replay_sessions[index].pid = pid;
+            table->slots[i] = index;
+            return index;
+        }
+        if (replay_sessions[index].pid == pid) {
+            return index;
+        }
+    }
+}
+
+static int find_order(ReplayTable* table, pid_t pid, int order_id, int create) {
+    for (size_t i = hash_key((uint32_t)pid, (uint32_t)order_id) & table->mask;; i = (i + 1) & table->mask) {
+        int index = table->slots[i];
+        if (index == -1) {
+            if (!create) {
+                return -1;
+            }
+            index = replay_order_count++;
+            replay_orders[index].pid = pid;
+            replay_orders[index].order_id = order_id;
+            replay_orders[index].session = -1;
+            table->slots[i] = index;
+            return index;
+        }
+        if (replay_orders[index].pid == pid && replay_orders[index].order_id == order_id) {
+            return index;
+        }
+    }
+}
+
+static int order_alive(const ReplayOrder* order) {
+    if (order->session < 0) {
+        return 0;
+    }
+    const ReplaySession* session = &replay_sessions[order->session];
+    return session->active && session->generation == order->generation;
+}
+
+static void check_settled(ReplaySession* session) {
+    if (session->completed + session->cancelled + session->unsent >= session->expected) {
+        session->active = 0;
+        session->generation++;
+    }
+}
+
+int journal_replay(const char* path, JournalReplay* replay) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    memset(replay, 0, sizeof(*replay));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        perror("open journal");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("fstat journal");
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size < 8) {
+        close(fd);
+        replay->torn_bytes = (long)size;
+        return 0;
+    }
+    const unsigned char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("mmap journal");
+        return -1;
+    }
+    madvise((void*)data, size, MADV_SEQUENTIAL);
+    if (memcmp(data, JOURNAL_MAGIC, 8) != 0) {
+        fprintf(stderr, "> %s is not an order journal\n", path);
+        munmap((void*)data, size);
+        return -1;
+    }
+
+    // First pass: the valid prefix and table sizes
+    const JournalRecord* records = (const JournalRecord*)(data + 8);
+    size_t total = (size - 8) / sizeof(JournalRecord);
+    size_t valid = 0;
+    size_t session_records = 0, placed_records = 0;
+    for (; valid < total; ++valid) {
+        const JournalRecord* record = &records[valid];
+        if (record->check != record_check(record)) {
+            break;
+        }
+        session_records += record->type == JOURNAL_SESSION;
+        placed_records += record->type == JOURNAL_PLACED;
+    }
+    replay->records = (long)valid;
+    replay->torn_bytes = (long)(size - 8 - valid * sizeof(JournalRecord));
+
+    ReplayTable session_table, order_table;
+    replay_sessions = malloc((session_records + 1) * sizeof(ReplaySession));
+    replay_orders = malloc((placed_records + 1) * sizeof(ReplayOrder));
+    replay_session_count = replay_order_count = 0;
+    if (replay_sessions == NULL || replay_orders == NULL || table_init(&session_table, session_records + 1) < 0 ||
+        table_init(&order_table, placed_records + 1) < 0) {
+        perror("Failed to allocate journal replay");
+        munmap((void*)data, size);
+        return -1;
+    }
+
+    for (size_t r = 0; r < valid; ++r) {
+        const JournalRecord* record = &records[r];
+        pid_t pid = (pid_t)record->pid;
+        if (record->type == JOURNAL_SESSION) {
+            ReplaySession* session = &replay_sessions[find_session(&session_table, pid, 1)];
+            if (!session->active) {
+                session->active = 1;
+                session->expected = session->received = session->completed = session->cancelled = session->unsent = 0;
+            }
+            session->expected += (int)record->order_id;
+            session->p = record->a;
+            session->q = record->b;
+            check_settled(session);
+            continue;
+        }
+
+        int session_index = find_session(&session_table, pid, 0);
+        if (session_index < 0 || !replay_sessions[session_index].active) {
+            continue; // Never announced, or finished already
+        }
+        ReplaySession* session = &replay_sessions[session_index];
+        if (record->type == JOURNAL_PLACED) {
+            ReplayOrder* order = &replay_orders[find_order(&order_table, pid, (int)record->order_id, 1)];
+            if (order_alive(order)) {
+                continue;
+            }
+            order->customer_x = record->a;
+            order->customer_y = record->b;
+            order->state = STATE_PLACED;
+            order->session = session_index;
+            order->generation = session->generation;
+            session->received++;
+        } else if (record->type == JOURNAL_STATE) {
+            int index = find_order(&order_table, pid, (int)record->order_id, 0);
+            if (index < 0 || !order_alive(&replay_orders[index]) || record->state <= replay_orders[index].state ||
+                replay_orders[index].state >= STATE_COMPLETED) {
+                continue;
+            }
+            replay_orders[index].state = record->state;
+            if (record->state == STATE_COMPLETED) {
+                session->completed++;
+            } else if (record->state == STATE_CANCELLED) {
+                session->cancelled++;
+            }
+            check_settled(session);
+        } else if (record->type == JOURNAL_SETTLED) {
+            session->received += record->a + record->b;
+            session->completed += record->a;
+            session->cancelled += record->b;
+            check_settled(session);
+        } else if (record->type == JOURNAL_UNSENT) {
+            session->unsent += record->a;
+            check_settled(session);
+        }
+    }
+    munmap((void*)data, size);
+
+    // What is left to serve, orders in the order they were placed
+    int live_orders = 0;
+    for (int i = 0; i < replay_order_count; ++i) {
+        if (order_alive(&replay_orders[i]) && replay_orders[i].state < STATE_COMPLETED) {
+            replay_sessions[replay_orders[i].session].live++;
+            live_orders++;
+        }
+    }
+    int live_sessions = 0;
+    for (int i = 0; i < replay_session_count; ++i) {
+        live_sessions += replay_sessions[i].active && replay_sessions[i].live > 0;
+    }
+    replay->sessions = malloc((live_sessions + 1) * sizeof(JournalSession));
+    replay->orders = malloc((live_orders + 1) * sizeof(JournalOrder));
+    if (replay->sessions == NULL || replay->orders == NULL) {
+        perror("Failed to allocate journal replay");
+        return -1;
+    }
+    for (int i = 0; i < replay_session_count; ++i) {
+        const ReplaySession* session = &replay_sessions[i];
+        if (session->active && session->live > 0) {
+            replay->sessions[replay->session_count++] =
+                (JournalSession){ session->pid, session->received, session->completed, session->cancelled, session->p, session->q };
+        }
+    }
+    for (int i = 0; i < replay_order_count; ++i) {
+        const ReplayOrder* order = &replay_orders[i];
+        if (order_alive(order) && order->state < STATE_COMPLETED) {
+            replay->orders[replay->order_count++] =
+                (JournalOrder){ order->pid, order->order_id, order->customer_x, order->customer_y, order->state };
+        }
+    }
+
+    free(session_table.slots);
+    free(order_table.slots);
+    free(replay_sessions);
+    free(replay_orders);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    replay->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return 0;
+}
+
+void journal_replay_free(JournalReplay* replay) {
+    free(replay->sessions);
+    free(replay->orders);
+    replay->sessions = NULL;
+    replay->orders = NULL;
+    replay->session_count = replay->order_count = 0;
+}
@@ -0,0 +1,80 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define JOURNAL_FILE_NAME "pide_shop.journal"
+#define JOURNAL_MAGIC "PIDEJRN1"         // First 8 bytes of the file
+#define JOURNAL_COMMIT_INTERVAL_MS 5     // Longest a record waits for its fdatasync
+#define JOURNAL_BUFFER_SIZE (1 << 20)    // Per buffer, two of them
+
+// Record types
+#define JOURNAL_SESSION 1 // HELLO: order_id = orders announced, a = p, b = q
+#define JOURNAL_PLACED 2  // a = customer_x, b = customer_y
+#define JOURNAL_STATE 3   // state = STATE_* from protocol.h
+#define JOURNAL_SETTLED 4 // Checkpoint of a session: a = delivered, b = cancelled
+#define JOURNAL_UNSENT 5  // a = announced orders cancelled before they arrived
+
+// Fixed size, host byte order: the journal is read back by the same machine
+typedef struct {
+    uint8_t type;
+    uint8_t state;
+    uint16_t check; // Over the other bytes, finds the torn tail after a crash
+    uint32_t pid;
+    uint32_t order_id;
+    int32_t a;
+    int32_t b;
+} JournalRecord;
+
+// A session with orders still to serve, its client is gone
+typedef struct {
+    pid_t pid;
+    int received;  // Orders that arrived; the ones never sent are given up
+    int completed;
+    int cancelled;
+    int p, q;
+} JournalSession;
+
+typedef struct {
+    pid_t pid;
+    int order_id;
+    int customer_x;
+    int customer_y;
+    int state; // Furthest STATE_* reached, never COMPLETED or CANCELLED
+} JournalOrder;
+
+typedef struct {
+    JournalSession* sessions;
+    int session_count;
+    JournalOrder* orders; // In placement order
+    int order_count;
+    long records;
+    long torn_bytes; // Partial or corrupt tail ignored
+    double seconds;
+} JournalReplay;
+
+typedef struct {
+    long records;
+    long commits;      // fdatasync calls
+    long largest_commit; // Records made durable by one fdatasync
+    long full_waits;   // Appends that found both buffers full
+} JournalStats;
+
+// A missing file is an empty journal
+int journal_replay(const char* path, JournalReplay* replay);
+void journal_replay_free(JournalReplay* replay);
+
+// Starts a new journal at path. With a checkpoint, its live state is written
+// to a temporary file first and renamed over the old journal once durable.
+int journal_start(const char* path, const JournalReplay* checkpoint);
+void journal_stop(void);
+void journal_get_stats(JournalStats* stats);
+
+// No-ops while the journal is not running
+void journal_session(pid_t pid, int orders, int p, int q);
+void journal_placed(pid_t pid, int order_id, int customer_x, int customer_y);
+void journal_state(pid_t pid, int order_id, int state);
+void journal_unsent(pid_t pid, int count);
+
+#endif
@@ -0,0 +1,94 @@
+// Journal benchmark: writer threads journal sessions of orders through
+// every state, group-committed as in the server, with the last tenth of
+// every session left unfinished. Then the journal is replayed as a
+// restart with -R would. Recovery target: 10^6 orders in under 1 s.
+//   ./journal_bench [orders] [threads] [path]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "protocol.h"
+#include "journal.h"
+
+#define SESSION_ORDERS 1000
+#define RECOVERY_TARGET_SECONDS 1.0
+
+static int order_count = 1000000;
+static int thread_count = 4;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* writer(void* arg) {
+    int index = (int)(long)arg;
+    int sessions = order_count / SESSION_ORDERS;
+    for (int s = index; s < sessions; s += thread_count) {
+        pid_t pid = 1000 + s;
+        journal_session(pid, SESSION_ORDERS, 100, 100);
+        for (int id = 1; id <= SESSION_ORDERS; ++id) {
+            journal_placed(pid, id, id % 100, (id * 7) % 100);
+        }
+        // Cooks and couriers move orders along; the last tenth is still in the kitchen
+        for (int state = STATE_PREPARED; state <= STATE_COMPLETED; ++state) {
+            for (int id = 1; id <= SESSION_ORDERS; ++id) {
+                if (id <= SESSION_ORDERS * 9 / 10 || state < STATE_COOKED) {
+                    journal_state(pid, id, state);
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        order_count = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        thread_count = atoi(argv[2]);
+    }
+    const char* path = argc > 3 ? argv[3] : "journal_bench.journal";
+    if (order_count < SESSION_ORDERS || thread_count < 1) {
+        fprintf(stderr, "Usage: %s [orders >= %d] [threads] [path]\n", argv[0], SESSION_ORDERS);
+        return 1;
+    }
+
+    if (journal_start(path, NULL) < 0) {
+        return 1;
+    }
+    pthread_t* threads = malloc(thread_count * sizeof(pthread_t));
+    double start = now_seconds();
+    for (int i = 0; i < thread_count; ++i) {
+        pthread_create(&threads[i], NULL, writer, (void*)(long)i);
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    JournalStats stats;
+    journal_get_stats(&stats);
+    journal_stop();
+    double written = now_seconds() - start;
+    free(threads);
+
+    struct stat st;
+    stat(path, &st);
+    printf("write:  %ld records, %.1f MB in %.3f s (%.2f M records/s), %ld fdatasyncs, largest commit %ld, %ld full waits\n",
+           stats.records, st.st_size / 1e6, written, stats.records / written / 1e6, stats.commits, stats.largest_commit, stats.full_waits);
+
+    JournalReplay replay;
+    if (journal_replay(path, &replay) < 0) {
+        return 1;
+    }
+    int orders = order_count / SESSION_ORDERS * SESSION_ORDERS;
+    printf("replay: %ld records in %.3f s (%.2f M records/s), %d orders of %d sessions to resume\n", replay.records,
+           replay.seconds, replay.records / replay.seconds / 1e6, replay.order_count, replay.session_count);
+    printf("recovery of %d orders: %.3f s, target %.1f s: %s\n", orders, replay.seconds, RECOVERY_TARGET_SECONDS,
+           replay.seconds <= RECOVERY_TARGET_SECONDS * orders / 1e6 ? "ok" : "MISSED");
+    journal_replay_free(&replay);
+    remove(path);
+    return 0;
+}
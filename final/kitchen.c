@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "kitchen.h"
+
+static KitchenResource apparatus;
+static KitchenResource oven;
+static KitchenResource doors[2]; // [0] insert, [1] remove; only [0] with one door
+static int door_count = KITCHEN_ONE_DOOR;
+static double start_time;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double (*kitchen_clock)(void) = now_seconds;
+
+void kitchen_set_clock(double (*clock)(void)) {
+    kitchen_clock = clock != NULL ? clock : now_seconds;
+}
+
+// Called with the resource locked whenever in_use is about to change
+static void account_busy(KitchenResource* resource, double now) {
+    resource->stats.busy_integral += resource->stats.in_use * (now - resource->last_change);
+    resource->last_change = now;
+}
+
+// A unit goes to its new holder, waited seconds after it asked
+static void account_taken(KitchenResource* resource, double now, double waited) {
+    account_busy(resource, now);
+    resource->stats.in_use++;
+    if (resource->stats.in_use > resource->stats.peak) {
+        resource->stats.peak = resource->stats.in_use;
+    }
+    resource->stats.acquisitions++;
+    resource->stats.wait_total += waited;
+    if (waited > resource->stats.wait_max) {
+        resource->stats.wait_max = waited;
+    }
+}
+
+void resource_init(KitchenResource* resource, const char* name, int capacity) {
+    memset(resource, 0, sizeof(*resource));
+    resource->name = name;
+    resource->capacity = capacity;
+    resource->available = capacity;
+    pthread_mutex_init(&resource->mutex, NULL);
+    resource->last_change = kitchen_clock();
+}
+
+int resource_try_acquire(KitchenResource* resource, KitchenWaiter* waiter) {
+    pthread_mutex_lock(&resource->mutex);
+    double now = kitchen_clock();
+    if (resource->available > 0 && resource->head == NULL) {
+        resource->available--;
+        account_taken(resource, now, 0.0);
+        pthread_mutex_unlock(&resource->mutex);
+        return 1;
+    }
+    waiter->granted = 0;
+    waiter->woken = 0;
+    waiter->since = now;
+    // Behind every waiter that goes first or ties; a handful of cooks at most
+    KitchenWaiter** link = &resource->head;
+    while (*link != NULL && (*link)->priority <= waiter->priority) {
+        link = &(*link)->next;
+    }
+    waiter->next = *link;
+    *link = waiter;
+    if (waiter->next == NULL) {
+        resource->tail = waiter;
+    }
+    pthread_mutex_unlock(&resource->mutex);
+    return 0;
+}
+
+void resource_acquire(KitchenResource* resource, double priority) {
+    KitchenWaiter waiter;
+    pthread_cond_init(&waiter.cond, NULL);
+    waiter.priority = priority;
+    waiter.on_grant = NULL;
+    if (!resource_try_acquire(resource, &waiter)) {
+        pthread_mutex_lock(&resource->mutex);
+        while (!waiter.granted) {
+            pthread_cond_wait(&waiter.cond, &resource->mutex);
+        }
+        pthread_mutex_unlock(&resource->mutex);
+    }
+    pthread_cond_destroy(&waiter.cond);
+}
+
+void resource_release(KitchenResource* resource) {
+    pthread_mutex_lock(&resource->mutex);
+    double now = kitchen_clock();
+    account_busy(resource, now);
+    resource->stats.in_use--;
+    KitchenWaiter* waiter = resource->head;
+    if (waiter != NULL) {
+        // Hand the unit over, only the first waiter wakes up
+        resource->head = waiter->next;
+        if (resource->head == NULL) {
+            resource->tail = NULL;
+        }
+        resource->stats.contended++;
+        account_taken(resource, now, now - waiter->since);
+        waiter->granted = 1;
+        if (waiter->on_grant != NULL) {
+            waiter->on_grant(waiter);
+        } else {
+            pthread_cond_signal(&waiter->cond);
+        }
+    } else {
+        resource->available++;
+    }
+    pthread_mutex_unlock(&resource->mutex);
+}
+
+void resource_get_stats(KitchenResource* resource, ResourceStats* stats) {
+    pthread_mutex_lock(&resource->mutex);
+    account_busy(resource, kitchen_clock());
+    *stats = resource->stats;
+    pthread_mutex_unlock(&resource->mutex);
+}
+
+void resource_destroy(KitchenResource* resource) {
+    pthread_mutex_destroy(&resource->mutex);
+}
+
+int kitchen_init(int apparatus_count, int oven_slots, int door_model) {
+    if (apparatus_count < 1 || oven_slots < 1 || (door_model != KITCHEN_ONE_DOOR && door_model != KITCHEN_TWO_DOOR)) {
+        fprintf(stderr, "Invalid kitchen configuration\n");
+        return -1;
+    }
+    door_count = door_model;
+    resource_init(&apparatus, "apparatus", apparatus_count);
+    resource_init(&oven, "oven", oven_slots);
+    resource_init(&doors[0], door_count == KITCHEN_ONE_DOOR ? "door" : "insert door", 1);
+    resource_init(&doors[1], "remove door", 1);
+    start_time = kitchen_clock();
+    return 0;
+}
+
+// Resources are always taken in the order oven, apparatus, door, so two
+// cooks can never hold what the other one waits for. A tool is only needed
+// to slide the pide in or out; the oven slot is held for the whole bake.
+typedef struct {
+    int resource;
+    int take; // 0: release
+} KitchenStep;
+
+enum { STEP_OVEN, STEP_APPARATUS, STEP_INSERT_DOOR, STEP_REMOVE_DOOR };
+
+#define PASS_STEPS 5
+
+static const KitchenStep pass_steps[2][PASS_STEPS] = {
+    { { STEP_OVEN, 1 }, { STEP_APPARATUS, 1 }, { STEP_INSERT_DOOR, 1 }, { STEP_INSERT_DOOR, 0 }, { STEP_APPARATUS, 0 } },
+    { { STEP_APPARATUS, 1 }, { STEP_REMOVE_DOOR, 1 }, { STEP_REMOVE_DOOR, 0 }, { STEP_APPARATUS, 0 }, { STEP_OVEN, 0 } },
+};
+
+static KitchenResource* step_resource(int resource) {
+    switch (resource) {
+        case STEP_OVEN:
+            return &oven;
+        case STEP_APPARATUS:
+            return &apparatus;
+        case STEP_REMOVE_DOOR:
+            return &doors[door_count == KITCHEN_TWO_DOOR ? 1 : 0];
+        default:
+            return &doors[0];
+    }
+}
+
+void kitchen_pass_init(KitchenPass* pass, void (*on_grant)(KitchenWaiter* waiter), int owner) {
+    memset(pass, 0, sizeof(*pass));
+    pthread_cond_init(&pass->waiter.cond, NULL);
+    pass->waiter.on_grant = on_grant;
+    pass->waiter.owner = owner;
+    pass->next = PASS_STEPS;
+}
+
+void kitchen_pass_begin(KitchenPass* pass, int direction, double priority) {
+    pass->direction = direction;
+    pass->next = 0;
+    pass->queued = NULL;
+    pass->waiter.priority = priority;
+}
+
+int kitchen_pass_run(KitchenPass* pass) {
+    if (pass->queued != NULL) {
+        if (!pass->waiter.granted) {
+            return 0;
+        }
+        // The releaser already counted it as ours
+        pass->queued = NULL;
+        pass->next++;
+    }
+    while (pass->next < PASS_STEPS) {
+        const KitchenStep* step = &pass_steps[pass->direction][pass->next];
+        KitchenResource* resource = step_resource(step->resource);
+        if (!step->take) {
+            resource_release(resource);
+        } else if (!resource_try_acquire(resource, &pass->waiter)) {
+            pass->queued = resource;
+            return 0;
+        }
+        pass->next++;
+    }
+    return 1;
+}
+
+void kitchen_pass_wait(KitchenPass* pass) {
+    KitchenResource* resource = pass->queued;
+    if (resource == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&resource->mutex);
+    while (!pass->waiter.granted && !pass->waiter.woken) {
+        pthread_cond_wait(&pass->waiter.cond, &resource->mutex);
+    }
+    pass->waiter.woken = 0;
+    pthread_mutex_unlock(&resource->mutex);
+}
+
+// The owner may queue or be granted meanwhile, so every queue is searched
+// under its own lock instead of trusting pass->queued
+void kitchen_pass_wake(KitchenPass* pass) {
+    KitchenResource* resources[] = { &oven, &apparatus, &doors[0], &doors[1] };
+    for (int i = 0; i < 4; ++i) {
+        pthread_mutex_lock(&resources[i]->mutex);
+        for (KitchenWaiter* waiter = resources[i]->head; waiter != NULL; waiter = waiter->next) {
+            if (waiter == &pass->waiter) {
+                waiter->woken = 1;
+                pthread_cond_signal(&waiter->cond);
+                break;
+            }
+        }
+        pthread_mutex_unlock(&resources[i]->mutex);
+    }
+}
+
+int kitchen_pass_queued(const KitchenPass* pass) {
+    return pass->queued != NULL && !pass->waiter.granted;
+}
+
+void kitchen_pass_withdraw(KitchenPass* pass) {
+    KitchenResource* resource = pass->queued;
+    if (resource != NULL) {
+        pthread_mutex_lock(&resource->mutex);
+        if (pass->waiter.granted) {
+            pass->next++; // Handed over meanwhile, given back below
+        } else {
+            KitchenWaiter** link = &resource->head;
+            KitchenWaiter* previous = NULL;
+            while (*link != &pass->waiter) {
+                previous = *link;
+                link = &(*link)->next;
+            }
+            *link = pass->waiter.next;
+            if (resource->tail == &pass->waiter) {
+                resource->tail = previous;
+            }
+        }
+        pthread_mutex_unlock(&resource->mutex);
+        pass->queued = NULL;
+    }
+
+    // Replay the steps done so far; an unload pass starts out holding the oven
+    int held[4] = { pass->direction == KITCHEN_UNLOAD, 0, 0, 0 };
+    for (int i = 0; i < pass->next; ++i) {
+        held[pass_steps[pass->direction][i].resource] += pass_steps[pass->direction][i].take ? 1 : -1;
+    }
+    for (int r = STEP_REMOVE_DOOR; r >= STEP_OVEN; --r) {
+        if (held[r] > 0) {
+            resource_release(step_resource(r));
+        }
+    }
+    pass->next = PASS_STEPS;
+}
+
+void kitchen_pass_destroy(KitchenPass* pass) {
+    pthread_cond_destroy(&pass->waiter.cond);
+}
+
+static void run_pass(int direction, double priority) {
+    KitchenPass pass;
+    kitchen_pass_init(&pass, NULL, 0);
+    kitchen_pass_begin(&pass, direction, priority);
+    while (!kitchen_pass_run(&pass)) {
+        kitchen_pass_wait(&pass);
+    }
+    kitchen_pass_destroy(&pass);
+}
+
+void kitchen_load(double priority) {
+    run_pass(KITCHEN_LOAD, priority);
+}
+
+void kitchen_unload(double priority) {
+    run_pass(KITCHEN_UNLOAD, priority);
+}
+
+void kitchen_get_stats(KitchenStats* stats) {
+    resource_get_stats(&apparatus, &stats->apparatus);
+    resource_get_stats(&oven, &stats->oven);
+    resource_get_stats(&doors[0], &stats->insert_door);
+    if (door_count == KITCHEN_TWO_DOOR) {
+        resource_get_stats(&doors[1], &stats->remove_door);
+    } else {
+        stats->remove_door = stats->insert_door;
+    }
+    stats->uptime = kitchen_clock() - start_time;
+}
+
+static void print_resource(const char* name, const ResourceStats* stats, double uptime) {
+    printf(">   %-12s %6ld taken, %5.1f%% waited, wait avg %.3f ms max %.3f ms, occupancy avg %.2f peak %d\n",
+           name, stats->acquisitions,
+           stats->acquisitions > 0 ? 100.0 * stats->contended / stats->acquisitions : 0.0,
+           stats->acquisitions > 0 ? stats->wait_total * 1000.0 / stats->acquisitions : 0.0,
+           stats->wait_max * 1000.0,
+           uptime > 0 ? stats->busy_integral / uptime : 0.0, stats->peak);
+}
+
+void kitchen_print_stats(void) {
+    KitchenStats stats;
+    kitchen_get_stats(&stats);
+    printf("> Kitchen (%s):\n", door_count == KITCHEN_TWO_DOOR ? "two-door oven" : "one-door oven");
+    print_resource("apparatus", &stats.apparatus, stats.uptime);
+    print_resource("oven", &stats.oven, stats.uptime);
+    if (door_count == KITCHEN_TWO_DOOR) {
+        print_resource("insert door", &stats.insert_door, stats.uptime);
+        print_resource("remove door", &stats.remove_door, stats.uptime);
+    } else {
+        print_resource("door", &stats.insert_door, stats.uptime);
+    }
+}
+
+void kitchen_destroy(void) {
+    resource_destroy(&apparatus);
+    resource_destroy(&oven);
+    resource_destroy(&doors[0]);
+    resource_destroy(&doors[1]);
+}
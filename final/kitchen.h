@@ -0,0 +1,93 @@
+#ifndef KITCHEN_H
+#define KITCHEN_H
+
+#include <pthread.h>
+#include "pideshop.h"
+
+// Oven door models
+#define KITCHEN_ONE_DOOR 1 // Insert and remove share one opening (original)
+#define KITCHEN_TWO_DOOR 2 // Separate insert and remove openings
+
+// Which way a pass goes through the kitchen
+#define KITCHEN_LOAD 0
+#define KITCHEN_UNLOAD 1
+
+// A waiter parked on a resource. Threads sleep on cond; the simulation sets
+// on_grant instead and resumes the owner from there.
+typedef struct KitchenWaiter {
+    pthread_cond_t cond;
+    int granted;
+    int woken;       // Set by kitchen_pass_wake: kitchen_pass_wait returns without a grant
+    double priority; // Smaller goes first
+    double since;    // When it started waiting
+    void (*on_grant)(struct KitchenWaiter* waiter); // NULL: signal cond
+    int owner;
+    struct KitchenWaiter* next;
+} KitchenWaiter;
+
+typedef struct {
+    long acquisitions;
+    long contended;     // Acquisitions that had to wait
+    double wait_total;  // Seconds spent waiting
+    double wait_max;
+    int in_use;
+    int peak;
+    double busy_integral; // Unit-seconds in use, divided by uptime gives mean occupancy
+} ResourceStats;
+
+// Counting semaphore with a waiter queue ordered by priority, FIFO among
+// equal ones. A released unit is handed straight to the first waiter, so a
+// newcomer can never take it from under a waiter's nose.
+typedef struct {
+    const char* name;
+    int capacity;
+    int available;
+    KitchenWaiter* head;
+    KitchenWaiter* tail;
+    pthread_mutex_t mutex;
+    ResourceStats stats;
+    double last_change; // For busy_integral
+} KitchenResource;
+
+// kitchen_load or kitchen_unload one step at a time, for callers that
+// must not block: kitchen_pass_run stops where a resource has to be waited for
+typedef struct {
+    int direction;           // KITCHEN_LOAD | KITCHEN_UNLOAD
+    int next;                // Next step
+    KitchenResource* queued; // Waited on, NULL if none
+    KitchenWaiter waiter;
+} KitchenPass;
+
+typedef struct {
+    ResourceStats apparatus;
+    ResourceStats oven;
+    ResourceStats insert_door;
+    ResourceStats remove_door; // Same as insert_door with one door
+    double uptime;
+} KitchenStats;
+
+int kitchen_init(int apparatus, int oven_slots, int doors);
+void kitchen_set_clock(double (*clock)(void)); // Virtual time for the simulation, NULL: monotonic clock
+// priority: the order's deadline key under EDF, the same for all under FIFO
+void kitchen_load(double priority);   // Take an oven slot, put the pide in through the insert door
+void kitchen_unload(double priority); // Take it out through the remove door, free the slot
+void kitchen_pass_init(KitchenPass* pass, void (*on_grant)(KitchenWaiter* waiter), int owner);
+void kitchen_pass_begin(KitchenPass* pass, int direction, double priority);
+int kitchen_pass_run(KitchenPass* pass);   // 1 when done, 0 while queued for a resource
+void kitchen_pass_wait(KitchenPass* pass); // Threads: sleep until the queued resource is granted or kitchen_pass_wake
+void kitchen_pass_wake(KitchenPass* pass); // From another thread: end the owner's kitchen_pass_wait if it is queued
+int kitchen_pass_queued(const KitchenPass* pass); // Queued for a resource that is not granted yet
+void kitchen_pass_withdraw(KitchenPass* pass); // Owner: leave the queue and give back what the pass holds
+void kitchen_pass_destroy(KitchenPass* pass);
+void kitchen_get_stats(KitchenStats* stats);
+void kitchen_print_stats(void);
+void kitchen_destroy(void);
+
+void resource_init(KitchenResource* resource, const char* name, int capacity);
+int resource_try_acquire(KitchenResource* resource, KitchenWaiter* waiter); // 1 if taken, 0 if the waiter was queued
+void resource_acquire(KitchenResource* resource, double priority);
+void resource_release(KitchenResource* resource);
+void resource_get_stats(KitchenResource* resource, ResourceStats* stats);
+void resource_destroy(KitchenResource* resource);
+
+#endif
@@ -0,0 +1,127 @@
+// Oven contention benchmark: 1 to 64 cooks bake as fast as they can for a
+// fixed time, once through the kitchen resource manager and once through
+// the original shared mutex + condition variable.
+//   ./kitchen_bench [bake_us] [millis_per_run]
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "kitchen.h"
+
+#define BENCH_MAX_COOKS 64
+
+static int bake_us = 200;
+static volatile int running = 0;
+static long baked[BENCH_MAX_COOKS];
+
+static pthread_mutex_t legacy_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t legacy_cond = PTHREAD_COND_INITIALIZER;
+static int legacy_oven = 0;
+static int legacy_apparatus = APPARATUS;
+
+static void* kitchen_cook(void* arg) {
+    long id = (long)arg;
+    while (running) {
+        kitchen_load(0.0);
+        usleep(bake_us);
+        kitchen_unload(0.0);
+        baked[id]++;
+    }
+    return NULL;
+}
+
+static void* legacy_cook(void* arg) {
+    long id = (long)arg;
+    while (running) {
+        pthread_mutex_lock(&legacy_mutex);
+        while (legacy_apparatus == 0 || legacy_oven == OVEN_CAPACITY) {
+            pthread_cond_wait(&legacy_cond, &legacy_mutex);
+        }
+        legacy_apparatus--;
+        legacy_oven++;
+        pthread_mutex_unlock(&legacy_mutex);
+
+        usleep(bake_us);
+
+        pthread_mutex_lock(&legacy_mutex);
+        legacy_oven--;
+        legacy_apparatus++;
+        pthread_cond_signal(&legacy_cond);
+        pthread_mutex_unlock(&legacy_mutex);
+        baked[id]++;
+    }
+    return NULL;
+}
+
+// Jain's fairness index over per-cook counts, 1.0 when everyone baked equally
+static double fairness(int cooks) {
+    double sum = 0.0, squares = 0.0;
+    for (int i = 0; i < cooks; ++i) {
+        sum += baked[i];
+        squares += (double)baked[i] * baked[i];
+    }
+    return squares > 0 ? sum * sum / (cooks * squares) : 0.0;
+}
+
+static long run(void* (*cook)(void*), int cooks, int millis) {
+    pthread_t threads[BENCH_MAX_COOKS];
+    for (int i = 0; i < cooks; ++i) {
+        baked[i] = 0;
+    }
+    running = 1;
+    for (long i = 0; i < cooks; ++i) {
+        pthread_create(&threads[i], NULL, cook, (void*)i);
+    }
+    usleep(millis * 1000);
+    running = 0;
+    // Legacy cooks may be parked on the condition variable
+    pthread_mutex_lock(&legacy_mutex);
+    pthread_cond_broadcast(&legacy_cond);
+    pthread_mutex_unlock(&legacy_mutex);
+    for (int i = 0; i < cooks; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    long total = 0;
+    for (int i = 0; i < cooks; ++i) {
+        total += baked[i];
+    }
+    return total;
+}
+
+int main(int argc, char* argv[]) {
+    int millis = 500;
+    if (argc > 1) {
+        bake_us = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        millis = atoi(argv[2]);
+    }
+
+    printf("bake %d us, %d ms per run, oven %d, apparatus %d\n", bake_us, millis, OVEN_CAPACITY, APPARATUS);
+    printf("%5s | %12s %8s | %12s %8s | %12s %8s\n", "cooks", "legacy/s", "fair", "1-door/s", "fair", "2-door/s", "fair");
+    for (int cooks = 1; cooks <= BENCH_MAX_COOKS; cooks *= 2) {
+        long legacy = run(legacy_cook, cooks, millis);
+        double legacy_fair = fairness(cooks);
+
+        kitchen_init(APPARATUS, OVEN_CAPACITY, KITCHEN_ONE_DOOR);
+        long one_door = run(kitchen_cook, cooks, millis);
+        double one_door_fair = fairness(cooks);
+        kitchen_destroy();
+
+        kitchen_init(APPARATUS, OVEN_CAPACITY, KITCHEN_TWO_DOOR);
+        long two_door = run(kitchen_cook, cooks, millis);
+        double two_door_fair = fairness(cooks);
+        if (cooks == BENCH_MAX_COOKS) {
+            kitchen_print_stats();
+        }
+        kitchen_destroy();
+
+        printf("%5d | %12.0f %8.3f | %12.0f %8.3f | %12.0f %8.3f\n", cooks,
+               legacy * 1000.0 / millis, legacy_fair,
+               one_door * 1000.0 / millis, one_door_fair,
+               two_door * 1000.0 / millis, two_door_fair);
+    }
+    return 0;
+}
@@ -0,0 +1,593 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/time.h>
+#include "protocol.h"
+#include "loadgen.h"
+
+// Open-loop load: every order has an intended send time drawn from the
+// arrival process before the run starts. Threads send whatever is due no
+// matter how many orders are still in flight, and latency is measured from
+// the intended time, so a stalled server cannot hide its stall by slowing
+// the generator down (coordinated omission). Orders the server turns away
+// with FRAME_RETRY_AFTER go out again when it asked, still measured from
+// their first intended time, and are shed after max_retries attempts.
+
+typedef struct {
+    double intended; // Seconds after the start
+    double sent;     // First send
+    double done;     // Delivered, cancelled or shed, 0 while in flight
+    double due;      // Next send after a retry-after
+    int cancelled;
+    int shed;        // Given up after max_retries
+    int retries;
+    int customer_x, customer_y;
+} OrderTiming;
+
+// Partial frames of one socket
+typedef struct {
+    unsigned char* data;
+    size_t length;
+} FrameBuffer;
+
+typedef struct {
+    int index;
+    pid_t id;
+    int count;               // Orders of this thread: index, index + threads, ...
+    int order_socket;
+    int status_socket;
+    int completion_socket;
+    unsigned int seed;       // Customer locations
+    int settled;
+    int server_delivered;    // From FRAME_COMPLETE
+    int server_cancelled;
+    int shed;
+    FrameBuffer status;
+    FrameBuffer replies;     // FRAME_RETRY_AFTER on the order socket
+    int* retry_heap;         // Orders waiting to go out again, earliest due first
+    int retry_count;
+    pthread_t thread;
+} LoadThread;
+
+static const LoadConfig* config;
+static OrderTiming* timings = NULL;
+static LoadThread* load_threads = NULL;
+static int thread_count = 0;
+static pthread_barrier_t start_barrier;
+static struct timespec start_time;
+
+static double elapsed(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start_time.tv_sec) + (now.tv_nsec - start_time.tv_nsec) / 1e9;
+}
+
+int loadgen_parse_arrival(const char* name) {
+    if (strcmp(name, "constant") == 0) {
+        return ARRIVAL_CONSTANT;
+    }
+    if (strcmp(name, "poisson") == 0) {
+        return ARRIVAL_POISSON;
+    }
+    if (strcmp(name, "bursty") == 0) {
+        return ARRIVAL_BURSTY;
+    }
+    return -1;
+}
+
+// The whole schedule, in order. Threads take every thread_count'th order,
+// so the process they produce together is the requested one.
+static void build_schedule(void) {
+    unsigned int seed = config->seed;
+    double t = 0.0;
+    for (int i = 0; i < config->orders; ++i) {
+        if (config->arrival == ARRIVAL_CONSTANT) {
+            t = i / config->rate;
+        } else if (config->arrival == ARRIVAL_POISSON) {
+            t += -log(1.0 - rand_r(&seed) / (RAND_MAX + 1.0)) / config->rate;
+        } else if (i % config->burst_size == 0 && i > 0) {
+            t += -log(1.0 - rand_r(&seed) / (RAND_MAX + 1.0)) * config->burst_size / config->rate;
+        }
+        timings[i].intended = t;
+    }
+}
+
+static int connect_order_socket(LoadThread* self) {
+    struct sockaddr_in server_address;
+    server_address.sin_family = AF_INET;
+    server_address.sin_port = htons(config->port);
+    server_address.sin_addr.s_addr = inet_addr(config->ipaddress);
+
+    self->order_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (self->order_socket < 0 || connect(self->order_socket, (struct sockaddr*)&server_address, sizeof(server_address)) < 0) {
+        perror("Sunucuya bağlanılamadı");
+        return -1;
+    }
+
+    unsigned char hello[FRAME_HEADER_SIZE + HELLO_PAYLOAD_SIZE];
+    size_t offset = put_frame_header(hello, FRAME_HELLO, HELLO_PAYLOAD_SIZE);
+    put_u32(hello + offset, (uint32_t)self->id);
+    put_u32(hello + offset + 4, (uint32_t)self->count);
+    put_u32(hello + offset + 8, (uint32_t)config->p);
+    put_u32(hello + offset + 12, (uint32_t)config->q);
+    if (send_all(self->order_socket, hello, sizeof(hello)) < 0) {
+        perror("send");
+        return -1;
+    }
+    return 0;
+}
+
+static OrderTiming* timing_of(LoadThread* self, int order) {
+    return &timings[order * thread_count + self->index];
+}
+
+static void settle(LoadThread* self, uint32_t order_id, int cancelled, double now) {
+    if (order_id < 1 || order_id > (uint32_t)self->count) {
+        return;
+    }
+    OrderTiming* timing = timing_of(self, (int)order_id - 1);
+    if (timing->done == 0) {
+        timing->done = now;
+        timing->cancelled = cancelled;
+        self->settled++;
+    }
+}
+
+// Binary min-heap of this thread's order numbers keyed by due time
+static void retry_push(LoadThread* self, int order) {
+    int child = self->retry_count++;
+    while (child > 0) {
+        int parent = (child - 1) / 2;
+        if (timing_of(self, self->retry_heap[parent])->due <= timing_of(self, order)->due) {
+            break;
+        }
+        self->retry_heap[child] = self->retry_heap[parent];
+        child = parent;
+    }
+    self->retry_heap[child] = order;
+}
+
+static int retry_pop(LoadThread* self) {
+    int top = self->retry_heap[0];
+    int last = self->retry_heap[--self->retry_count];
+    int parent = 0;
+    while (1) {
+        int child = 2 * parent + 1;
+        if (child >= self->retry_count) {
+            break;
+        }
+        if (child + 1 < self->retry_count && timing_of(self, self->retry_heap[child + 1])->due < timing_of(self, self->retry_heap[child])->due) {
+            child++;
+        }
+        if (timing_of(self, last)->due <= timing_of(self, self->retry_heap[child])->due) {
+            break;
+        }
+        self->retry_heap[parent] = self->retry_heap[child];
+        parent = child;
+    }
+    self->retry_heap[parent] = last;
+    return top;
+}
+
+// The server did not take these orders; send them again when it asked,
+// unless they already used up their attempts
+static void schedule_retries(LoadThread* self, const unsigned char* payload, double now) {
+    uint32_t retry_ms = get_u32(payload + 4);
+    uint32_t count = get_u32(payload + 8);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t order_id = get_u32(payload + RETRY_HEADER_SIZE + i * RETRY_ENTRY_SIZE);
+        if (order_id < 1 || order_id > (uint32_t)self->count) {
+            continue;
+        }
+        OrderTiming* timing = timing_of(self, (int)order_id - 1);
+        if (timing->done != 0) {
+            continue;
+        }
+        if (++timing->retries > config->max_retries) {
+            timing->done = now;
+            timing->shed = 1;
+            self->shed++;
+            self->settled++;
+            continue;
+        }
+        timing->due = now + retry_ms / 1000.0;
+        retry_push(self, (int)order_id - 1);
+    }
+}
+
+// Drains a socket and handles every complete frame. Returns -1 once the
+// server closed it.
+static int read_frames(LoadThread* self, int socket, FrameBuffer* buffer) {
+    while (1) {
+        ssize_t n = recv(socket, buffer->data + buffer->length, FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD - buffer->length, MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+            return -1;
+        }
+        if (n < 0) {
+            return errno == EAGAIN ? 0 : -1;
+        }
+        buffer->length += (size_t)n;
+
+        double now = elapsed();
+        size_t used = 0;
+        while (buffer->length - used >= FRAME_HEADER_SIZE) {
+            const unsigned char* header = buffer->data + used;
+            uint32_t length = get_u32(header);
+            if (header[4] != PROTOCOL_VERSION || length > FRAME_MAX_PAYLOAD) {
+                return -1;
+            }
+            if (buffer->length - used < FRAME_HEADER_SIZE + length) {
+                break;
+            }
+            const unsigned char* payload = header + FRAME_HEADER_SIZE;
+            if (header[5] == FRAME_STATUS_BATCH && length >= STATUS_HEADER_SIZE) {
+                uint32_t count = get_u32(payload);
+                if (count > (length - STATUS_HEADER_SIZE) / STATUS_ENTRY_SIZE) {
+                    return -1;
+                }
+                for (uint32_t i = 0; i < count; ++i) {
+                    const unsigned char* entry = payload + STATUS_HEADER_SIZE + i * STATUS_ENTRY_SIZE;
+                    uint32_t state = get_u32(entry + 8);
+                    if (get_u32(entry) == (uint32_t)self->id && (state == STATE_COMPLETED || state == STATE_CANCELLED)) {
+                        settle(self, get_u32(entry + 4), state == STATE_CANCELLED, now);
+                    }
+                }
+            } else if (header[5] == FRAME_RETRY_AFTER && length >= RETRY_HEADER_SIZE) {
+                if (get_u32(payload + 8) > (length - RETRY_HEADER_SIZE) / RETRY_ENTRY_SIZE) {
+                    return -1;
+                }
+                schedule_retries(self, payload, now);
+            }
+            used += FRAME_HEADER_SIZE + length;
+        }
+        memmove(buffer->data, buffer->data + used, buffer->length - used);
+        buffer->length -= used;
+    }
+}
+
+static void put_order(LoadThread* self, unsigned char* entry, int order) {
+    OrderTiming* timing = timing_of(self, order);
+    put_u32(entry, (uint32_t)(order + 1));
+    put_u32(entry + 4, (uint32_t)timing->customer_x);
+    put_u32(entry + 8, (uint32_t)timing->customer_y);
+}
+
+// Shed orders never reach the server; cancelling what is left once
+// everything else settled lets the session finish
+static void finish_session(LoadThread* self) {
+    unsigned char frame[FRAME_HEADER_SIZE + CANCEL_PAYLOAD_SIZE];
+    size_t offset = put_frame_header(frame, FRAME_CANCEL, CANCEL_PAYLOAD_SIZE);
+    put_u32(frame + offset, (uint32_t)self->id);
+    put_u32(frame + offset + 4, 0);
+    send_all(self->order_socket, frame, sizeof(frame));
+}
+
+static void read_complete(LoadThread* self) {
+    unsigned char complete[FRAME_HEADER_SIZE + COMPLETE_PAYLOAD_SIZE];
+    ssize_t n = recv(self->completion_socket, complete, sizeof(complete), MSG_WAITALL);
+    if (n == (ssize_t)sizeof(complete) && complete[5] == FRAME_COMPLETE) {
+        self->server_delivered = (int)get_u32(complete + FRAME_HEADER_SIZE + 4);
+        self->server_cancelled = (int)get_u32(complete + FRAME_HEADER_SIZE + 8);
+    }
+}
+
+static void* load_thread(void* arg) {
+    LoadThread* self = arg;
+    unsigned char* frame = malloc(FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD);
+    int epoll_fd = epoll_create1(0);
+    if (frame == NULL || epoll_fd < 0) {
+        perror("Yük üreteci başlatılamadı");
+        exit(EXIT_FAILURE);
+    }
+    struct epoll_event event = { .events = EPOLLIN };
+    event.data.fd = self->status_socket;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, self->status_socket, &event);
+    event.data.fd = self->completion_socket;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, self->completion_socket, &event);
+    event.data.fd = self->order_socket;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, self->order_socket, &event);
+
+    if (pthread_barrier_wait(&start_barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+        clock_gettime(CLOCK_MONOTONIC, &start_time);
+    }
+    pthread_barrier_wait(&start_barrier);
+
+    int next = 0;
+    int watching = 2; // Status and completion sockets still open
+    double give_up = 0; // Set by FRAME_COMPLETE: the last status events may still be on the way
+    while (self->settled < self->count) {
+        double now = elapsed();
+        if ((give_up > 0 && now >= give_up) || (watching == 0 && next == self->count && self->retry_count == 0)) {
+            break;
+        }
+
+        // Everything that is due goes out in one batch, however late we are
+        int first = next;
+        int batched = 0;
+        size_t offset = put_frame_header(frame, FRAME_ORDER_BATCH, 0) + BATCH_HEADER_SIZE;
+        while (self->retry_count > 0 && batched < BATCH_MAX_ORDERS && timing_of(self, self->retry_heap[0])->due <= now) {
+            put_order(self, frame + offset, retry_pop(self));
+            offset += BATCH_ENTRY_SIZE;
+            batched++;
+        }
+        while (next < self->count && batched < BATCH_MAX_ORDERS && timing_of(self, next)->intended <= now) {
+            OrderTiming* timing = timing_of(self, next);
+            timing->customer_x = rand_r(&self->seed) % config->p;
+            timing->customer_y = rand_r(&self->seed) % config->q;
+            put_order(self, frame + offset, next);
+            offset += BATCH_ENTRY_SIZE;
+            batched++;
+            next++;
+        }
+        if (batched > 0) {
+            put_frame_header(frame, FRAME_ORDER_BATCH, (uint32_t)(offset - FRAME_HEADER_SIZE));
+            put_u32(frame + FRAME_HEADER_SIZE, (uint32_t)self->id);
+            put_u32(frame + FRAME_HEADER_SIZE + 4, (uint32_t)batched);
+            if (send_all(self->order_socket, frame, offset) < 0) {
+                perror("send");
+                break;
+            }
+            double sent = elapsed();
+            for (int i = first; i < next; ++i) {
+                timing_of(self, i)->sent = sent;
+            }
+        }
+
+        int timeout = -1;
+        double wake = next < self->count ? timing_of(self, next)->intended : -1;
+        if (self->retry_count > 0 && (wake < 0 || timing_of(self, self->retry_heap[0])->due < wake)) {
+            wake = timing_of(self, self->retry_heap[0])->due;
+        }
+        if (wake >= 0) {
+            double wait = wake - elapsed();
+            timeout = wait > 0 ? (int)ceil(wait * 1000.0) : 0;
+        }
+        if (give_up > 0) {
+            int remaining = (int)ceil((give_up - elapsed()) * 1000.0);
+            timeout = timeout < 0 || remaining < timeout ? remaining : timeout;
+        }
+
+        struct epoll_event events[3];
+        int ready = epoll_wait(epoll_fd, events, 3, timeout < 0 ? -1 : timeout);
+        for (int i = 0; i < ready; ++i) {
+            if (events[i].data.fd == self->status_socket) {
+                if (read_frames(self, self->status_socket, &self->status) < 0) {
+                    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, self->status_socket, NULL);
+                    watching--;
+                }
+            } else if (events[i].data.fd == self->order_socket) {
+                if (read_frames(self, self->order_socket, &self->replies) < 0) {
+                    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, self->order_socket, NULL);
+                }
+            } else {
+                read_complete(self);
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, self->completion_socket, NULL);
+                watching--;
+                give_up = elapsed() + 1.0;
+            }
+        }
+    }
+    if (self->shed > 0 && give_up == 0) {
+        finish_session(self);
+        struct timeval wait = { 1, 0 };
+        setsockopt(self->completion_socket, SOL_SOCKET, SO_RCVTIMEO, &wait, sizeof(wait));
+        read_complete(self);
+    }
+
+    close(epoll_fd);
+    free(frame);
+    return NULL;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Nearest rank on sorted values
+static double percentile(const double* sorted, int n, double q) {
+    if (n == 0) {
+        return 0.0;
+    }
+    int rank = (int)ceil(q * n);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void print_percentiles(const char* label, double* values, int n) {
+    qsort(values, n, sizeof(double), compare_double);
+    printf("> %-13s p50 %9.3f  p90 %9.3f  p99 %9.3f  p99.9 %9.3f  max %9.3f ms\n", label, percentile(values, n, 0.5) * 1000,
+           percentile(values, n, 0.9) * 1000, percentile(values, n, 0.99) * 1000, percentile(values, n, 0.999) * 1000,
+           n > 0 ? values[n - 1] * 1000 : 0.0);
+}
+
+// One row per second of the run: what was due, sent and finished in it,
+// and the latency of the orders that finished
+static int write_csv(const char* path, double end) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        perror("CSV dosyası açılamadı");
+        return -1;
+    }
+    int seconds = (int)end + 1;
+    int* scheduled = calloc(seconds, sizeof(int));
+    int* sent = calloc(seconds, sizeof(int));
+    int* finished = calloc(seconds, sizeof(int));
+    int* cancelled = calloc(seconds, sizeof(int));
+    int* shed = calloc(seconds, sizeof(int));
+    double* latencies = malloc(config->orders * sizeof(double));
+    if (scheduled == NULL || sent == NULL || finished == NULL || cancelled == NULL || shed == NULL || latencies == NULL) {
+        perror("malloc");
+        fclose(file);
+        return -1;
+    }
+    for (int i = 0; i < config->orders; ++i) {
+        int s = (int)timings[i].intended;
+        scheduled[s < seconds ? s : seconds - 1]++;
+        if (timings[i].sent > 0) {
+            s = (int)timings[i].sent;
+            sent[s < seconds ? s : seconds - 1]++;
+        }
+        if (timings[i].done > 0) {
+            s = (int)timings[i].done;
+            if (timings[i].shed) {
+                shed[s < seconds ? s : seconds - 1]++;
+            } else if (timings[i].cancelled) {
+                cancelled[s < seconds ? s : seconds - 1]++;
+            } else {
+                finished[s < seconds ? s : seconds - 1]++;
+            }
+        }
+    }
+
+    fprintf(file, "second,scheduled,sent,delivered,cancelled,p50_ms,p90_ms,p99_ms,max_ms,shed\n");
+    for (int s = 0; s < seconds; ++s) {
+        int n = 0;
+        for (int i = 0; i < config->orders; ++i) {
+            if (timings[i].done > 0 && !timings[i].cancelled && !timings[i].shed && (int)timings[i].done == s) {
+                latencies[n++] = timings[i].done - timings[i].intended;
+            }
+        }
+        qsort(latencies, n, sizeof(double), compare_double);
+        fprintf(file, "%d,%d,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%d\n", s, scheduled[s], sent[s], finished[s], cancelled[s],
+                percentile(latencies, n, 0.5) * 1000, percentile(latencies, n, 0.9) * 1000, percentile(latencies, n, 0.99) * 1000,
+                n > 0 ? latencies[n - 1] * 1000 : 0.0, shed[s]);
+    }
+
+    free(scheduled);
+    free(sent);
+    free(finished);
+    free(cancelled);
+    free(shed);
+    free(latencies);
+    fclose(file);
+    return 0;
+}
+
+static void report(double end) {
+    double* from_intended = malloc(config->orders * sizeof(double));
+    double* from_sent = malloc(config->orders * sizeof(double));
+    if (from_intended == NULL || from_sent == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    int delivered = 0, cancelled = 0, unsent = 0, shed = 0, retried = 0;
+    long retries = 0;
+    double max_lag = 0.0;
+    for (int i = 0; i < config->orders; ++i) {
+        retries += timings[i].retries;
+        retried += timings[i].retries > 0;
+        if (timings[i].sent == 0) {
+            unsent++;
+            continue;
+        }
+        if (timings[i].shed) {
+            shed++;
+            continue;
+        }
+        if (timings[i].sent - timings[i].intended > max_lag) {
+            max_lag = timings[i].sent - timings[i].intended;
+        }
+        if (timings[i].cancelled) {
+            cancelled++;
+        } else if (timings[i].done > 0) {
+            from_intended[delivered] = timings[i].done - timings[i].intended;
+            from_sent[delivered] = timings[i].done - timings[i].sent;
+            delivered++;
+        }
+    }
+    int server_delivered = 0;
+    for (int t = 0; t < thread_count; ++t) {
+        server_delivered += load_threads[t].server_delivered;
+    }
+
+    static const char* arrival_names[] = { "constant", "poisson", "bursty" };
+    printf("> %d orders, %s arrivals at %.1f/s over %d threads, %.3f s\n", config->orders, arrival_names[config->arrival], config->rate,
+           thread_count, end);
+    printf("> delivered %d (server says %d), cancelled %d, shed %d, no status %d, not sent %d\n", delivered, server_delivered,
+           cancelled, shed, config->orders - unsent - delivered - cancelled - shed, unsent);
+    if (retries > 0) {
+        printf("> turned away %ld times, %d orders sent again at least once\n", retries, retried);
+    }
+    printf("> worst send lag behind schedule: %.3f ms\n", max_lag * 1000);
+    print_percentiles("from schedule", from_intended, delivered);
+    print_percentiles("from send", from_sent, delivered);
+    free(from_intended);
+    free(from_sent);
+}
+
+int loadgen_run(const LoadConfig* load_config) {
+    config = load_config;
+    thread_count = config->threads < config->orders ? config->threads : config->orders;
+    timings = calloc(config->orders, sizeof(OrderTiming));
+    load_threads = calloc(thread_count, sizeof(LoadThread));
+    if (timings == NULL || load_threads == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    build_schedule();
+
+    for (int t = 0; t < thread_count; ++t) {
+        LoadThread* self = &load_threads[t];
+        self->index = t;
+        self->seed = config->seed + t + 1;
+        self->id = (getpid() << 6) | t;
+        self->count = (config->orders - t + thread_count - 1) / thread_count;
+        self->order_socket = self->status_socket = self->completion_socket = -1;
+        self->status.data = malloc(FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD);
+        self->replies.data = malloc(FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD);
+        self->retry_heap = malloc(self->count * sizeof(int));
+        // Subscribe before HELLO so no status event or the completion push is missed
+        self->status_socket = subscribe(config->ipaddress, config->port + 1, self->id);
+        self->completion_socket = subscribe(config->ipaddress, config->port + 2, self->id);
+        if (self->status.data == NULL || self->replies.data == NULL || self->retry_heap == NULL || self->status_socket < 0 || self->completion_socket < 0 || connect_order_socket(self) < 0) {
+            return -1;
+        }
+    }
+
+    pthread_barrier_init(&start_barrier, NULL, thread_count);
+    for (int t = 0; t < thread_count; ++t) {
+        if (pthread_create(&load_threads[t].thread, NULL, load_thread, &load_threads[t]) != 0) {
+            perror("pthread_create");
+            return -1;
+        }
+    }
+    for (int t = 0; t < thread_count; ++t) {
+        pthread_join(load_threads[t].thread, NULL);
+    }
+    double end = elapsed();
+    pthread_barrier_destroy(&start_barrier);
+
+    report(end);
+    int rc = config->csv_path != NULL ? write_csv(config->csv_path, end) : 0;
+
+    for (int t = 0; t < thread_count; ++t) {
+        close(load_threads[t].order_socket);
+        close(load_threads[t].status_socket);
+        close(load_threads[t].completion_socket);
+        free(load_threads[t].status.data);
+        free(load_threads[t].replies.data);
+        free(load_threads[t].retry_heap);
+    }
+    free(load_threads);
+    free(timings);
+    load_threads = NULL;
+    return rc;
+}
+
+void loadgen_cancel_all(void) {
+    for (int t = 0; load_threads != NULL && t < thread_count; ++t) {
+        unsigned char frame[FRAME_HEADER_SIZE + CANCEL_PAYLOAD_SIZE];
+        size_t offset = put_frame_header(frame, FRAME_CANCEL, CANCEL_PAYLOAD_SIZE);
+        put_u32(frame + offset, (uint32_t)load_threads[t].id);
+        put_u32(frame + offset + 4, 0);
+        send(load_threads[t].order_socket, frame, sizeof(frame), MSG_NOSIGNAL);
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+#include <sys/types.h>
+
+#define LOAD_MAX_THREADS 64     // Session ids are pid << 6 | thread
+#define LOAD_DEFAULT_BURST 10
+#define LOAD_DEFAULT_RETRIES 3
+
+#define ARRIVAL_CONSTANT 0
+#define ARRIVAL_POISSON 1
+#define ARRIVAL_BURSTY 2 // Poisson bursts of burst_size orders, same mean rate
+
+typedef struct {
+    const char* ipaddress;
+    int port;
+    int orders;       // Total over all threads
+    int p, q;
+    int threads;      // One order connection and one status subscription each
+    double rate;      // Orders per second over all threads
+    int arrival;      // ARRIVAL_*
+    int burst_size;
+    const char* csv_path; // Per-second time series, NULL for none
+    unsigned int seed;
+    int max_retries;  // Sends after a FRAME_RETRY_AFTER before an order is shed
+} LoadConfig;
+
+int loadgen_parse_arrival(const char* name); // -1 if unknown
+int loadgen_run(const LoadConfig* config);
+void loadgen_cancel_all(void); // From the signal handler
+
+// From client.c
+int subscribe(const char* ipaddress, int port, pid_t pid);
+int send_all(int socket, const void* data, size_t length);
+
+#endif
@@ -0,0 +1,350 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <sys/uio.h>
+#include "uring.h"
+#include "logger.h"
+
+// Single-producer/single-consumer byte ring owned by one thread.
+// head is only written by the owner, tail only by the flusher.
+typedef struct LogBuffer {
+    _Alignas(64) atomic_size_t head;
+    _Alignas(64) atomic_size_t tail;
+    struct LogBuffer* next;
+    uint32_t id;
+    char data[LOG_BUFFER_SIZE];
+} LogBuffer;
+
+static _Atomic(LogBuffer*) buffers = NULL; // Lock-free push-only list
+static atomic_uint buffer_count = 0;
+static __thread LogBuffer* local_buffer = NULL;
+
+static LoggerConfig config = { LOG_FLUSH_INTERVAL_MS, LOG_DURABILITY_NONE, LOG_FORMAT_TEXT, 0 };
+static int log_fd = -1;
+static Uring log_ring = { .fd = -1 }; // Used under flush_mutex only
+static atomic_int running = 0;
+static pthread_t flusher_thread;
+static pthread_mutex_t flush_mutex = PTHREAD_MUTEX_INITIALIZER; // Flusher vs. shutdown drain
+static pthread_mutex_t wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake_cond = PTHREAD_COND_INITIALIZER;
+static int wake_pending = 0;
+
+static void wake_flusher(void) {
+    pthread_mutex_lock(&wake_mutex);
+    wake_pending = 1;
+    pthread_cond_signal(&wake_cond);
+    pthread_mutex_unlock(&wake_mutex);
+}
+
+static LogBuffer* get_local_buffer(void) {
+    if (local_buffer != NULL) {
+        return local_buffer;
+    }
+
+    LogBuffer* buffer = aligned_alloc(64, sizeof(LogBuffer));
+    if (buffer == NULL) {
+        perror("Failed to allocate log buffer");
+        return NULL;
+    }
+    atomic_init(&buffer->head, 0);
+    atomic_init(&buffer->tail, 0);
+    buffer->id = atomic_fetch_add(&buffer_count, 1);
+
+    LogBuffer* first = atomic_load(&buffers);
+    do {
+        buffer->next = first;
+    } while (!atomic_compare_exchange_weak(&buffers, &first, buffer));
+
+    local_buffer = buffer;
+    return buffer;
+}
+
+static void copy_in(LogBuffer* buffer, size_t pos, const void* src, size_t n) {
+    size_t offset = pos & (LOG_BUFFER_SIZE - 1);
+    size_t first = LOG_BUFFER_SIZE - offset;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(buffer->data + offset, src, first);
+    memcpy(buffer->data, (const char*)src + first, n - first);
+}
+
+// Write every iovec completely, retrying on short writes
+static void write_fully(struct iovec* iov, int count) {
+    while (count > 0) {
+        ssize_t written = writev(log_fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("writev");
+            return;
+        }
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+// Write one batch and, for LOG_DURABILITY_FLUSH, make it durable. With
+// io_uring the fdatasync is linked behind the writev and both go in one
+// io_uring_enter; a short write breaks the link and is finished by hand.
+static void write_batch(struct iovec* iov, int count, int sync) {
+    if (log_ring.fd < 0) {
+        write_fully(iov, count);
+        if (sync) {
+            fdatasync(log_fd);
+        }
+        return;
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < count; ++i) {
+        total += iov[i].iov_len;
+    }
+    struct io_uring_sqe* sqe = uring_get_sqe(&log_ring);
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd = log_fd;
+    sqe->addr = (unsigned long)iov;
+    sqe->len = (unsigned)count;
+    sqe->off = (__u64)-1; // File position, O_APPEND anyway
+    if (sync) {
+        sqe->flags = IOSQE_IO_LINK;
+        sqe = uring_get_sqe(&log_ring);
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = log_fd;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        sqe->user_data = 1;
+    }
+
+    ssize_t written = -1;
+    int synced = 0;
+    if (uring_submit(&log_ring, sync ? 2 : 1) < 0) {
+        perror("io_uring_enter");
+    } else {
+        for (int i = 0; i < (sync ? 2 : 1); ++i) {
+            struct io_uring_cqe* cqe = uring_peek(&log_ring);
+            if (cqe->user_data == 0) {
+                written = cqe->res;
+            } else {
+                synced = cqe->res == 0;
+            }
+            uring_seen(&log_ring);
+        }
+    }
+
+    if (written < (ssize_t)total) {
+        while (count > 0 && written > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0 && written > 0) {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+        write_fully(iov, count);
+    }
+    if (sync && !synced) {
+        fdatasync(log_fd);
+    }
+}
+
+// Coalesce everything staged in all thread buffers into writev calls
+static void flush_all(void) {
+    struct iovec iov[LOG_MAX_IOVECS];
+    LogBuffer* owners[LOG_MAX_IOVECS / 2];
+    size_t new_tails[LOG_MAX_IOVECS / 2];
+    int iov_count = 0;
+    int owner_count = 0;
+
+    pthread_mutex_lock(&flush_mutex);
+    if (log_fd < 0) {
+        pthread_mutex_unlock(&flush_mutex);
+        return;
+    }
+
+    for (LogBuffer* buffer = atomic_load(&buffers); buffer != NULL; buffer = buffer->next) {
+        size_t tail = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        if (head == tail) {
+            continue;
+        }
+
+        // A wrapped region needs two iovecs
+        size_t offset = tail & (LOG_BUFFER_SIZE - 1);
+        size_t length = head - tail;
+        size_t first = LOG_BUFFER_SIZE - offset;
+        if (first > length) {
+            first = length;
+        }
+        iov[iov_count].iov_base = buffer->data + offset;
+        iov[iov_count++].iov_len = first;
+        if (length > first) {
+            iov[iov_count].iov_base = buffer->data;
+            iov[iov_count++].iov_len = length - first;
+        }
+        owners[owner_count] = buffer;
+        new_tails[owner_count++] = head;
+
+        if (iov_count > LOG_MAX_IOVECS - 2) {
+            write_batch(iov, iov_count, 0);
+            for (int i = 0; i < owner_count; ++i) {
+                atomic_store_explicit(&owners[i]->tail, new_tails[i], memory_order_release);
+            }
+            iov_count = owner_count = 0;
+        }
+    }
+
+    int sync = config.durability == LOG_DURABILITY_FLUSH;
+    if (iov_count > 0) {
+        write_batch(iov, iov_count, sync);
+        for (int i = 0; i < owner_count; ++i) {
+            atomic_store_explicit(&owners[i]->tail, new_tails[i], memory_order_release);
+        }
+    } else if (sync) {
+        fdatasync(log_fd);
+    }
+    pthread_mutex_unlock(&flush_mutex);
+}
+
+static void* flusher_function(void* arg) {
+    (void)arg;
+    // SIGINT/SIGTERM are blocked by main before this thread starts and taken
+    // by handle_signals with sigwait, so flush_mutex is never held by a handler
+    while (atomic_load(&running)) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += config.flush_interval_ms / 1000;
+        deadline.tv_nsec += (long)(config.flush_interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&wake_mutex);
+        while (!wake_pending && atomic_load(&running)) {
+            if (pthread_cond_timedwait(&wake_cond, &wake_mutex, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        wake_pending = 0;
+        pthread_mutex_unlock(&wake_mutex);
+
+        flush_all();
+    }
+    return NULL;
+}
+
+int logger_init(const char* path, const LoggerConfig* new_config) {
+    if (new_config != NULL) {
+        config = *new_config;
+    }
+    if (config.flush_interval_ms <= 0) {
+        config.flush_interval_ms = LOG_FLUSH_INTERVAL_MS;
+    }
+
+    // Log dosyası her çalıştırmada temizlenir
+    log_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (log_fd < 0) {
+        perror("open log file");
+        return -1;
+    }
+    if (config.use_uring && uring_init(&log_ring, 8) < 0) {
+        perror("io_uring_setup");
+        log_ring.fd = -1;
+    }
+
+    atomic_store(&running, 1);
+    if (pthread_create(&flusher_thread, NULL, flusher_function, NULL) != 0) {
+        perror("pthread_create");
+        atomic_store(&running, 0);
+        return -1;
+    }
+    pthread_detach(flusher_thread);
+    return 0;
+}
+
+void logger_write(const char* message) {
+    size_t length = strlen(message);
+    if (length > LOG_BUFFER_SIZE / 4) {
+        length = LOG_BUFFER_SIZE / 4;
+    }
+
+    LogBuffer* buffer = atomic_load(&running) ? get_local_buffer() : NULL;
+    if (buffer == NULL) {
+        // Logger is not running (or shutting down): write straight through
+        if (log_fd >= 0) {
+            struct iovec iov[2] = { { (void*)message, length }, { "\n", 1 } };
+            write_fully(iov, 2);
+        }
+        return;
+    }
+
+    size_t record_size = (config.format == LOG_FORMAT_BINARY) ? sizeof(LogRecordHeader) + length : length + 1;
+    size_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+
+    // Wait for the flusher instead of dropping the record
+    while (LOG_BUFFER_SIZE - (head - atomic_load_explicit(&buffer->tail, memory_order_acquire)) < record_size) {
+        if (!atomic_load(&running)) {
+            return; // Flusher is gone, nothing will make room
+        }
+        wake_flusher();
+        sched_yield();
+    }
+
+    if (config.format == LOG_FORMAT_BINARY) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        LogRecordHeader header;
+        header.timestamp_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+        header.thread_id = buffer->id;
+        header.length = (uint32_t)length;
+        copy_in(buffer, head, &header, sizeof(header));
+        copy_in(buffer, head + sizeof(header), message, length);
+    } else {
+        copy_in(buffer, head, message, length);
+        copy_in(buffer, head + length, "\n", 1);
+    }
+    atomic_store_explicit(&buffer->head, head + record_size, memory_order_release);
+
+    // Flush early when a buffer is half full
+    if (head + record_size - atomic_load_explicit(&buffer->tail, memory_order_relaxed) > LOG_BUFFER_SIZE / 2) {
+        wake_flusher();
+    }
+}
+
+// Drain every committed record and close the file. Takes wake_mutex and
+// flush_mutex, so call it from a thread, never from a signal handler.
+void logger_shutdown(void) {
+    if (!atomic_exchange(&running, 0)) {
+        return;
+    }
+    wake_flusher();
+    flush_all();
+
+    pthread_mutex_lock(&flush_mutex);
+    if (log_fd >= 0) {
+        fdatasync(log_fd);
+        close(log_fd);
+        log_fd = -1;
+    }
+    if (log_ring.fd >= 0) {
+        uring_exit(&log_ring);
+    }
+    pthread_mutex_unlock(&flush_mutex);
+    // Staging buffers stay allocated: other threads may still hold them until exit
+}
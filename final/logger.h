@@ -0,0 +1,37 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LOG_FILE_NAME "pide_shop.log"
+#define LOG_BUFFER_SIZE (64 * 1024)  // Per-thread staging buffer, power of two
+#define LOG_FLUSH_INTERVAL_MS 100
+#define LOG_MAX_IOVECS 64
+
+// Durability levels
+#define LOG_DURABILITY_NONE 0  // write() only, page cache decides
+#define LOG_DURABILITY_FLUSH 1 // fdatasync after every flush cycle
+
+// Record formats
+#define LOG_FORMAT_TEXT 0   // "message\n"
+#define LOG_FORMAT_BINARY 1 // LogRecordHeader followed by the message bytes
+
+typedef struct {
+    uint64_t timestamp_ns; // CLOCK_REALTIME
+    uint32_t thread_id;    // Index of the staging buffer
+    uint32_t length;       // Message bytes after the header
+} LogRecordHeader;
+
+typedef struct {
+    int flush_interval_ms;
+    int durability;
+    int format;
+    int use_uring; // Flush as one writev linked to its fdatasync, one io_uring_enter per cycle
+} LoggerConfig;
+
+int logger_init(const char* path, const LoggerConfig* config);
+void logger_write(const char* message);
+void logger_shutdown(void);
+
+#endif
@@ -0,0 +1,368 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <immintrin.h>
+#include "matrix.h"
+
+// y += a * x over n complex numbers in split layout
+typedef void (*caxpy_fn)(int n, double ar, double ai, const double* xr, const double* xi, double* yr, double* yi);
+
+static void caxpy_scalar(int n, double ar, double ai, const double* xr, const double* xi, double* yr, double* yi) {
+    for (int j = 0; j < n; j++) {
+        yr[j] += ar * xr[j] - ai * xi[j];
+        yi[j] += ar * xi[j] + ai * xr[j];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void caxpy_avx2(int n, double ar, double ai, const double* xr, const double* xi, double* yr, double* yi) {
+    __m256d var = _mm256_set1_pd(ar);
+    __m256d vai = _mm256_set1_pd(ai);
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m256d vxr = _mm256_loadu_pd(xr + j);
+        __m256d vxi = _mm256_loadu_pd(xi + j);
+        __m256d vyr = _mm256_loadu_pd(yr + j);
+        __m256d vyi = _mm256_loadu_pd(yi + j);
+        vyr = _mm256_fmadd_pd(var, vxr, vyr);
+        vyr = _mm256_fnmadd_pd(vai, vxi, vyr);
+        vyi = _mm256_fmadd_pd(var, vxi, vyi);
+        vyi = _mm256_fmadd_pd(vai, vxr, vyi);
+        _mm256_storeu_pd(yr + j, vyr);
+        _mm256_storeu_pd(yi + j, vyi);
+    }
+    for (; j < n; j++) {
+        yr[j] += ar * xr[j] - ai * xi[j];
+        yi[j] += ar * xi[j] + ai * xr[j];
+    }
+}
+
+__attribute__((target("avx512f")))
+static void caxpy_avx512(int n, double ar, double ai, const double* xr, const double* xi, double* yr, double* yi) {
+    __m512d var = _mm512_set1_pd(ar);
+    __m512d vai = _mm512_set1_pd(ai);
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m512d vxr = _mm512_loadu_pd(xr + j);
+        __m512d vxi = _mm512_loadu_pd(xi + j);
+        __m512d vyr = _mm512_loadu_pd(yr + j);
+        __m512d vyi = _mm512_loadu_pd(yi + j);
+        vyr = _mm512_fmadd_pd(var, vxr, vyr);
+        vyr = _mm512_fnmadd_pd(vai, vxi, vyr);
+        vyi = _mm512_fmadd_pd(var, vxi, vyi);
+        vyi = _mm512_fmadd_pd(vai, vxr, vyi);
+        _mm512_storeu_pd(yr + j, vyr);
+        _mm512_storeu_pd(yi + j, vyi);
+    }
+    // Masked tail keeps the remainder in one vector op
+    if (j < n) {
+        __mmask8 mask = (__mmask8)((1u << (n - j)) - 1);
+        __m512d vxr = _mm512_maskz_loadu_pd(mask, xr + j);
+        __m512d vxi = _mm512_maskz_loadu_pd(mask, xi + j);
+        __m512d vyr = _mm512_maskz_loadu_pd(mask, yr + j);
+        __m512d vyi = _mm512_maskz_loadu_pd(mask, yi + j);
+        vyr = _mm512_fmadd_pd(var, vxr, vyr);
+        vyr = _mm512_fnmadd_pd(vai, vxi, vyr);
+        vyi = _mm512_fmadd_pd(var, vxi, vyi);
+        vyi = _mm512_fmadd_pd(vai, vxr, vyi);
+        _mm512_mask_storeu_pd(yr + j, mask, vyr);
+        _mm512_mask_storeu_pd(yi + j, mask, vyi);
+    }
+}
+
+// sum conj(x) * y, written to (*re, *im)
+typedef void (*cdotc_fn)(int n, const double* xr, const double* xi, const double* yr, const double* yi, double* re, double* im);
+
+static void cdotc_scalar(int n, const double* xr, const double* xi, const double* yr, const double* yi, double* re, double* im) {
+    double sr = 0.0, si = 0.0;
+    for (int k = 0; k < n; k++) {
+        sr += xr[k] * yr[k] + xi[k] * yi[k];
+        si += xr[k] * yi[k] - xi[k] * yr[k];
+    }
+    *re = sr;
+    *im = si;
+}
+
+__attribute__((target("avx2,fma")))
+static void cdotc_avx2(int n, const double* xr, const double* xi, const double* yr, const double* yi, double* re, double* im) {
+    __m256d sr = _mm256_setzero_pd();
+    __m256d si = _mm256_setzero_pd();
+    int k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m256d vxr = _mm256_loadu_pd(xr + k);
+        __m256d vxi = _mm256_loadu_pd(xi + k);
+        __m256d vyr = _mm256_loadu_pd(yr + k);
+        __m256d vyi = _mm256_loadu_pd(yi + k);
+        sr = _mm256_fmadd_pd(vxr, vyr, sr);
+        sr = _mm256_fmadd_pd(vxi, vyi, sr);
+        si = _mm256_fmadd_pd(vxr, vyi, si);
+        si = _mm256_fnmadd_pd(vxi, vyr, si);
+    }
+    double lanes_r[4], lanes_i[4];
+    _mm256_storeu_pd(lanes_r, sr);
+    _mm256_storeu_pd(lanes_i, si);
+    double tr = lanes_r[0] + lanes_r[1] + lanes_r[2] + lanes_r[3];
+    double ti = lanes_i[0] + lanes_i[1] + lanes_i[2] + lanes_i[3];
+    for (; k < n; k++) {
+        tr += xr[k] * yr[k] + xi[k] * yi[k];
+        ti += xr[k] * yi[k] - xi[k] * yr[k];
+    }
+    *re = tr;
+    *im = ti;
+}
+
+__attribute__((target("avx512f")))
+static void cdotc_avx512(int n, const double* xr, const double* xi, const double* yr, const double* yi, double* re, double* im) {
+    __m512d sr = _mm512_setzero_pd();
+    __m512d si = _mm512_setzero_pd();
+    int k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m512d vxr = _mm512_loadu_pd(xr + k);
+        __m512d vxi = _mm512_loadu_pd(xi + k);
+        __m512d vyr = _mm512_loadu_pd(yr + k);
+        __m512d vyi = _mm512_loadu_pd(yi + k);
+        sr = _mm512_fmadd_pd(vxr, vyr, sr);
+        sr = _mm512_fmadd_pd(vxi, vyi, sr);
+        si = _mm512_fmadd_pd(vxr, vyi, si);
+        si = _mm512_fnmadd_pd(vxi, vyr, si);
+    }
+    if (k < n) {
+        __mmask8 mask = (__mmask8)((1u << (n - k)) - 1);
+        __m512d vxr = _mm512_maskz_loadu_pd(mask, xr + k);
+        __m512d vxi = _mm512_maskz_loadu_pd(mask, xi + k);
+        __m512d vyr = _mm512_maskz_loadu_pd(mask, yr + k);
+        __m512d vyi = _mm512_maskz_loadu_pd(mask, yi + k);
+        sr = _mm512_fmadd_pd(vxr, vyr, sr);
+        sr = _mm512_fmadd_pd(vxi, vyi, sr);
+        si = _mm512_fmadd_pd(vxr, vyi, si);
+        si = _mm512_fnmadd_pd(vxi, vyr, si);
+    }
+    *re = _mm512_reduce_add_pd(sr);
+    *im = _mm512_reduce_add_pd(si);
+}
+
+static caxpy_fn caxpy = caxpy_scalar;
+static cdotc_fn cdotc = cdotc_scalar;
+static const char* kernel_name = "scalar";
+
+void matrix_select_kernel(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        caxpy = caxpy_avx512;
+        cdotc = cdotc_avx512;
+        kernel_name = "avx512";
+    } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        caxpy = caxpy_avx2;
+        cdotc = cdotc_avx2;
+        kernel_name = "avx2";
+    } else {
+        caxpy = caxpy_scalar;
+        cdotc = cdotc_scalar;
+        kernel_name = "scalar";
+    }
+}
+
+void matrix_use_scalar(void) {
+    caxpy = caxpy_scalar;
+    cdotc = cdotc_scalar;
+    kernel_name = "scalar";
+}
+
+const char* matrix_kernel_name(void) {
+    return kernel_name;
+}
+
+int cmatrix_alloc(CMatrix* m, int rows, int cols) {
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = (cols + 7) & ~7;
+    size_t bytes = (size_t)rows * m->stride * sizeof(double);
+    m->re = aligned_alloc(MATRIX_ALIGN, bytes);
+    m->im = aligned_alloc(MATRIX_ALIGN, bytes);
+    if (m->re == NULL || m->im == NULL) {
+        perror("Failed to allocate matrix");
+        cmatrix_free(m);
+        return -1;
+    }
+    memset(m->re, 0, bytes);
+    memset(m->im, 0, bytes);
+    return 0;
+}
+
+void cmatrix_free(CMatrix* m) {
+    free(m->re);
+    free(m->im);
+    m->re = m->im = NULL;
+}
+
+// Rastgele karmaşık sayı matris oluşturma, entries in [0,1] + [0,1]i
+void cmatrix_random(CMatrix* m) {
+    for (int i = 0; i < m->rows; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            m->re[i * m->stride + j] = (double)rand() / RAND_MAX;
+            m->im[i * m->stride + j] = (double)rand() / RAND_MAX;
+        }
+    }
+}
+
+void cmatrix_from_aos(CMatrix* m, const complex double* src) {
+    for (int i = 0; i < m->rows; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            m->re[i * m->stride + j] = creal(src[i * m->cols + j]);
+            m->im[i * m->stride + j] = cimag(src[i * m->cols + j]);
+        }
+    }
+}
+
+void cmatrix_to_aos(const CMatrix* m, complex double* dst) {
+    for (int i = 0; i < m->rows; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            dst[i * m->cols + j] = m->re[i * m->stride + j] + m->im[i * m->stride + j] * I;
+        }
+    }
+}
+
+// Matris transpoz (B = A^T)
+void cmatrix_transpose(const CMatrix* a, CMatrix* b) {
+    for (int i = 0; i < a->rows; i++) {
+        for (int j = 0; j < a->cols; j++) {
+            b->re[j * b->stride + i] = a->re[i * a->stride + j];
+            b->im[j * b->stride + i] = a->im[i * a->stride + j];
+        }
+    }
+}
+
+// Blocked C = A * B. The inner step is a row update C[i][j..] += A[i][k] * B[k][j..].
+void cmatrix_multiply(const CMatrix* a, const CMatrix* b, CMatrix* c) {
+    for (int i = 0; i < c->rows; i++) {
+        memset(c->re + i * c->stride, 0, c->cols * sizeof(double));
+        memset(c->im + i * c->stride, 0, c->cols * sizeof(double));
+    }
+
+    for (int ii = 0; ii < a->rows; ii += MATRIX_BLOCK_I) {
+        int i_end = ii + MATRIX_BLOCK_I < a->rows ? ii + MATRIX_BLOCK_I : a->rows;
+        for (int kk = 0; kk < a->cols; kk += MATRIX_BLOCK_K) {
+            int k_end = kk + MATRIX_BLOCK_K < a->cols ? kk + MATRIX_BLOCK_K : a->cols;
+            for (int jj = 0; jj < b->cols; jj += MATRIX_BLOCK_J) {
+                int j_len = (jj + MATRIX_BLOCK_J < b->cols ? jj + MATRIX_BLOCK_J : b->cols) - jj;
+                for (int i = ii; i < i_end; i++) {
+                    for (int k = kk; k < k_end; k++) {
+                        caxpy(j_len, a->re[i * a->stride + k], a->im[i * a->stride + k],
+                              b->re + k * b->stride + jj, b->im + k * b->stride + jj,
+                              c->re + i * c->stride + jj, c->im + i * c->stride + jj);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Matris tersini hesaplama (gaussian elimination), augmented is n x 2n scratch
+int cmatrix_inverse(const CMatrix* a, CMatrix* b, CMatrix* augmented) {
+    int n = a->rows;
+    int width = 2 * n;
+
+    // Augmenting Identity Matrix of Order n
+    for (int i = 0; i < n; i++) {
+        double* row_re = augmented->re + i * augmented->stride;
+        double* row_im = augmented->im + i * augmented->stride;
+        memcpy(row_re, a->re + i * a->stride, n * sizeof(double));
+        memcpy(row_im, a->im + i * a->stride, n * sizeof(double));
+        memset(row_re + n, 0, n * sizeof(double));
+        memset(row_im + n, 0, n * sizeof(double));
+        row_re[n + i] = 1.0;
+    }
+
+    // Applying Gauss Jordan Elimination
+    for (int i = 0; i < n; i++) {
+        double* pivot_re = augmented->re + i * augmented->stride;
+        double* pivot_im = augmented->im + i * augmented->stride;
+        complex double pivot = pivot_re[i] + pivot_im[i] * I;
+        if (cabs(pivot) == 0.0) {
+            printf("Mathematical Error!");
+            return 0;
+        }
+        for (int j = 0; j < n; j++) {
+            if (i != j) {
+                double* row_re = augmented->re + j * augmented->stride;
+                double* row_im = augmented->im + j * augmented->stride;
+                complex double ratio = (row_re[i] + row_im[i] * I) / pivot;
+                caxpy(width, -creal(ratio), -cimag(ratio), pivot_re, pivot_im, row_re, row_im);
+            }
+        }
+    }
+
+    // Row Operation to Make Principal Diagonal to 1, then extract the inverse
+    for (int i = 0; i < n; i++) {
+        double* row_re = augmented->re + i * augmented->stride;
+        double* row_im = augmented->im + i * augmented->stride;
+        complex double scale = 1.0 / (row_re[i] + row_im[i] * I);
+        double sr = creal(scale);
+        double si = cimag(scale);
+        for (int j = 0; j < n; j++) {
+            double xr = row_re[n + j];
+            double xi = row_im[n + j];
+            b->re[i * b->stride + j] = sr * xr - si * xi;
+            b->im[i * b->stride + j] = sr * xi + si * xr;
+        }
+    }
+
+    return 1;
+}
+
+void cmatrix_axpy(int n, complex double a, const double* xr, const double* xi, double* yr, double* yi) {
+    caxpy(n, creal(a), cimag(a), xr, xi, yr, yi);
+}
+
+complex double cmatrix_dotc(int n, const double* xr, const double* xi, const double* yr, const double* yi) {
+    double re, im;
+    cdotc(n, xr, xi, yr, yi, &re, &im);
+    return re + im * I;
+}
+
+// Compares the selected kernel with the scalar one on A^T * A and returns
+// the largest error relative to the largest entry.
+double matrix_self_check(int rows, int cols) {
+    CMatrix a, at, fast, reference;
+    if (cmatrix_alloc(&a, rows, cols) < 0 || cmatrix_alloc(&at, cols, rows) < 0 ||
+        cmatrix_alloc(&fast, cols, cols) < 0 || cmatrix_alloc(&reference, cols, cols) < 0) {
+        return -1.0;
+    }
+
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            a.re[i * a.stride + j] = (double)rand() / RAND_MAX;
+            a.im[i * a.stride + j] = (double)rand() / RAND_MAX;
+        }
+    }
+    cmatrix_transpose(&a, &at);
+
+    cmatrix_multiply(&at, &a, &fast);
+    caxpy_fn selected = caxpy;
+    caxpy = caxpy_scalar;
+    cmatrix_multiply(&at, &a, &reference);
+    caxpy = selected;
+
+    double max_error = 0.0;
+    double max_value = 0.0;
+    for (int i = 0; i < cols; i++) {
+        for (int j = 0; j < cols; j++) {
+            int idx = i * reference.stride + j;
+            double error = hypot(fast.re[idx] - reference.re[idx], fast.im[idx] - reference.im[idx]);
+            double value = hypot(reference.re[idx], reference.im[idx]);
+            if (error > max_error) {
+                max_error = error;
+            }
+            if (value > max_value) {
+                max_value = value;
+            }
+        }
+    }
+
+    cmatrix_free(&a);
+    cmatrix_free(&at);
+    cmatrix_free(&fast);
+    cmatrix_free(&reference);
+    return max_value > 0.0 ? max_error / max_value : max_error;
+}
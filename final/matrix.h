@@ -0,0 +1,42 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <complex.h>
+
+#define MATRIX_ALIGN 64
+#define MATRIX_BLOCK_I 16  // Row block of C
+#define MATRIX_BLOCK_K 32  // Inner dimension block, keeps B rows in L1
+#define MATRIX_BLOCK_J 64  // Column block of B and C
+
+// Complex matrix in split (SoA) layout: real and imaginary parts live in
+// separate row-major arrays so one SIMD register holds 4 or 8 real parts.
+// stride is padded to a multiple of 8 doubles for aligned row starts.
+typedef struct {
+    int rows;
+    int cols;
+    int stride;
+    double* re;
+    double* im;
+} CMatrix;
+
+int cmatrix_alloc(CMatrix* m, int rows, int cols);
+void cmatrix_free(CMatrix* m);
+void cmatrix_random(CMatrix* m);
+void cmatrix_from_aos(CMatrix* m, const complex double* src);
+void cmatrix_to_aos(const CMatrix* m, complex double* dst);
+void cmatrix_transpose(const CMatrix* a, CMatrix* b);
+void cmatrix_multiply(const CMatrix* a, const CMatrix* b, CMatrix* c);
+int cmatrix_inverse(const CMatrix* a, CMatrix* b, CMatrix* augmented);
+
+// y += a * x over n complex numbers, using the selected SIMD kernel
+void cmatrix_axpy(int n, complex double a, const double* xr, const double* xi, double* yr, double* yi);
+// sum conj(x) * y
+complex double cmatrix_dotc(int n, const double* xr, const double* xi, const double* yr, const double* yi);
+
+// Picks the widest kernel the CPU supports (AVX-512, AVX2+FMA or scalar)
+void matrix_select_kernel(void);
+void matrix_use_scalar(void); // Benchmarks: scalar kernel until the next matrix_select_kernel
+const char* matrix_kernel_name(void);
+double matrix_self_check(int rows, int cols);
+
+#endif
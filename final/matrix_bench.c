@@ -0,0 +1,204 @@
+// Pseudo-inverse kernel benchmark: the normal-equations pseudo-inverse a
+// cook runs, once with the original AoS triple loops from server.c, once on
+// the SoA kernels with the scalar axpy and once with the widest SIMD kernel
+// the CPU has. For each ROWS/COLS setting it prints the error of A^T * A
+// against the original loops, the pseudo-inverse difference where A^T * A
+// is invertible (rows >= cols), and GFLOP/s of each path.
+//   ./matrix_bench [seconds]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <time.h>
+#include "matrix.h"
+#include "pinv.h"
+
+static double seconds_per_path = 0.2;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Original loops with ROWS/COLS as arguments, row-major AoS
+static void original_multiply(const complex double* a, const complex double* b, complex double* c, int n, int m, int inner) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < m; j++) {
+            c[i * m + j] = 0.0 + 0.0 * I;
+            for (int k = 0; k < inner; k++) {
+                c[i * m + j] += a[i * inner + k] * b[k * m + j];
+            }
+        }
+    }
+}
+
+static void original_transpose(const complex double* a, complex double* b, int rows, int cols) {
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            b[j * rows + i] = a[i * cols + j];
+        }
+    }
+}
+
+static int original_inverse(const complex double* a, complex double* b, complex double* augmented, int n) {
+    int width = 2 * n;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            augmented[i * width + j] = a[i * n + j];
+            augmented[i * width + j + n] = (i == j) ? 1.0 + 0.0 * I : 0.0 + 0.0 * I;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        if (cabs(augmented[i * width + i]) == 0.0) {
+            return 0;
+        }
+        for (int j = 0; j < n; j++) {
+            if (i != j) {
+                complex double ratio = augmented[j * width + i] / augmented[i * width + i];
+                for (int k = 0; k < width; k++) {
+                    augmented[j * width + k] -= ratio * augmented[i * width + k];
+                }
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        complex double temp = augmented[i * width + i];
+        for (int j = 0; j < width; j++) {
+            augmented[i * width + j] /= temp;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            b[i * n + j] = augmented[i * width + j + n];
+        }
+    }
+    return 1;
+}
+
+typedef struct {
+    int rows, cols;
+    complex double* a;
+    complex double* transposed;
+    complex double* gram;
+    complex double* gram_inv;
+    complex double* augmented;
+    complex double* inverse;
+} Original;
+
+static void original_pseudo_inverse(Original* o) {
+    original_transpose(o->a, o->transposed, o->rows, o->cols);
+    original_multiply(o->transposed, o->a, o->gram, o->cols, o->cols, o->rows);
+    if (original_inverse(o->gram, o->gram_inv, o->augmented, o->cols)) {
+        original_multiply(o->gram_inv, o->transposed, o->inverse, o->cols, o->rows, o->cols);
+    }
+}
+
+// Largest entry error relative to the largest entry, as matrix_self_check
+static double relative_error(const CMatrix* m, const complex double* reference) {
+    double max_error = 0.0, max_value = 0.0;
+    for (int i = 0; i < m->rows; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            complex double value = reference[i * m->cols + j];
+            double error = cabs(m->re[i * m->stride + j] + m->im[i * m->stride + j] * I - value);
+            max_error = error > max_error ? error : max_error;
+            max_value = cabs(value) > max_value ? cabs(value) : max_value;
+        }
+    }
+    return max_value > 0.0 ? max_error / max_value : max_error;
+}
+
+// Pseudo-inverses per second over seconds_per_path
+static double time_original(Original* o) {
+    long count = 0;
+    double start = now_seconds(), elapsed;
+    do {
+        original_pseudo_inverse(o);
+        count++;
+    } while ((elapsed = now_seconds() - start) < seconds_per_path);
+    return count / elapsed;
+}
+
+static double time_kernels(const CMatrix* a, CMatrix* inverse, PinvWorkspace* ws) {
+    long count = 0;
+    double start = now_seconds(), elapsed;
+    do {
+        pinv_compute(a, inverse, ws);
+        count++;
+    } while ((elapsed = now_seconds() - start) < seconds_per_path);
+    return count / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        seconds_per_path = atof(argv[1]);
+    }
+    if (seconds_per_path <= 0) {
+        fprintf(stderr, "Usage: %s [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    static const int sizes[][2] = { { 30, 40 }, { 40, 30 }, { 80, 60 }, { 160, 120 }, { 320, 240 } };
+    matrix_select_kernel();
+    const char* simd = matrix_kernel_name();
+    printf("kernel %s, %.1f s per path, GFLOP/s counts 16 r c^2 + 16 c^3 per pseudo-inverse\n", simd, seconds_per_path);
+    printf("%11s %12s %12s %12s %12s %12s %12s\n", "rows x cols", "gram scalar", "gram simd", "pinv diff", "original", "scalar", simd);
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        int rows = sizes[s][0], cols = sizes[s][1];
+        Original o = { .rows = rows, .cols = cols };
+        o.a = malloc(rows * cols * sizeof(complex double));
+        o.transposed = malloc(cols * rows * sizeof(complex double));
+        o.gram = malloc(cols * cols * sizeof(complex double));
+        o.gram_inv = malloc(cols * cols * sizeof(complex double));
+        o.augmented = malloc(cols * 2 * cols * sizeof(complex double));
+        o.inverse = malloc(cols * rows * sizeof(complex double));
+        CMatrix a, at, gram, inverse;
+        PinvWorkspace ws;
+        if (o.a == NULL || o.transposed == NULL || o.gram == NULL || o.gram_inv == NULL || o.augmented == NULL || o.inverse == NULL ||
+            cmatrix_alloc(&a, rows, cols) < 0 || cmatrix_alloc(&at, cols, rows) < 0 || cmatrix_alloc(&gram, cols, cols) < 0 ||
+            cmatrix_alloc(&inverse, cols, rows) < 0 || pinv_workspace_init(&ws, rows, cols, PINV_NORMAL) < 0) {
+            return 1;
+        }
+        cmatrix_random(&a);
+        cmatrix_to_aos(&a, o.a);
+        cmatrix_transpose(&a, &at);
+        original_pseudo_inverse(&o);
+
+        // Accuracy against the original loops
+        matrix_use_scalar();
+        cmatrix_multiply(&at, &a, &gram);
+        double scalar_error = relative_error(&gram, o.gram);
+        matrix_select_kernel();
+        cmatrix_multiply(&at, &a, &gram);
+        double simd_error = relative_error(&gram, o.gram);
+        char pinv_diff[16] = "singular";
+        if (rows >= cols) {
+            pinv_compute(&a, &inverse, &ws);
+            snprintf(pinv_diff, sizeof(pinv_diff), "%.2e", relative_error(&inverse, o.inverse));
+        }
+
+        double flops = 16.0 * rows * cols * cols + 16.0 * cols * cols * cols;
+        double original_rate = time_original(&o);
+        matrix_use_scalar();
+        double scalar_rate = time_kernels(&a, &inverse, &ws);
+        matrix_select_kernel();
+        double simd_rate = time_kernels(&a, &inverse, &ws);
+        printf("%4d x %-4d %12.2e %12.2e %12s %12.2f %12.2f %12.2f\n", rows, cols, scalar_error, simd_error, pinv_diff,
+               original_rate * flops / 1e9, scalar_rate * flops / 1e9, simd_rate * flops / 1e9);
+
+        free(o.a);
+        free(o.transposed);
+        free(o.gram);
+        free(o.gram_inv);
+        free(o.augmented);
+        free(o.inverse);
+        cmatrix_free(&a);
+        cmatrix_free(&at);
+        cmatrix_free(&gram);
+        cmatrix_free(&inverse);
+        pinv_workspace_free(&ws);
+    }
+    return 0;
+}
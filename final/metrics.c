@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "metrics.h"
+
+// One per thread. Only the owner writes, so updates are plain relaxed
+// stores with no read-modify-write; a scrape sums every shard.
+typedef struct MetricsShard {
+    atomic_ulong buckets[METRIC_STAGES][METRICS_BUCKETS];
+    atomic_ulong sum_us[METRIC_STAGES];
+    atomic_ulong counters[METRIC_COUNTERS];
+    struct MetricsShard* next;
+} MetricsShard;
+
+static _Atomic(MetricsShard*) shards = NULL; // Lock-free push-only list, like the log buffers
+static __thread MetricsShard* local_shard = NULL;
+
+static const char* stage_names[METRIC_STAGES] = { "queue_wait", "prepare", "oven_wait", "bake", "bag_wait", "travel" };
+static const char* counter_names[METRIC_COUNTERS] = { "placed", "prepared", "cooked", "delivered", "cancelled" };
+
+static MetricsShard* get_local_shard(void) {
+    if (local_shard != NULL) {
+        return local_shard;
+    }
+    MetricsShard* shard = aligned_alloc(64, (sizeof(MetricsShard) + 63) & ~(size_t)63);
+    if (shard == NULL) {
+        perror("Failed to allocate metrics shard");
+        return NULL;
+    }
+    memset(shard, 0, sizeof(*shard));
+
+    MetricsShard* first = atomic_load(&shards);
+    do {
+        shard->next = first;
+    } while (!atomic_compare_exchange_weak(&shards, &first, shard));
+
+    local_shard = shard;
+    return shard;
+}
+
+static int bucket_index(uint64_t us) {
+    if (us < METRICS_SUB_BUCKETS) {
+        return (int)us;
+    }
+    int exponent = 63 - __builtin_clzll(us); // >= METRICS_SUB_BITS
+    int shift = exponent - METRICS_SUB_BITS;
+    int index = (shift + 1) * METRICS_SUB_BUCKETS + (int)((us >> shift) - METRICS_SUB_BUCKETS);
+    return index < METRICS_BUCKETS ? index : METRICS_BUCKETS - 1;
+}
+
+// Largest value that lands in the bucket, in microseconds
+static uint64_t bucket_upper(int index) {
+    if (index < METRICS_SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    int shift = index / METRICS_SUB_BUCKETS - 1;
+    uint64_t base = (uint64_t)(METRICS_SUB_BUCKETS + index % METRICS_SUB_BUCKETS) << shift;
+    return base + ((uint64_t)1 << shift) - 1;
+}
+
+static inline void bump(atomic_ulong* value, unsigned long by) {
+    atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + by, memory_order_relaxed);
+}
+
+void metrics_record(int stage, double seconds) {
+    MetricsShard* shard = get_local_shard();
+    if (shard == NULL) {
+        return;
+    }
+    uint64_t us = seconds > 0 ? (uint64_t)(seconds * 1e6) : 0;
+    bump(&shard->buckets[stage][bucket_index(us)], 1);
+    bump(&shard->sum_us[stage], us);
+}
+
+void metrics_count(int counter) {
+    MetricsShard* shard = get_local_shard();
+    if (shard != NULL) {
+        bump(&shard->counters[counter], 1);
+    }
+}
+
+static void collect(int stage, unsigned long* buckets, unsigned long* total, unsigned long* sum_us) {
+    memset(buckets, 0, METRICS_BUCKETS * sizeof(unsigned long));
+    *total = 0;
+    *sum_us = 0;
+    for (MetricsShard* shard = atomic_load(&shards); shard != NULL; shard = shard->next) {
+        for (int i = 0; i < METRICS_BUCKETS; ++i) {
+            unsigned long n = atomic_load_explicit(&shard->buckets[stage][i], memory_order_relaxed);
+            buckets[i] += n;
+            *total += n;
+        }
+        *sum_us += atomic_load_explicit(&shard->sum_us[stage], memory_order_relaxed);
+    }
+}
+
+static double quantile_of(const unsigned long* buckets, unsigned long total, double q) {
+    if (total == 0) {
+        return 0.0;
+    }
+    unsigned long rank = (unsigned long)(q * (total - 1)) + 1;
+    unsigned long seen = 0;
+    for (int i = 0; i < METRICS_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return bucket_upper(i) / 1e6;
+        }
+    }
+    return bucket_upper(METRICS_BUCKETS - 1) / 1e6;
+}
+
+double metrics_quantile(int stage, double q) {
+    unsigned long buckets[METRICS_BUCKETS];
+    unsigned long total, sum_us;
+    collect(stage, buckets, &total, &sum_us);
+    return quantile_of(buckets, total, q);
+}
+
+#define APPEND(...) \
+    do { \
+        if (length < size) { \
+            int n = snprintf(out + length, size - length, __VA_ARGS__); \
+            length += n > 0 ? (size_t)n : 0; \
+        } \
+    } while (0)
+
+// Histogram buckets are exported at powers of two; the fine buckets feed
+// the quantile gauges. Returns the text length, capped at size - 1.
+size_t metrics_render(char* out, size_t size) {
+    static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    unsigned long buckets[METRICS_BUCKETS];
+    size_t length = 0;
+    out[0] = '\0';
+
+    APPEND("# HELP pideshop_orders_total Orders that passed each step\n# TYPE pideshop_orders_total counter\n");
+    for (int c = 0; c < METRIC_COUNTERS; ++c) {
+        unsigned long value = 0;
+        for (MetricsShard* shard = atomic_load(&shards); shard != NULL; shard = shard->next) {
+            value += atomic_load_explicit(&shard->counters[c], memory_order_relaxed);
+        }
+        APPEND("pideshop_orders_total{event=\"%s\"} %lu\n", counter_names[c], value);
+    }
+
+    APPEND("# HELP pideshop_stage_seconds Time an order spends in each stage\n# TYPE pideshop_stage_seconds histogram\n");
+    for (int s = 0; s < METRIC_STAGES; ++s) {
+        unsigned long total, sum_us;
+        collect(s, buckets, &total, &sum_us);
+        unsigned long cumulative = 0;
+        int next = 0;
+        for (int exponent = 0; exponent <= METRICS_MAX_EXPONENT; ++exponent) {
+            uint64_t limit = (uint64_t)1 << exponent;
+            while (next < METRICS_BUCKETS && bucket_upper(next) <= limit) {
+                cumulative += buckets[next++];
+            }
+            APPEND("pideshop_stage_seconds_bucket{stage=\"%s\",le=\"%g\"} %lu\n", stage_names[s], limit / 1e6, cumulative);
+        }
+        APPEND("pideshop_stage_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %lu\n", stage_names[s], total);
+        APPEND("pideshop_stage_seconds_sum{stage=\"%s\"} %.6f\n", stage_names[s], sum_us / 1e6);
+        APPEND("pideshop_stage_seconds_count{stage=\"%s\"} %lu\n", stage_names[s], total);
+    }
+
+    APPEND("# HELP pideshop_stage_quantile_seconds Stage latency quantiles from the fine buckets\n# TYPE pideshop_stage_quantile_seconds gauge\n");
+    for (int s = 0; s < METRIC_STAGES; ++s) {
+        unsigned long total, sum_us;
+        collect(s, buckets, &total, &sum_us);
+        for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); ++i) {
+            APPEND("pideshop_stage_quantile_seconds{stage=\"%s\",quantile=\"%g\"} %.6f\n", stage_names[s], quantiles[i],
+                   quantile_of(buckets, total, quantiles[i]));
+        }
+    }
+    return length < size ? length : size - 1;
+}
@@ -0,0 +1,36 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+
+// Stages of an order, one latency histogram each
+#define METRIC_QUEUE_WAIT 0 // Placed until a cook takes it
+#define METRIC_PREPARE 1
+#define METRIC_OVEN_WAIT 2  // Prepared until it is in the oven
+#define METRIC_BAKE 3
+#define METRIC_BAG_WAIT 4   // Out of the oven until a courier takes it
+#define METRIC_TRAVEL 5     // Courier leaves the shop until the door
+#define METRIC_STAGES 6
+
+// Event counters
+#define METRIC_PLACED 0
+#define METRIC_PREPARED 1
+#define METRIC_COOKED 2
+#define METRIC_DELIVERED 3
+#define METRIC_CANCELLED 4
+#define METRIC_COUNTERS 5
+
+// HDR-style buckets over microseconds: every power of two is split into
+// METRICS_SUB_BUCKETS linear steps, so any value is off by at most 1/16.
+#define METRICS_SUB_BITS 4
+#define METRICS_SUB_BUCKETS (1 << METRICS_SUB_BITS)
+#define METRICS_MAX_EXPONENT 36 // 2^36 us, about 19 hours
+#define METRICS_BUCKETS ((METRICS_MAX_EXPONENT + 1) * METRICS_SUB_BUCKETS)
+#define METRICS_RENDER_SIZE (128 * 1024)
+
+void metrics_record(int stage, double seconds);
+void metrics_count(int counter);
+size_t metrics_render(char* out, size_t size); // Prometheus text format
+double metrics_quantile(int stage, double q);  // Seconds, 0 with no samples
+
+#endif
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "orderstore.h"
+
+static Order* base = NULL;
+static size_t reserved_bytes = 0;
+static int* chunk_next = NULL; // Links chunks into the free list or an arena
+static int* chunk_prev = NULL; // Arena lists only, so a dead chunk unlinks in O(1)
+static int* chunk_live = NULL; // Orders of the chunk not yet freed
+static int committed = 0;
+static int free_head = -1;
+static OrderStoreStats stats;
+
+Order* order_store_init(void) {
+    reserved_bytes = (size_t)ORDER_STORE_MAX_CHUNKS * ORDER_CHUNK_SIZE * sizeof(Order);
+    void* range = mmap(NULL, reserved_bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (range == MAP_FAILED) {
+        perror("Failed to reserve order store");
+        return NULL;
+    }
+    chunk_next = malloc(ORDER_STORE_MAX_CHUNKS * sizeof(int));
+    chunk_prev = malloc(ORDER_STORE_MAX_CHUNKS * sizeof(int));
+    chunk_live = calloc(ORDER_STORE_MAX_CHUNKS, sizeof(int));
+    if (chunk_next == NULL || chunk_prev == NULL || chunk_live == NULL) {
+        perror("Failed to allocate order store");
+        free(chunk_next);
+        free(chunk_prev);
+        free(chunk_live);
+        munmap(range, reserved_bytes);
+        return NULL;
+    }
+    base = range;
+    committed = 0;
+    free_head = -1;
+    memset(&stats, 0, sizeof(stats));
+    return base;
+}
+
+static int take_chunk(void) {
+    stats.chunk_takes++;
+    if (free_head != -1) {
+        int chunk = free_head;
+        free_head = chunk_next[chunk];
+        stats.chunks_free--;
+        return chunk;
+    }
+    if (committed == ORDER_STORE_MAX_CHUNKS) {
+        return -1;
+    }
+    // Page-granular commit; neighbouring chunks may share a page, which is harmless
+    size_t chunk_bytes = (size_t)ORDER_CHUNK_SIZE * sizeof(Order);
+    size_t page = 4096;
+    size_t start = ((size_t)committed * chunk_bytes) & ~(page - 1);
+    size_t end = ((size_t)(committed + 1) * chunk_bytes + page - 1) & ~(page - 1);
+    if (mprotect((char*)base + start, end - start, PROT_READ | PROT_WRITE) < 0) {
+        perror("Failed to commit order chunk");
+        return -1;
+    }
+    stats.chunks_committed++;
+    return committed++;
+}
+
+int order_arena_alloc(OrderArena* arena) {
+    if (arena->next_slot == arena->end_slot) {
+        int chunk = take_chunk();
+        if (chunk < 0) {
+            return -1;
+        }
+        chunk_prev[chunk] = -1;
+        if (arena->chunk_count == 0) {
+            arena->chunk_tail = chunk;
+            chunk_next[chunk] = -1;
+        } else {
+            chunk_next[chunk] = arena->chunk_head;
+            chunk_prev[arena->chunk_head] = chunk;
+        }
+        arena->chunk_head = chunk;
+        arena->chunk_count++;
+        arena->next_slot = chunk << ORDER_CHUNK_SHIFT;
+        arena->end_slot = arena->next_slot + ORDER_CHUNK_SIZE;
+    }
+    chunk_live[arena->next_slot >> ORDER_CHUNK_SHIFT]++;
+    return arena->next_slot++;
+}
+
+// A chunk still being filled stays; any other chunk goes back to the free
+// list as soon as its last order is gone
+void order_arena_free(OrderArena* arena, int slot) {
+    int chunk = slot >> ORDER_CHUNK_SHIFT;
+    if (--chunk_live[chunk] > 0 || (chunk == arena->chunk_head && arena->next_slot != arena->end_slot)) {
+        return;
+    }
+    if (chunk_prev[chunk] != -1) {
+        chunk_next[chunk_prev[chunk]] = chunk_next[chunk];
+    } else {
+        arena->chunk_head = chunk_next[chunk];
+        arena->next_slot = arena->end_slot = 0; // Full anyway; the next alloc refills
+    }
+    if (chunk_next[chunk] != -1) {
+        chunk_prev[chunk_next[chunk]] = chunk_prev[chunk];
+    } else {
+        arena->chunk_tail = chunk_prev[chunk];
+    }
+    arena->chunk_count--;
+    chunk_next[chunk] = free_head;
+    free_head = chunk;
+    stats.chunks_free++;
+    stats.chunks_reclaimed++;
+}
+
+// Every chunk of the arena back on the free list in one go
+void order_arena_reset(OrderArena* arena) {
+    if (arena->chunk_count == 0) {
+        return;
+    }
+    for (int chunk = arena->chunk_head; chunk != -1; chunk = chunk_next[chunk]) {
+        chunk_live[chunk] = 0;
+    }
+    chunk_next[arena->chunk_tail] = free_head;
+    free_head = arena->chunk_head;
+    stats.chunks_free += arena->chunk_count;
+    stats.arena_resets++;
+    arena->chunk_count = 0;
+    arena->next_slot = arena->end_slot = 0;
+}
+
+void order_store_get_stats(OrderStoreStats* out) {
+    *out = stats;
+}
+
+void order_store_destroy(void) {
+    if (base != NULL) {
+        munmap(base, reserved_bytes);
+        base = NULL;
+    }
+    free(chunk_next);
+    free(chunk_prev);
+    free(chunk_live);
+    chunk_next = chunk_prev = chunk_live = NULL;
+}
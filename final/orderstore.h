@@ -0,0 +1,42 @@
+#ifndef ORDERSTORE_H
+#define ORDERSTORE_H
+
+#include "pideshop.h"
+
+#define ORDER_CHUNK_SHIFT 6
+#define ORDER_CHUNK_SIZE (1 << ORDER_CHUNK_SHIFT) // Orders per chunk
+#define ORDER_STORE_MAX_CHUNKS (1 << 16)          // Address space reserved for 4M orders
+
+// Bump allocator over whole chunks of the store. A session takes slots
+// one by one; a chunk whose orders are all gone goes back to the store
+// right away, so a session that never runs dry still stays bounded, and
+// every chunk goes back at once when its last live order is gone. All
+// zero is an empty arena.
+typedef struct {
+    int chunk_count;
+    int chunk_head;  // Chunks of this arena, newest first, linked in the store
+    int chunk_tail;  // First one taken, lets reset splice the list in O(1)
+    int next_slot;
+    int end_slot;
+} OrderArena;
+
+typedef struct {
+    long chunks_committed; // Ever made accessible
+    long chunks_free;
+    long chunk_takes;      // Arena refills, served from the free list when possible
+    long arena_resets;
+    long chunks_reclaimed; // Given back by order_arena_free before the session ended
+} OrderStoreStats;
+
+// Orders live in one reserved address range that is committed a chunk at
+// a time, so orders[slot] never moves and needs no lock to read. The store
+// itself is not locked; callers serialize allocation (the server's
+// order_mutex).
+Order* order_store_init(void);
+int order_arena_alloc(OrderArena* arena); // Slot index, -1 when the store is full
+void order_arena_free(OrderArena* arena, int slot); // The order in slot is gone
+void order_arena_reset(OrderArena* arena);
+void order_store_get_stats(OrderStoreStats* stats);
+void order_store_destroy(void);
+
+#endif
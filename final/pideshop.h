@@ -0,0 +1,44 @@
+#ifndef PIDESHOP_H
+#define PIDESHOP_H
+
+#include <sys/types.h>
+#include <stdatomic.h>
+
+struct Session;
+
+#define MAX_COOKS 10
+#define MAX_DELIVERIES 10
+#define MAX_CLIENTS 100
+#define OVEN_CAPACITY 6
+#define APPARATUS 3
+#define BAG_CAPACITY 3
+#define BUFFER_SIZE 1024
+#define DEFAULT_MATRIX_ROWS 30
+#define DEFAULT_MATRIX_COLS 40
+
+// Courier dispatch modes
+#define DISPATCH_GREEDY 0 // Oldest cooked orders, visited in pickup order
+#define DISPATCH_ROUTE 1  // Oldest order plus its nearest neighbours, nearest-neighbour + 2-opt tour
+
+typedef struct {
+    int order_id;
+    int customer_x;
+    int customer_y;
+    int state; // 0: placed, 1: prepared, 2: cooked, 3: delivering, 4: completed, 5: cancelled
+    int cook_id; // Pişiren aşçı kimliği
+    pid_t pid; // Client PID
+    int next; // Ready queue link (slot index in orders, -1 at the tail)
+    int prev; // Ready queue back link, lets a courier take an order out of the middle
+    struct Session* session; // Batch this order belongs to
+    int session_prev; // Session's order set, slot indices, -1 at the ends
+    int session_next;
+    int grid_prev; // Session's cooked-order grid cell, slot indices
+    int grid_next;
+    double placed_at; // Monotonic seconds when the server accepted it
+    double cooked_at; // Monotonic seconds when it came out of the oven
+    double deadline;  // Monotonic seconds by which it was promised at the door
+    double priority;  // Kitchen deadline key, smaller is cooked first under EDF
+    atomic_int cancelled; // Cancellation token, set once; whoever holds the order drops it at the next stage
+} Order;
+
+#endif
@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include "pinv.h"
+
+#define ROW_RE(m, i) ((m)->re + (size_t)(i) * (m)->stride)
+#define ROW_IM(m, i) ((m)->im + (size_t)(i) * (m)->stride)
+
+static double norm2(int n, const double* xr, const double* xi) {
+    return creal(cmatrix_dotc(n, xr, xi, xr, xi));
+}
+
+static void scale_row(int n, complex double s, double* xr, double* xi) {
+    double sr = creal(s), si = cimag(s);
+    for (int k = 0; k < n; k++) {
+        double re = xr[k];
+        xr[k] = sr * re - si * xi[k];
+        xi[k] = sr * xi[k] + si * re;
+    }
+}
+
+// (x, y) <- (c x - s y, s x + c y) with real c, s
+static void rotate_rows(int n, double c, double s, double* xr, double* xi, double* yr, double* yi) {
+    for (int k = 0; k < n; k++) {
+        double ar = xr[k], ai = xi[k];
+        xr[k] = c * ar - s * yr[k];
+        xi[k] = c * ai - s * yi[k];
+        yr[k] = s * ar + c * yr[k];
+        yi[k] = s * ai + c * yi[k];
+    }
+}
+
+// Row j of work = column j of B, where B = A (m >= n) or A^H (m < n)
+static void load_work(const CMatrix* a, PinvWorkspace* ws) {
+    CMatrix* w = &ws->work;
+    if (ws->rows >= ws->cols) {
+        for (int k = 0; k < a->rows; k++) {
+            for (int j = 0; j < a->cols; j++) {
+                ROW_RE(w, j)[k] = ROW_RE(a, k)[j];
+                ROW_IM(w, j)[k] = ROW_IM(a, k)[j];
+            }
+        }
+    } else {
+        for (int j = 0; j < a->rows; j++) {
+            for (int k = 0; k < a->cols; k++) {
+                ROW_RE(w, j)[k] = ROW_RE(a, j)[k];
+                ROW_IM(w, j)[k] = -ROW_IM(a, j)[k];
+            }
+        }
+    }
+}
+
+// pinv(A) = pinv(B) for tall A, pinv(B)^H for wide A
+static void store_result(const PinvWorkspace* ws, CMatrix* result) {
+    const CMatrix* x = &ws->solution;
+    if (ws->rows >= ws->cols) {
+        for (int i = 0; i < ws->r; i++) {
+            memcpy(ROW_RE(result, i), ROW_RE(x, i), ws->p * sizeof(double));
+            memcpy(ROW_IM(result, i), ROW_IM(x, i), ws->p * sizeof(double));
+        }
+    } else {
+        for (int i = 0; i < ws->r; i++) {
+            for (int k = 0; k < ws->p; k++) {
+                ROW_RE(result, k)[i] = ROW_RE(x, i)[k];
+                ROW_IM(result, k)[i] = -ROW_IM(x, i)[k];
+            }
+        }
+    }
+}
+
+// Householder QR of B, then pinv(B) = R^-1 Q1^H. Returns 0 if B is rank deficient.
+static int pinv_qr(PinvWorkspace* ws) {
+    int p = ws->p, r = ws->r;
+    CMatrix* w = &ws->work;
+    CMatrix* v = &ws->reflectors;
+    CMatrix* rm = &ws->basis;
+    CMatrix* x = &ws->solution;
+    double max_diag = 0.0;
+
+    for (int j = 0; j < r; j++) {
+        int len = p - j;
+        double* xr = ROW_RE(w, j) + j;
+        double* xi = ROW_IM(w, j) + j;
+        double norm = sqrt(norm2(len, xr, xi));
+        if (norm == 0.0) {
+            return 0;
+        }
+
+        // alpha = -e^(i arg x0) ||x|| avoids cancellation in v0 = x0 - alpha
+        complex double x0 = xr[0] + xi[0] * I;
+        complex double phase = cabs(x0) == 0.0 ? 1.0 : x0 / cabs(x0);
+        complex double alpha = -phase * norm;
+
+        double* vr = ROW_RE(v, j) + j;
+        double* vi = ROW_IM(v, j) + j;
+        memcpy(vr, xr, len * sizeof(double));
+        memcpy(vi, xi, len * sizeof(double));
+        vr[0] -= creal(alpha);
+        vi[0] -= cimag(alpha);
+        double vnorm = sqrt(norm2(len, vr, vi));
+        scale_row(len, 1.0 / vnorm, vr, vi);
+
+        ROW_RE(rm, j)[j] = creal(alpha);
+        ROW_IM(rm, j)[j] = cimag(alpha);
+        if (norm > max_diag) {
+            max_diag = norm;
+        }
+
+        // Apply H = I - 2 v v^H to the remaining columns
+        for (int c = j + 1; c < r; c++) {
+            double* cr = ROW_RE(w, c) + j;
+            double* ci = ROW_IM(w, c) + j;
+            complex double d = cmatrix_dotc(len, vr, vi, cr, ci);
+            cmatrix_axpy(len, -2.0 * d, vr, vi, cr, ci);
+            ROW_RE(rm, j)[c] = cr[0];
+            ROW_IM(rm, j)[c] = ci[0];
+        }
+    }
+
+    double tolerance = DBL_EPSILON * p * max_diag;
+    for (int j = 0; j < r; j++) {
+        if (hypot(ROW_RE(rm, j)[j], ROW_IM(rm, j)[j]) <= tolerance) {
+            return 0;
+        }
+    }
+
+    // Row t of solution = conj(Q1 e_t) = row t of Q1^H. H_j with j > t leaves e_t alone.
+    for (int t = 0; t < r; t++) {
+        double* qr = ROW_RE(x, t);
+        double* qi = ROW_IM(x, t);
+        memset(qr, 0, p * sizeof(double));
+        memset(qi, 0, p * sizeof(double));
+        qr[t] = 1.0;
+        for (int j = t; j >= 0; j--) {
+            int len = p - j;
+            double* vr = ROW_RE(v, j) + j;
+            double* vi = ROW_IM(v, j) + j;
+            complex double d = cmatrix_dotc(len, vr, vi, qr + j, qi + j);
+            cmatrix_axpy(len, -2.0 * d, vr, vi, qr + j, qi + j);
+        }
+        for (int k = 0; k < p; k++) {
+            qi[k] = -qi[k];
+        }
+    }
+
+    // Back substitution R X = Q1^H, in place
+    for (int i = r - 1; i >= 0; i--) {
+        for (int c = i + 1; c < r; c++) {
+            complex double rc = ROW_RE(rm, i)[c] + ROW_IM(rm, i)[c] * I;
+            cmatrix_axpy(p, -rc, ROW_RE(x, c), ROW_IM(x, c), ROW_RE(x, i), ROW_IM(x, i));
+        }
+        complex double diag = ROW_RE(rm, i)[i] + ROW_IM(rm, i)[i] * I;
+        scale_row(p, 1.0 / diag, ROW_RE(x, i), ROW_IM(x, i));
+    }
+    return 1;
+}
+
+// One-sided Jacobi: rotate column pairs of B until they are orthogonal,
+// then pinv(B) = V Sigma^+ U^H. Handles rank deficient matrices.
+static int pinv_svd(PinvWorkspace* ws) {
+    int p = ws->p, r = ws->r;
+    CMatrix* w = &ws->work;
+    CMatrix* vt = &ws->basis;
+    CMatrix* u = &ws->reflectors;
+    CMatrix* x = &ws->solution;
+
+    for (int i = 0; i < r; i++) {
+        memset(ROW_RE(vt, i), 0, r * sizeof(double));
+        memset(ROW_IM(vt, i), 0, r * sizeof(double));
+        ROW_RE(vt, i)[i] = 1.0;
+    }
+
+    for (int sweep = 0; sweep < PINV_SVD_MAX_SWEEPS; sweep++) {
+        double off = 0.0;
+        for (int i = 0; i < r - 1; i++) {
+            for (int j = i + 1; j < r; j++) {
+                double alpha = norm2(p, ROW_RE(w, i), ROW_IM(w, i));
+                double beta = norm2(p, ROW_RE(w, j), ROW_IM(w, j));
+                complex double gamma = cmatrix_dotc(p, ROW_RE(w, i), ROW_IM(w, i), ROW_RE(w, j), ROW_IM(w, j));
+                double g = cabs(gamma);
+                if (g <= DBL_EPSILON * sqrt(alpha * beta)) {
+                    continue;
+                }
+                if (g / sqrt(alpha * beta) > off) {
+                    off = g / sqrt(alpha * beta);
+                }
+
+                // Rotate column j's phase so that b_i^H b_j is real, then a real Jacobi rotation
+                complex double phase = conj(gamma) / g;
+                scale_row(p, phase, ROW_RE(w, j), ROW_IM(w, j));
+                scale_row(r, phase, ROW_RE(vt, j), ROW_IM(vt, j));
+
+                double zeta = (beta - alpha) / (2.0 * g);
+                double t = (zeta >= 0 ? 1.0 : -1.0) / (fabs(zeta) + sqrt(1.0 + zeta * zeta));
+                double c = 1.0 / sqrt(1.0 + t * t);
+                double s = c * t;
+                rotate_rows(p, c, s, ROW_RE(w, i), ROW_IM(w, i), ROW_RE(w, j), ROW_IM(w, j));
+                rotate_rows(r, c, s, ROW_RE(vt, i), ROW_IM(vt, i), ROW_RE(vt, j), ROW_IM(vt, j));
+            }
+        }
+        if (off <= DBL_EPSILON * p) {
+            break;
+        }
+    }
+
+    double max_sigma2 = 0.0;
+    for (int i = 0; i < r; i++) {
+        double sigma2 = norm2(p, ROW_RE(w, i), ROW_IM(w, i));
+        if (sigma2 > max_sigma2) {
+            max_sigma2 = sigma2;
+        }
+    }
+    double tolerance = DBL_EPSILON * p * sqrt(max_sigma2);
+
+    for (int a = 0; a < r; a++) {
+        memset(ROW_RE(x, a), 0, p * sizeof(double));
+        memset(ROW_IM(x, a), 0, p * sizeof(double));
+    }
+    for (int i = 0; i < r; i++) {
+        double sigma2 = norm2(p, ROW_RE(w, i), ROW_IM(w, i));
+        if (sqrt(sigma2) <= tolerance) {
+            continue; // Truncate null directions
+        }
+        for (int k = 0; k < p; k++) {
+            ROW_RE(u, i)[k] = ROW_RE(w, i)[k];
+            ROW_IM(u, i)[k] = -ROW_IM(w, i)[k];
+        }
+        for (int a = 0; a < r; a++) {
+            complex double coef = (ROW_RE(vt, i)[a] + ROW_IM(vt, i)[a] * I) / sigma2;
+            cmatrix_axpy(p, coef, ROW_RE(u, i), ROW_IM(u, i), ROW_RE(x, a), ROW_IM(x, a));
+        }
+    }
+    return 1;
+}
+
+// Original model: (A^T * A)^-1 * A^T, squares the condition number
+static int pinv_normal(const CMatrix* a, CMatrix* result, PinvWorkspace* ws) {
+    cmatrix_transpose(a, &ws->transposed);
+    cmatrix_multiply(&ws->transposed, a, &ws->gram);
+    if (!cmatrix_inverse(&ws->gram, &ws->gram_inv, &ws->augmented)) {
+        printf("Matrix inversion failed!\n");
+        return 0;
+    }
+    cmatrix_multiply(&ws->gram_inv, &ws->transposed, result);
+    return 1;
+}
+
+int pinv_workspace_init(PinvWorkspace* ws, int rows, int cols, int method) {
+    memset(ws, 0, sizeof(*ws));
+    ws->rows = rows;
+    ws->cols = cols;
+    ws->method = method;
+    ws->p = rows >= cols ? rows : cols;
+    ws->r = rows >= cols ? cols : rows;
+
+    if (method == PINV_NORMAL) {
+        if (cmatrix_alloc(&ws->transposed, cols, rows) < 0 ||
+            cmatrix_alloc(&ws->gram, cols, cols) < 0 ||
+            cmatrix_alloc(&ws->gram_inv, cols, cols) < 0 ||
+            cmatrix_alloc(&ws->augmented, cols, 2 * cols) < 0) {
+            pinv_workspace_free(ws);
+            return -1;
+        }
+        return 0;
+    }
+
+    if (cmatrix_alloc(&ws->work, ws->r, ws->p) < 0 ||
+        cmatrix_alloc(&ws->reflectors, ws->r, ws->p) < 0 ||
+        cmatrix_alloc(&ws->basis, ws->r, ws->r) < 0 ||
+        cmatrix_alloc(&ws->solution, ws->r, ws->p) < 0) {
+        pinv_workspace_free(ws);
+        return -1;
+    }
+    return 0;
+}
+
+void pinv_workspace_free(PinvWorkspace* ws) {
+    cmatrix_free(&ws->transposed);
+    cmatrix_free(&ws->gram);
+    cmatrix_free(&ws->gram_inv);
+    cmatrix_free(&ws->augmented);
+    cmatrix_free(&ws->work);
+    cmatrix_free(&ws->reflectors);
+    cmatrix_free(&ws->basis);
+    cmatrix_free(&ws->solution);
+}
+
+// result is cols x rows. Returns 1 on success.
+int pinv_compute(const CMatrix* a, CMatrix* result, PinvWorkspace* ws) {
+    if (ws->method == PINV_NORMAL) {
+        return pinv_normal(a, result, ws);
+    }
+
+    load_work(a, ws);
+    if (ws->method == PINV_QR && !pinv_qr(ws)) {
+        // Rank deficient, the SVD can truncate the null space
+        load_work(a, ws);
+        pinv_svd(ws);
+    } else if (ws->method == PINV_SVD) {
+        pinv_svd(ws);
+    }
+    store_result(ws, result);
+    return 1;
+}
+
+// ||A X A - A||_F / ||A||_F, zero for an exact pseudo-inverse
+double pinv_residual(const CMatrix* a, const CMatrix* result) {
+    CMatrix ax, axa;
+    if (cmatrix_alloc(&ax, a->rows, a->rows) < 0 || cmatrix_alloc(&axa, a->rows, a->cols) < 0) {
+        return -1.0;
+    }
+    cmatrix_multiply(a, result, &ax);
+    cmatrix_multiply(&ax, a, &axa);
+
+    double error = 0.0, norm = 0.0;
+    for (int i = 0; i < a->rows; i++) {
+        for (int j = 0; j < a->cols; j++) {
+            double dr = ROW_RE(&axa, i)[j] - ROW_RE(a, i)[j];
+            double di = ROW_IM(&axa, i)[j] - ROW_IM(a, i)[j];
+            error += dr * dr + di * di;
+            norm += ROW_RE(a, i)[j] * ROW_RE(a, i)[j] + ROW_IM(a, i)[j] * ROW_IM(a, i)[j];
+        }
+    }
+
+    cmatrix_free(&ax);
+    cmatrix_free(&axa);
+    return norm > 0.0 ? sqrt(error / norm) : sqrt(error);
+}
+
+int pinv_parse_method(const char* name) {
+    if (strcmp(name, "ne") == 0) {
+        return PINV_NORMAL;
+    }
+    if (strcmp(name, "qr") == 0) {
+        return PINV_QR;
+    }
+    if (strcmp(name, "svd") == 0) {
+        return PINV_SVD;
+    }
+    return -1;
+}
+
+const char* pinv_method_name(int method) {
+    switch (method) {
+        case PINV_NORMAL: return "ne";
+        case PINV_QR: return "qr";
+        case PINV_SVD: return "svd";
+        default: return "?";
+    }
+}
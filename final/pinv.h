@@ -0,0 +1,38 @@
+#ifndef PINV_H
+#define PINV_H
+
+#include "matrix.h"
+
+// Pseudo-inverse methods
+#define PINV_NORMAL 0 // (A^T A)^-1 A^T with Gauss-Jordan, the original model
+#define PINV_QR 1     // Householder QR, falls back to SVD when rank deficient
+#define PINV_SVD 2    // One-sided (Hestenes) Jacobi SVD
+
+#define PINV_SVD_MAX_SWEEPS 30
+
+// Scratch for pseudo-inverses of one matrix size, allocated once and reused.
+// For an m x n matrix, B is A (m >= n) or A^H (m < n), so B is p x r with p >= r.
+typedef struct {
+    int rows;
+    int cols;
+    int method;
+    int p;
+    int r;
+    CMatrix transposed; // Normal equations: A^T
+    CMatrix gram;       // Normal equations: A^T * A
+    CMatrix gram_inv;   // Normal equations: (A^T * A)^-1
+    CMatrix augmented;  // Normal equations: [gram | I]
+    CMatrix work;       // r x p, row j holds column j of B
+    CMatrix reflectors; // r x p, Householder vectors (QR) or conj(U * sigma) rows (SVD)
+    CMatrix basis;      // r x r, R (QR) or V^T (SVD)
+    CMatrix solution;   // r x p, pinv(B)
+} PinvWorkspace;
+
+int pinv_workspace_init(PinvWorkspace* ws, int rows, int cols, int method);
+void pinv_workspace_free(PinvWorkspace* ws);
+int pinv_compute(const CMatrix* a, CMatrix* result, PinvWorkspace* ws);
+double pinv_residual(const CMatrix* a, const CMatrix* result);
+int pinv_parse_method(const char* name);
+const char* pinv_method_name(int method);
+
+#endif
@@ -0,0 +1,102 @@
+// Pseudo-inverse method benchmark: normal equations (ne), Householder QR and
+// Jacobi SVD on random, ill-conditioned and rank-deficient matrices of
+// several sizes. Prints ||A A+ A - A|| / ||A|| and pseudo-inverses/s.
+//   ./pinv_bench [seconds]
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "matrix.h"
+#include "pinv.h"
+
+#define KIND_RANDOM 0
+#define KIND_ILL 1    // Columns scaled down to 1e-6, condition about 1e6
+#define KIND_RANK 2   // Last column repeats the first
+#define KIND_COUNT 3
+
+static const char* kind_names[KIND_COUNT] = { "random", "ill", "rank" };
+static double seconds_per_method = 0.2;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void fill(CMatrix* a, int kind) {
+    cmatrix_random(a);
+    for (int i = 0; i < a->rows; i++) {
+        for (int j = 0; j < a->cols; j++) {
+            int idx = i * a->stride + j;
+            if (kind == KIND_ILL) {
+                double scale = pow(1e-6, (double)j / (a->cols - 1));
+                a->re[idx] *= scale;
+                a->im[idx] *= scale;
+            } else if (kind == KIND_RANK && j == a->cols - 1) {
+                a->re[idx] = a->re[i * a->stride];
+                a->im[idx] = a->im[i * a->stride];
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        seconds_per_method = atof(argv[1]);
+    }
+    if (seconds_per_method <= 0) {
+        fprintf(stderr, "Usage: %s [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    static const int sizes[][2] = { { 30, 40 }, { 40, 30 }, { 80, 60 }, { 160, 120 } };
+    static const int methods[] = { PINV_NORMAL, PINV_QR, PINV_SVD };
+    matrix_select_kernel();
+    printf("kernel %s, %.1f s per method\n", matrix_kernel_name(), seconds_per_method);
+    printf("%11s %7s", "rows x cols", "matrix");
+    for (int m = 0; m < 3; ++m) {
+        printf(" %9s resid %9s /s", pinv_method_name(methods[m]), pinv_method_name(methods[m]));
+    }
+    printf("\n");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        int rows = sizes[s][0], cols = sizes[s][1];
+        for (int kind = 0; kind < KIND_COUNT; ++kind) {
+            CMatrix a, inverse;
+            if (cmatrix_alloc(&a, rows, cols) < 0 || cmatrix_alloc(&inverse, cols, rows) < 0) {
+                return 1;
+            }
+            srand(1 + s);
+            fill(&a, kind);
+            double residuals[3], rates[3];
+            for (int m = 0; m < 3; ++m) {
+                PinvWorkspace ws;
+                if (pinv_workspace_init(&ws, rows, cols, methods[m]) < 0) {
+                    return 1;
+                }
+                // ne prints its own error when a pivot is zero, and is not timed then
+                residuals[m] = INFINITY;
+                rates[m] = 0.0;
+                if (pinv_compute(&a, &inverse, &ws)) {
+                    residuals[m] = pinv_residual(&a, &inverse);
+                    long count = 0;
+                    double start = now_seconds(), elapsed;
+                    do {
+                        pinv_compute(&a, &inverse, &ws);
+                        count++;
+                    } while ((elapsed = now_seconds() - start) < seconds_per_method);
+                    rates[m] = count / elapsed;
+                }
+                pinv_workspace_free(&ws);
+            }
+            printf("%4d x %-4d %7s", rows, cols, kind_names[kind]);
+            for (int m = 0; m < 3; ++m) {
+                printf(" %15.2e %12.0f", residuals[m], rates[m]);
+            }
+            printf("\n");
+            cmatrix_free(&a);
+            cmatrix_free(&inverse);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+// Every message between HungryVeryMuch and PideShop is a frame:
+//   u32 length   payload bytes after the header
+//   u8  version  PROTOCOL_VERSION
+//   u8  type     FRAME_*
+//   u16 flags    reserved, 0
+// followed by the payload. All integers are in network byte order.
+#define PROTOCOL_VERSION 1
+#define FRAME_HEADER_SIZE 8
+#define FRAME_MAX_PAYLOAD 65536
+
+#define FRAME_HELLO 1       // pid, numberOfClients, p, q[, promise_ms for every order]
+#define FRAME_ORDER 2       // pid, order_id, x, y[, promise_ms]
+#define FRAME_ORDER_BATCH 3 // pid, count, then count x (order_id, x, y)
+#define FRAME_SUBSCRIBE 4   // pid to follow on the status or completion port, 0 for every order (status only)
+#define FRAME_STATUS_BATCH 5 // count, then count x (pid, order_id, state)
+#define FRAME_COMPLETE 6    // pid, orders delivered, orders cancelled; pushed once on the completion port
+#define FRAME_CANCEL 7      // pid, order_id, 0 cancels every order of pid
+#define FRAME_RETRY_AFTER 8 // pid, retry_after_ms, count, then count x order_id; those orders were not taken
+
+#define HELLO_PAYLOAD_SIZE 16
+#define ORDER_PAYLOAD_SIZE 16
+#define PROMISE_FIELD_SIZE 4 // Optional last field of HELLO and ORDER, 0 lets the server compute it
+#define BATCH_HEADER_SIZE 8
+#define BATCH_ENTRY_SIZE 12
+#define BATCH_MAX_ORDERS ((FRAME_MAX_PAYLOAD - BATCH_HEADER_SIZE) / BATCH_ENTRY_SIZE)
+#define SUBSCRIBE_PAYLOAD_SIZE 4
+#define STATUS_HEADER_SIZE 4
+#define STATUS_ENTRY_SIZE 12
+#define STATUS_MAX_EVENTS ((FRAME_MAX_PAYLOAD - STATUS_HEADER_SIZE) / STATUS_ENTRY_SIZE)
+#define COMPLETE_PAYLOAD_SIZE 12
+#define CANCEL_PAYLOAD_SIZE 8
+#define RETRY_HEADER_SIZE 12
+#define RETRY_ENTRY_SIZE 4
+
+// Order states carried by status events
+#define STATE_PLACED 0
+#define STATE_PREPARED 1
+#define STATE_COOKED 2
+#define STATE_DELIVERING 3
+#define STATE_COMPLETED 4
+#define STATE_CANCELLED 5
+
+static inline void put_u32(unsigned char* dst, uint32_t value) {
+    value = htonl(value);
+    memcpy(dst, &value, sizeof(value));
+}
+
+static inline uint32_t get_u32(const unsigned char* src) {
+    uint32_t value;
+    memcpy(&value, src, sizeof(value));
+    return ntohl(value);
+}
+
+// Writes the frame header, returns the offset where the payload starts
+static inline size_t put_frame_header(unsigned char* dst, uint8_t type, uint32_t payload_length) {
+    put_u32(dst, payload_length);
+    dst[4] = PROTOCOL_VERSION;
+    dst[5] = type;
+    dst[6] = 0;
+    dst[7] = 0;
+    return FRAME_HEADER_SIZE;
+}
+
+#endif
@@ -0,0 +1,255 @@
+// Client protocol benchmark: orders/s from client threads to a receiver
+// over loopback, three ways. The original path opens one connection per
+// order and sends a raw pid_t and a text line the server sscanf's; the
+// framed paths keep one connection per client and send either one ORDER
+// frame per order or FRAME_ORDER_BATCH frames. The receiver is the same
+// for all three (a thread per accepted connection, as the original server
+// did), so only the protocol differs; reactor_bench covers the front end.
+//   ./protocol_bench [clients] [ordersPerClient] [ordersPerBatch]
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "protocol.h"
+
+#define MODE_TEXT 0  // One connection per order, pid_t then "id x y pid\n"
+#define MODE_ORDER 1 // One connection, one ORDER frame per order
+#define MODE_BATCH 2 // One connection, ORDER_BATCH frames
+#define MODE_COUNT 3
+#define RUN_SECONDS 30.0
+
+static const char* mode_names[MODE_COUNT] = { "text, connection per order", "ORDER frame, one connection", "ORDER_BATCH, one connection" };
+static int client_count = 4;
+static int orders_per_client = 2000;
+static int batch_size = 64;
+static int mode;
+static int port;
+static atomic_long received = 0;
+static volatile long sink = 0;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int read_full(int fd, unsigned char* buffer, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = read(fd, buffer + done, length - done);
+        if (n <= 0) {
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+// Eski handle_client: PID, sonra tek satır sipariş
+static void read_text_order(int fd) {
+    pid_t pid;
+    char buffer[256];
+    size_t length = 0;
+    if (read_full(fd, (unsigned char*)&pid, sizeof(pid)) < 0) {
+        return;
+    }
+    while (length < sizeof(buffer) - 1 && memchr(buffer, '\n', length) == NULL) {
+        ssize_t n = read(fd, buffer + length, sizeof(buffer) - 1 - length);
+        if (n <= 0) {
+            break;
+        }
+        length += n;
+    }
+    buffer[length] = '\0';
+    int order_id, customer_x, customer_y, client_pid;
+    if (sscanf(buffer, "%d %d %d %d", &order_id, &customer_x, &customer_y, &client_pid) == 4) {
+        sink += order_id + customer_x + customer_y;
+        atomic_fetch_add(&received, 1);
+    }
+}
+
+static void read_frames(int fd) {
+    static __thread unsigned char payload[FRAME_MAX_PAYLOAD];
+    unsigned char header[FRAME_HEADER_SIZE];
+    while (read_full(fd, header, FRAME_HEADER_SIZE) == 0) {
+        uint32_t length = get_u32(header);
+        if (length > FRAME_MAX_PAYLOAD || header[4] != PROTOCOL_VERSION || read_full(fd, payload, length) < 0) {
+            return;
+        }
+        if (header[5] == FRAME_ORDER) {
+            sink += get_u32(payload + 4) + get_u32(payload + 8) + get_u32(payload + 12);
+            atomic_fetch_add(&received, 1);
+        } else if (header[5] == FRAME_ORDER_BATCH) {
+            uint32_t count = get_u32(payload + 4);
+            for (uint32_t i = 0; i < count; ++i) {
+                const unsigned char* entry = payload + BATCH_HEADER_SIZE + i * BATCH_ENTRY_SIZE;
+                sink += get_u32(entry) + get_u32(entry + 4) + get_u32(entry + 8);
+            }
+            atomic_fetch_add(&received, count);
+        }
+    }
+}
+
+static void* receiver(void* arg) {
+    int fd = (int)(long)arg;
+    if (mode == MODE_TEXT) {
+        read_text_order(fd);
+    } else {
+        read_frames(fd);
+    }
+    close(fd);
+    return NULL;
+}
+
+static void* accept_loop(void* arg) {
+    int listen_fd = (int)(long)arg;
+    while (1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            return NULL; // shutdown() at the end of the run
+        }
+        pthread_t thread;
+        pthread_create(&thread, NULL, receiver, (void*)(long)fd);
+        pthread_detach(thread);
+    }
+}
+
+static int connect_to_receiver(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        perror("connect");
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+static void* client(void* arg) {
+    pid_t pid = 1000 + (int)(long)arg;
+    if (mode == MODE_TEXT) {
+        for (int id = 1; id <= orders_per_client; ++id) {
+            int fd = connect_to_receiver();
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "%d %d %d %d\n", id, id % 10, id / 10 % 10, pid);
+            send(fd, &pid, sizeof(pid_t), MSG_NOSIGNAL);
+            send(fd, buffer, strlen(buffer), MSG_NOSIGNAL);
+            close(fd);
+        }
+        return NULL;
+    }
+
+    static __thread unsigned char frame[FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD];
+    int fd = connect_to_receiver();
+    size_t offset = put_frame_header(frame, FRAME_HELLO, HELLO_PAYLOAD_SIZE);
+    put_u32(frame + offset, (uint32_t)pid);
+    put_u32(frame + offset + 4, (uint32_t)orders_per_client);
+    put_u32(frame + offset + 8, 10);
+    put_u32(frame + offset + 12, 10);
+    send(fd, frame, FRAME_HEADER_SIZE + HELLO_PAYLOAD_SIZE, MSG_NOSIGNAL);
+
+    for (int id = 1; id <= orders_per_client;) {
+        size_t length;
+        if (mode == MODE_ORDER) {
+            offset = put_frame_header(frame, FRAME_ORDER, ORDER_PAYLOAD_SIZE);
+            put_u32(frame + offset, (uint32_t)pid);
+            put_u32(frame + offset + 4, (uint32_t)id);
+            put_u32(frame + offset + 8, (uint32_t)(id % 10));
+            put_u32(frame + offset + 12, (uint32_t)(id / 10 % 10));
+            length = FRAME_HEADER_SIZE + ORDER_PAYLOAD_SIZE;
+            id++;
+        } else {
+            int count = orders_per_client - id + 1 < batch_size ? orders_per_client - id + 1 : batch_size;
+            uint32_t payload_length = BATCH_HEADER_SIZE + count * BATCH_ENTRY_SIZE;
+            offset = put_frame_header(frame, FRAME_ORDER_BATCH, payload_length);
+            put_u32(frame + offset, (uint32_t)pid);
+            put_u32(frame + offset + 4, (uint32_t)count);
+            for (int i = 0; i < count; ++i, ++id) {
+                unsigned char* entry = frame + offset + BATCH_HEADER_SIZE + i * BATCH_ENTRY_SIZE;
+                put_u32(entry, (uint32_t)id);
+                put_u32(entry + 4, (uint32_t)(id % 10));
+                put_u32(entry + 8, (uint32_t)(id / 10 % 10));
+            }
+            length = FRAME_HEADER_SIZE + payload_length;
+        }
+        send(fd, frame, length, MSG_NOSIGNAL);
+    }
+    close(fd);
+    return NULL;
+}
+
+// Orders/s for one mode, 0 if not every order arrived within RUN_SECONDS
+static double run(int run_mode) {
+    mode = run_mode;
+    atomic_store(&received, 0);
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (bind(listen_fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listen_fd, SOMAXCONN) < 0 ||
+        getsockname(listen_fd, (struct sockaddr*)&address, &length) < 0) {
+        perror("listen");
+        exit(EXIT_FAILURE);
+    }
+    port = ntohs(address.sin_port);
+
+    pthread_t acceptor;
+    pthread_t* clients = malloc(client_count * sizeof(pthread_t));
+    pthread_create(&acceptor, NULL, accept_loop, (void*)(long)listen_fd);
+    long total = (long)client_count * orders_per_client;
+    double start = now_seconds();
+    for (int i = 0; i < client_count; ++i) {
+        pthread_create(&clients[i], NULL, client, (void*)(long)i);
+    }
+    for (int i = 0; i < client_count; ++i) {
+        pthread_join(clients[i], NULL);
+    }
+    while (atomic_load(&received) < total && now_seconds() - start < RUN_SECONDS) {
+        usleep(100);
+    }
+    double elapsed = now_seconds() - start;
+    long got = atomic_load(&received);
+
+    shutdown(listen_fd, SHUT_RDWR);
+    pthread_join(acceptor, NULL);
+    close(listen_fd);
+    free(clients);
+    printf("%-28s %8ld of %8ld orders in %7.3f s, %10.0f orders/s\n", mode_names[run_mode], got, total, elapsed, got / elapsed);
+    return got == total ? got / elapsed : 0.0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        client_count = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        orders_per_client = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        batch_size = atoi(argv[3]);
+    }
+    if (client_count < 1 || orders_per_client < 1 || batch_size < 1 || batch_size > BATCH_MAX_ORDERS) {
+        fprintf(stderr, "Usage: %s [clients] [ordersPerClient] [ordersPerBatch <= %d]\n", argv[0], BATCH_MAX_ORDERS);
+        return 1;
+    }
+
+    printf("%d clients, %d orders each, %d orders per batch\n", client_count, orders_per_client, batch_size);
+    double rates[MODE_COUNT];
+    for (int m = 0; m < MODE_COUNT; ++m) {
+        rates[m] = run(m);
+    }
+    if (rates[MODE_TEXT] > 0) {
+        printf("ORDER frames %.1fx, ORDER_BATCH %.1fx the orders/s of a connection per order\n", rates[MODE_ORDER] / rates[MODE_TEXT],
+               rates[MODE_BATCH] / rates[MODE_TEXT]);
+    }
+    return 0;
+}
@@ -0,0 +1,727 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <stdatomic.h>
+#include "uring.h"
+#include "reactor.h"
+
+typedef struct {
+    pthread_t thread_id;
+    int id;
+    int epoll_fd;
+    int wake_fd; // eventfd used by reactor_stop and reactor_resume to break epoll_wait
+    Connection* paused; // Only touched by this loop's thread
+    atomic_int resume_pending;
+    Uring ring;           // io_uring backend only
+    UringBuffers buffers; // Receive buffers shared by the loop's connections
+    uint64_t wake_value;  // Target of the pending wake_fd read
+} EventLoop;
+
+static EventLoop loops[REACTOR_MAX_LOOPS];
+static int loop_count = 0;
+static int next_loop = 0; // Round-robin cursor, only touched by loop 0
+static volatile int running = 0;
+static int backend = REACTOR_EPOLL;
+
+// Sentinels stored in epoll data (or io_uring user_data) to tell
+// listen/wake events from connections
+static Connection listen_markers[REACTOR_PORTS]; // port and fd of each listener
+static Connection wake_marker;
+static Connection cancel_marker;
+
+int reactor_parse_backend(const char* name) {
+    if (strcmp(name, "epoll") == 0) {
+        return REACTOR_EPOLL;
+    }
+    if (strcmp(name, "uring") == 0) {
+        return REACTOR_URING;
+    }
+    if (strcmp(name, "auto") == 0) {
+        return REACTOR_AUTO;
+    }
+    return -1;
+}
+
+const char* reactor_backend_name(int value) {
+    return value == REACTOR_URING ? "io_uring" : value == REACTOR_AUTO ? "auto" : "epoll";
+}
+
+int reactor_pick_backend(int requested) {
+    if (requested == REACTOR_EPOLL) {
+        return REACTOR_EPOLL;
+    }
+    if (uring_supported()) {
+        return REACTOR_URING;
+    }
+    if (requested == REACTOR_URING) {
+        fprintf(stderr, "> io_uring is not available here, using epoll\n");
+    }
+    return REACTOR_EPOLL;
+}
+
+static int set_nonblocking(int fd, int nonblocking) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) {
+        return -1;
+    }
+    return fcntl(fd, F_SETFL, nonblocking ? flags | O_NONBLOCK : flags & ~O_NONBLOCK);
+}
+
+// One multishot recv per connection: every arrival is a completion with a
+// buffer the kernel picked, until it is cancelled or runs out of buffers
+static void arm_recv(EventLoop* loop, Connection* conn) {
+    struct io_uring_sqe* sqe = uring_get_sqe(&loop->ring);
+    if (sqe == NULL) {
+        perror("io_uring_enter");
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn->fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = loop->buffers.group;
+    sqe->user_data = (unsigned long)conn;
+    conn->armed = 1;
+}
+
+static void cancel_recv(EventLoop* loop, Connection* conn) {
+    struct io_uring_sqe* sqe = uring_get_sqe(&loop->ring);
+    if (sqe == NULL) {
+        perror("io_uring_enter");
+        return;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = (unsigned long)conn;
+    sqe->user_data = (unsigned long)&cancel_marker;
+}
+
+// Every loop accepts on the shared sockets; the kernel hands each
+// connection to one of them
+static void arm_accept(EventLoop* loop, Connection* listener) {
+    struct io_uring_sqe* sqe = uring_get_sqe(&loop->ring);
+    if (sqe == NULL) {
+        perror("io_uring_enter");
+        return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listener->fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = (unsigned long)listener;
+}
+
+static void arm_wake(EventLoop* loop) {
+    struct io_uring_sqe* sqe = uring_get_sqe(&loop->ring);
+    if (sqe == NULL) {
+        perror("io_uring_enter");
+        return;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = loop->wake_fd;
+    sqe->addr = (unsigned long)&loop->wake_value;
+    sqe->len = sizeof(loop->wake_value);
+    sqe->user_data = (unsigned long)&wake_marker;
+}
+
+static Connection* listener_of(Connection* conn) {
+    for (int i = 0; i < REACTOR_PORTS; ++i) {
+        if (conn == &listen_markers[i]) {
+            return conn;
+        }
+    }
+    return NULL;
+}
+
+static void close_connection(EventLoop* loop, Connection* conn) {
+    // Orders of a client that went away are not worth cooking
+    if (conn->pid != 0) {
+        reactor_on_cancel(conn->pid, 0);
+        conn->pid = 0;
+    }
+    if (conn->paused) {
+        Connection** link = &loop->paused;
+        while (*link != conn) {
+            link = &(*link)->next_paused;
+        }
+        *link = conn->next_paused;
+        conn->paused = 0;
+    }
+    if (backend == REACTOR_URING) {
+        if (conn->armed && !conn->closing) {
+            cancel_recv(loop, conn);
+        }
+        conn->closing = 1;
+    } else if (conn->fd >= 0) {
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    }
+    // Off the loop first: the new owner may close the fd at any time
+    if (conn->subscribed) {
+        reactor_on_subscribe(conn->port, conn->fd, conn->subscriber);
+        conn->subscribed = 0;
+        conn->fd = -1;
+    }
+    // io_uring: the recv still points at conn, free it with its last completion
+    if (conn->armed) {
+        return;
+    }
+    free(conn->held);
+    if (conn->fd >= 0) {
+        close(conn->fd);
+    }
+    free(conn);
+}
+
+// Orders of one frame that were turned away, sent back in one FRAME_RETRY_AFTER
+static __thread unsigned char retry_frame[FRAME_HEADER_SIZE + RETRY_HEADER_SIZE + BATCH_MAX_ORDERS * RETRY_ENTRY_SIZE];
+static __thread uint32_t retry_count;
+static __thread uint32_t retry_after_ms;
+
+static void note_retry(int order_id, int retry_ms) {
+    put_u32(retry_frame + FRAME_HEADER_SIZE + RETRY_HEADER_SIZE + retry_count * RETRY_ENTRY_SIZE, (uint32_t)order_id);
+    retry_count++;
+    if ((uint32_t)retry_ms > retry_after_ms) {
+        retry_after_ms = (uint32_t)retry_ms;
+    }
+}
+
+// A client that does not read its retries is not worth waiting for
+static int send_retries(Connection* conn, pid_t pid) {
+    if (retry_count == 0) {
+        return 0;
+    }
+    uint32_t payload_length = RETRY_HEADER_SIZE + retry_count * RETRY_ENTRY_SIZE;
+    size_t offset = put_frame_header(retry_frame, FRAME_RETRY_AFTER, payload_length);
+    put_u32(retry_frame + offset, (uint32_t)pid);
+    put_u32(retry_frame + offset + 4, retry_after_ms);
+    put_u32(retry_frame + offset + 8, retry_count);
+    ssize_t sent = send(conn->fd, retry_frame, FRAME_HEADER_SIZE + payload_length, MSG_NOSIGNAL | MSG_DONTWAIT);
+    retry_count = retry_after_ms = 0;
+    if (sent != (ssize_t)(FRAME_HEADER_SIZE + payload_length)) {
+        fprintf(stderr, "> PID %d does not read its retries, dropping the connection\n", pid);
+        return -1;
+    }
+    return 0;
+}
+
+// Dispatch one complete frame. Returns -1 if the peer broke the protocol.
+static int dispatch_frame(Connection* conn, uint8_t type, const unsigned char* payload, uint32_t length) {
+    // Status and completion ports take one SUBSCRIBE and nothing else
+    if (conn->port != REACTOR_ORDERS) {
+        if (type != FRAME_SUBSCRIBE || length != SUBSCRIBE_PAYLOAD_SIZE) {
+            return -1;
+        }
+        conn->subscriber = (pid_t)get_u32(payload);
+        conn->subscribed = 1;
+        return 0;
+    }
+    switch (type) {
+        case FRAME_HELLO:
+            if (length < HELLO_PAYLOAD_SIZE) {
+                return -1;
+            }
+            conn->pid = (pid_t)get_u32(payload);
+            reactor_on_init((int)get_u32(payload + 4), (int)get_u32(payload + 8), (int)get_u32(payload + 12), conn->pid,
+                            length >= HELLO_PAYLOAD_SIZE + PROMISE_FIELD_SIZE ? (int)get_u32(payload + 16) : 0);
+            return 0;
+        case FRAME_ORDER: {
+            if (length < ORDER_PAYLOAD_SIZE) {
+                return -1;
+            }
+            int retry_ms = reactor_on_order((int)get_u32(payload + 4), (int)get_u32(payload + 8), (int)get_u32(payload + 12), (pid_t)get_u32(payload),
+                                            length >= ORDER_PAYLOAD_SIZE + PROMISE_FIELD_SIZE ? (int)get_u32(payload + 16) : 0);
+            if (retry_ms > 0) {
+                note_retry((int)get_u32(payload + 4), retry_ms);
+            }
+            return send_retries(conn, (pid_t)get_u32(payload));
+        }
+        case FRAME_ORDER_BATCH: {
+            if (length < BATCH_HEADER_SIZE) {
+                return -1;
+            }
+            pid_t pid = (pid_t)get_u32(payload);
+            uint32_t count = get_u32(payload + 4);
+            if (count > (length - BATCH_HEADER_SIZE) / BATCH_ENTRY_SIZE) {
+                return -1;
+            }
+            const unsigned char* entry = payload + BATCH_HEADER_SIZE;
+            for (uint32_t i = 0; i < count; ++i, entry += BATCH_ENTRY_SIZE) {
+                int retry_ms = reactor_on_order((int)get_u32(entry), (int)get_u32(entry + 4), (int)get_u32(entry + 8), pid, 0);
+                if (retry_ms > 0) {
+                    note_retry((int)get_u32(entry), retry_ms);
+                }
+            }
+            return send_retries(conn, pid);
+        }
+        case FRAME_CANCEL:
+            if (length < CANCEL_PAYLOAD_SIZE) {
+                return -1;
+            }
+            reactor_on_cancel((pid_t)get_u32(payload), (int)get_u32(payload + 4));
+            return 0;
+        default:
+            return 0; // Unknown frame types are skipped for forward compatibility
+    }
+}
+
+// Parse every complete frame in conn->buf. Returns -1 on a protocol error
+// or once a subscriber is ready to be handed off, 1 when intake is closed
+// and order frames are left in the buffer.
+static int process_frames(Connection* conn) {
+    int paused = 0;
+    size_t offset = 0;
+
+    while (conn->len - offset >= FRAME_HEADER_SIZE) {
+        const unsigned char* header = conn->buf + offset;
+        uint32_t length = get_u32(header);
+        if (header[4] != PROTOCOL_VERSION) {
+            fprintf(stderr, "> Unsupported protocol version %d from PID %d\n", header[4], conn->pid);
+            return -1;
+        }
+        if (length > FRAME_MAX_PAYLOAD) {
+            fprintf(stderr, "> Frame of %u bytes from PID %d is too long\n", length, conn->pid);
+            return -1;
+        }
+        if (conn->len - offset < FRAME_HEADER_SIZE + length) {
+            break;
+        }
+        if (conn->port == REACTOR_ORDERS && (header[5] == FRAME_ORDER || header[5] == FRAME_ORDER_BATCH) && !reactor_can_admit()) {
+            paused = 1;
+            break;
+        }
+        if (dispatch_frame(conn, header[5], header + FRAME_HEADER_SIZE, length) < 0) {
+            fprintf(stderr, "> Malformed frame type %d from PID %d\n", header[5], conn->pid);
+            return -1;
+        }
+        if (conn->subscribed) {
+            return -1;
+        }
+        offset += FRAME_HEADER_SIZE + length;
+    }
+
+    // Keep the partial frame at the start of the buffer
+    if (offset > 0) {
+        memmove(conn->buf, conn->buf + offset, conn->len - offset);
+        conn->len -= offset;
+    }
+    return paused;
+}
+
+// Stop reading: the kernel buffer fills, the TCP window closes and the
+// client's sends block, so the backlog waits on its side
+static void pause_connection(EventLoop* loop, Connection* conn) {
+    if (backend == REACTOR_URING) {
+        if (conn->armed) {
+            cancel_recv(loop, conn);
+        }
+    } else {
+        struct epoll_event ev;
+        ev.events = EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = conn;
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+    }
+    conn->paused = 1;
+    conn->next_paused = loop->paused;
+    loop->paused = conn;
+}
+
+static void handle_readable(EventLoop* loop, Connection* conn) {
+    // Edge-triggered: drain the socket until EAGAIN
+    while (1) {
+        ssize_t n = read(conn->fd, conn->buf + conn->len, CONN_BUFFER_SIZE - conn->len);
+        if (n > 0) {
+            conn->len += (size_t)n;
+            int rc = process_frames(conn);
+            if (rc < 0) {
+                close_connection(loop, conn);
+                return;
+            }
+            if (rc > 0) {
+                pause_connection(loop, conn);
+                return;
+            }
+        } else if (n == 0) {
+            close_connection(loop, conn);
+            return;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return;
+        } else {
+            perror("read");
+            close_connection(loop, conn);
+            return;
+        }
+    }
+}
+
+static void handle_accept(Connection* listener) {
+    while (1) {
+        int fd = accept4(listener->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("accept");
+            }
+            return;
+        }
+
+        Connection* conn = calloc(1, sizeof(Connection));
+        if (conn == NULL) {
+            perror("Failed to allocate connection");
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->port = listener->port;
+
+        // Spread connections over the loops
+        EventLoop* target = &loops[next_loop];
+        next_loop = (next_loop + 1) % loop_count;
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = conn;
+        if (epoll_ctl(target->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            perror("epoll_ctl");
+            close(fd);
+            free(conn);
+        }
+    }
+}
+
+// Bytes a recv completion brought: parsed a buffer at a time, and kept
+// aside once intake closes. Returns -1 if the connection must go.
+static int feed(EventLoop* loop, Connection* conn, const unsigned char* data, size_t n) {
+    while (n > 0 && !conn->paused) {
+        size_t chunk = CONN_BUFFER_SIZE - conn->len;
+        if (chunk > n) {
+            chunk = n;
+        }
+        memcpy(conn->buf + conn->len, data, chunk);
+        conn->len += chunk;
+        data += chunk;
+        n -= chunk;
+        int rc = process_frames(conn);
+        if (rc < 0) {
+            return -1;
+        }
+        if (rc > 0) {
+            pause_connection(loop, conn);
+        }
+    }
+    if (n > 0) {
+        // Only what was already in flight when the recv got cancelled
+        unsigned char* held = realloc(conn->held, conn->held_len + n);
+        if (held == NULL) {
+            perror("Failed to hold received bytes");
+            return -1;
+        }
+        memcpy(held + conn->held_len, data, n);
+        conn->held = held;
+        conn->held_len += n;
+    }
+    return 0;
+}
+
+static void handle_recv(EventLoop* loop, Connection* conn, int res, unsigned flags) {
+    if (flags & IORING_CQE_F_BUFFER) {
+        unsigned short id = (unsigned short)(flags >> IORING_CQE_BUFFER_SHIFT);
+        if (res > 0 && !conn->closing && feed(loop, conn, uring_buffer(&loop->buffers, id), (size_t)res) < 0) {
+            close_connection(loop, conn);
+        }
+        uring_buffer_recycle(&loop->buffers, id);
+    }
+    if (flags & IORING_CQE_F_MORE) {
+        return;
+    }
+
+    // The recv is over: cancelled, out of buffers, end of stream or an error
+    conn->armed = 0;
+    if (res < 0 && res != -ECANCELED && res != -ENOBUFS && !conn->closing) {
+        errno = -res;
+        perror("recv");
+    }
+    if (conn->closing || res == 0 || (res < 0 && res != -ECANCELED && res != -ENOBUFS)) {
+        close_connection(loop, conn);
+    } else if (!conn->paused) {
+        arm_recv(loop, conn);
+    }
+}
+
+static void handle_uring_accept(EventLoop* loop, Connection* listener, int res, unsigned flags) {
+    if (res >= 0) {
+        Connection* conn = calloc(1, sizeof(Connection));
+        if (conn == NULL) {
+            perror("Failed to allocate connection");
+            close(res);
+        } else {
+            conn->fd = res;
+            conn->port = listener->port;
+            arm_recv(loop, conn);
+        }
+    } else if (res != -ECANCELED) {
+        errno = -res;
+        perror("accept");
+    }
+    if (!(flags & IORING_CQE_F_MORE) && running) {
+        arm_accept(loop, listener);
+    }
+}
+
+// Buffered frames first, then the bytes held since the pause, then the socket
+static void resume_held(EventLoop* loop, Connection* conn) {
+    int rc = process_frames(conn);
+    if (rc < 0) {
+        close_connection(loop, conn);
+        return;
+    }
+    if (rc > 0) {
+        pause_connection(loop, conn);
+        return;
+    }
+    unsigned char* held = conn->held;
+    size_t held_len = conn->held_len;
+    conn->held = NULL;
+    conn->held_len = 0;
+    rc = feed(loop, conn, held, held_len);
+    free(held);
+    if (rc < 0) {
+        close_connection(loop, conn);
+    } else if (!conn->paused && !conn->armed) {
+        arm_recv(loop, conn);
+    }
+}
+
+// Frames already buffered go first, then whatever the socket has
+static void resume_paused(EventLoop* loop) {
+    Connection* conn = loop->paused;
+    loop->paused = NULL;
+    while (conn != NULL) {
+        Connection* next = conn->next_paused;
+        conn->paused = 0;
+        if (backend == REACTOR_URING) {
+            resume_held(loop, conn);
+            conn = next;
+            continue;
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = conn;
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+        int rc = process_frames(conn);
+        if (rc < 0) {
+            close_connection(loop, conn);
+        } else if (rc > 0) {
+            pause_connection(loop, conn);
+        } else {
+            handle_readable(loop, conn);
+        }
+        conn = next;
+    }
+}
+
+static void* event_loop(void* arg) {
+    EventLoop* loop = (EventLoop*)arg;
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    while (running) {
+        int n = epoll_wait(loop->epoll_fd, events, REACTOR_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            Connection* conn = (Connection*)events[i].data.ptr;
+            if (conn == &wake_marker) {
+                uint64_t value;
+                read(loop->wake_fd, &value, sizeof(value));
+                if (atomic_exchange(&loop->resume_pending, 0)) {
+                    resume_paused(loop);
+                }
+            } else if (listener_of(conn) != NULL) {
+                handle_accept(conn);
+            } else if (conn->paused) {
+                // Half-closed is fine, the rest is read on resume
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    close_connection(loop, conn);
+                }
+            } else {
+                handle_readable(loop, conn);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+// One io_uring_enter submits everything queued since the last one and
+// waits for a batch of completions, then every completion is handled
+static void* uring_loop(void* arg) {
+    EventLoop* loop = (EventLoop*)arg;
+    arm_wake(loop);
+    for (int i = 0; i < REACTOR_PORTS; ++i) {
+        if (listen_markers[i].fd >= 0) {
+            arm_accept(loop, &listen_markers[i]);
+        }
+    }
+
+    while (running) {
+        if (uring_wait_batch(&loop->ring, REACTOR_URING_BATCH, REACTOR_URING_BATCH_US) < 0) {
+            perror("io_uring_enter");
+            break;
+        }
+        struct io_uring_cqe* cqe;
+        while ((cqe = uring_peek(&loop->ring)) != NULL) {
+            Connection* conn = (Connection*)(unsigned long)cqe->user_data;
+            int res = cqe->res;
+            unsigned flags = cqe->flags;
+            uring_seen(&loop->ring);
+
+            if (conn == &wake_marker) {
+                arm_wake(loop);
+                if (atomic_exchange(&loop->resume_pending, 0)) {
+                    resume_paused(loop);
+                }
+            } else if (listener_of(conn) != NULL) {
+                handle_uring_accept(loop, conn, res, flags);
+            } else if (conn != &cancel_marker) {
+                handle_recv(loop, conn, res, flags);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static int start_uring_loop(EventLoop* loop) {
+    // Blocking eventfd: io_uring would answer a nonblocking read with EAGAIN
+    loop->wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (loop->wake_fd < 0) {
+        perror("eventfd");
+        return -1;
+    }
+    if (uring_init(&loop->ring, URING_ENTRIES) < 0) {
+        perror("io_uring_setup");
+        return -1;
+    }
+    if (uring_buffers_init(&loop->ring, &loop->buffers, 0) < 0) {
+        perror("io_uring_register");
+        return -1;
+    }
+    return 0;
+}
+
+int reactor_start(const int listen_fds[REACTOR_PORTS], int count, int requested) {
+    if (count < 1) {
+        count = 1;
+    }
+    if (count > REACTOR_MAX_LOOPS) {
+        count = REACTOR_MAX_LOOPS;
+    }
+
+    loop_count = count;
+    backend = reactor_pick_backend(requested);
+    running = 1;
+
+    for (int i = 0; i < REACTOR_PORTS; ++i) {
+        listen_markers[i].port = i;
+        listen_markers[i].fd = listen_fds[i];
+        if (listen_fds[i] >= 0 && set_nonblocking(listen_fds[i], backend == REACTOR_EPOLL) < 0) {
+            perror("fcntl");
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < loop_count; ++i) {
+        loops[i].id = i;
+        loops[i].paused = NULL;
+        atomic_init(&loops[i].resume_pending, 0);
+        if (backend == REACTOR_URING) {
+            if (start_uring_loop(&loops[i]) < 0) {
+                return -1;
+            }
+            continue;
+        }
+        loops[i].epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        loops[i].wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (loops[i].epoll_fd < 0 || loops[i].wake_fd < 0) {
+            perror("epoll_create1");
+            return -1;
+        }
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.ptr = &wake_marker;
+        epoll_ctl(loops[i].epoll_fd, EPOLL_CTL_ADD, loops[i].wake_fd, &ev);
+    }
+
+    if (backend == REACTOR_URING) {
+        for (int i = 0; i < loop_count; ++i) {
+            pthread_create(&loops[i].thread_id, NULL, uring_loop, &loops[i]);
+        }
+        return 0;
+    }
+
+    // Only loop 0 accepts, then hands connections to the others
+    for (int i = 0; i < REACTOR_PORTS; ++i) {
+        if (listen_markers[i].fd < 0) {
+            continue;
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.ptr = &listen_markers[i];
+        if (epoll_ctl(loops[0].epoll_fd, EPOLL_CTL_ADD, listen_markers[i].fd, &ev) < 0) {
+            perror("epoll_ctl");
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < loop_count; ++i) {
+        pthread_create(&loops[i].thread_id, NULL, event_loop, &loops[i]);
+    }
+    return 0;
+}
+
+void reactor_resume(void) {
+    for (int i = 0; i < loop_count; ++i) {
+        atomic_store(&loops[i].resume_pending, 1);
+        uint64_t one = 1;
+        write(loops[i].wake_fd, &one, sizeof(one));
+    }
+}
+
+void reactor_stop(void) {
+    if (!running) {
+        return;
+    }
+    running = 0;
+    for (int i = 0; i < loop_count; ++i) {
+        uint64_t one = 1;
+        write(loops[i].wake_fd, &one, sizeof(one));
+    }
+    for (int i = 0; i < loop_count; ++i) {
+        pthread_join(loops[i].thread_id, NULL);
+        if (backend == REACTOR_URING) {
+            uring_buffers_free(&loops[i].ring, &loops[i].buffers);
+            uring_exit(&loops[i].ring);
+        } else {
+            close(loops[i].epoll_fd);
+        }
+        close(loops[i].wake_fd);
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <sys/types.h>
+#include "protocol.h"
+
+#define REACTOR_MAX_LOOPS 16
+#define REACTOR_MAX_EVENTS 64
+#define CONN_BUFFER_SIZE (FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD)
+
+// Event loop backends
+#define REACTOR_EPOLL 0 // Edge-triggered epoll and nonblocking reads, as before
+#define REACTOR_URING 1 // io_uring: multishot accept and recv into provided buffers
+#define REACTOR_AUTO 2  // io_uring if the kernel has it, else epoll
+#define REACTOR_URING_BATCH 64       // Completions an io_uring loop waits for...
+#define REACTOR_URING_BATCH_US 1000  // ...at most this long once the first one is in
+
+// Listening ports, in reactor_start's listen_fds order
+#define REACTOR_ORDERS 0     // port: HELLO, ORDER, ORDER_BATCH and CANCEL frames
+#define REACTOR_STATUS 1     // port+1: one SUBSCRIBE, then the status bus owns the socket
+#define REACTOR_COMPLETION 2 // port+2: one SUBSCRIBE, then the session owns the socket
+#define REACTOR_PORTS 3
+
+typedef struct Connection {
+    int fd;                              // -1 once handed to a subscriber list
+    int port;                            // REACTOR_ORDERS, REACTOR_STATUS or REACTOR_COMPLETION
+    pid_t pid;                           // From the HELLO frame, 0 until then
+    int subscribed;                      // SUBSCRIBE read, handed off when closed
+    pid_t subscriber;                    // Its PID, 0 for every order
+    int paused;                          // Not read while intake is closed
+    struct Connection* next_paused;      // Loop's paused list
+    int armed;                           // io_uring: a multishot recv is in flight
+    int closing;                         // io_uring: freed when the recv completes
+    unsigned char* held;                 // io_uring: bytes received after pausing
+    size_t held_len;
+    size_t len;                          // Bytes waiting in buf
+    unsigned char buf[CONN_BUFFER_SIZE]; // Partial frame storage
+} Connection;
+
+int reactor_parse_backend(const char* name);
+const char* reactor_backend_name(int backend);
+int reactor_pick_backend(int requested); // Resolves auto, falls back to epoll without io_uring
+int reactor_start(const int listen_fds[REACTOR_PORTS], int loops, int backend); // -1 skips a port
+void reactor_stop(void);
+void reactor_resume(void); // Intake is open again: read the paused connections
+
+// Hooks implemented by the server
+void reactor_on_init(int number_of_clients, int p, int q, pid_t pid, int promise_ms);
+int reactor_can_admit(void); // 0: leave order frames unread and pause the connection
+int reactor_on_order(int order_id, int customer_x, int customer_y, pid_t pid, int promise_ms); // 0 taken, else retry after this many ms
+void reactor_on_cancel(pid_t pid, int order_id); // order_id 0: every order, also sent when the connection drops
+void reactor_on_subscribe(int port, int fd, pid_t pid); // Takes fd, already off the loop; closes it if unwanted
+
+#endif
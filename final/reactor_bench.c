@@ -0,0 +1,385 @@
+// Front end load test. Orders: client threads send orders to the reactor
+// over one connection each in FRAME_ORDER_BATCH frames, as HungryVeryMuch
+// does, and to the original front end: one connection per order, a blocking
+// accept loop with listen(fd, 3) and a detached thread reading each order,
+// then the same with a SOMAXCONN backlog to tell the threads from the drops.
+// Subscriptions: a few silent peers connect first, then every client thread
+// subscribes in turn, once to the reactor and once to the old status and
+// completion loop (blocking accept, blocking read with a 1 s SO_RCVTIMEO).
+// Each run stops after RUN_SECONDS; the old front end drops SYNs from a
+// burst of connects and may not get through its share in that time.
+//   ./reactor_bench [clients] [ordersPerClient] [subscribesPerClient]
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "protocol.h"
+#include "reactor.h"
+
+#define SILENT_PEERS 4
+#define LEGACY_BACKLOG 3 // listen() backlog of the original server
+#define TARGET_P99_MS 100.0
+#define RUN_SECONDS 10.0
+
+static atomic_int received = 0;
+static int client_count = 16;
+static int orders_per_client = 500;
+static int subscribes_per_client = 32;
+static int port = 0;
+static double deadline; // End of the current run
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// A subscriber is answered with one byte so the client can time it
+static void acknowledge(int fd) {
+    unsigned char ack = 1;
+    send(fd, &ack, 1, MSG_NOSIGNAL);
+    close(fd);
+}
+
+// Reactor hooks: orders are only counted
+void reactor_on_init(int number_of_clients, int p, int q, pid_t pid, int promise_ms) {
+    (void)number_of_clients, (void)p, (void)q, (void)pid, (void)promise_ms;
+}
+
+int reactor_can_admit(void) {
+    return 1;
+}
+
+int reactor_on_order(int order_id, int customer_x, int customer_y, pid_t pid, int promise_ms) {
+    (void)order_id, (void)customer_x, (void)customer_y, (void)pid, (void)promise_ms;
+    atomic_fetch_add_explicit(&received, 1, memory_order_relaxed);
+    return 0;
+}
+
+void reactor_on_cancel(pid_t pid, int order_id) {
+    (void)pid, (void)order_id;
+}
+
+void reactor_on_subscribe(int port_kind, int fd, pid_t pid) {
+    (void)port_kind, (void)pid;
+    acknowledge(fd);
+}
+
+// The original handle_client: one text order per connection
+static void* legacy_client_thread(void* arg) {
+    int fd = (int)(long)arg;
+    char buffer[64] = { 0 };
+    if (read(fd, buffer, sizeof(buffer) - 1) > 0) {
+        int order_id, customer_x, customer_y;
+        pid_t pid;
+        if (sscanf(buffer, "%d %d %d %d", &order_id, &customer_x, &customer_y, &pid) == 4) {
+            atomic_fetch_add_explicit(&received, 1, memory_order_relaxed);
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+static void* legacy_accept_orders(void* arg) {
+    int listen_fd = (int)(long)arg;
+    while (1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            perror("accept");
+            continue;
+        }
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, legacy_client_thread, (void*)(long)fd) != 0) {
+            close(fd);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+// The status and completion threads before the reactor took their ports
+static void* legacy_accept_subscribers(void* arg) {
+    int listen_fd = (int)(long)arg;
+    while (1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            perror("accept");
+            continue;
+        }
+        struct timeval timeout = { 1, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        unsigned char frame[FRAME_HEADER_SIZE + SUBSCRIBE_PAYLOAD_SIZE];
+        size_t got = 0;
+        while (got < sizeof(frame)) {
+            ssize_t n = read(fd, frame + got, sizeof(frame) - got);
+            if (n <= 0) {
+                break;
+            }
+            got += (size_t)n;
+        }
+        if (got == sizeof(frame) && frame[5] == FRAME_SUBSCRIBE) {
+            acknowledge(fd);
+        } else {
+            close(fd);
+        }
+    }
+    return NULL;
+}
+
+// -1 once the run is over. A connect whose SYN was dropped sits in
+// retransmit backoff; it is given a second, then tried again.
+static int connect_to(int target_port) {
+    struct sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_port = htons(target_port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    while (now_seconds() < deadline) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct timeval timeout = { 1, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        if (connect(fd, (struct sockaddr*)&address, sizeof(address)) == 0) {
+            return fd;
+        }
+        if (errno != EINPROGRESS && errno != EAGAIN && errno != ETIMEDOUT) {
+            perror("connect");
+            exit(EXIT_FAILURE);
+        }
+        close(fd);
+    }
+    return -1;
+}
+
+static int listen_on(int backlog) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(fd, backlog) < 0 ||
+        getsockname(fd, (struct sockaddr*)&address, &length) < 0) {
+        perror("listen");
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+static int port_of(int fd) {
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(fd, (struct sockaddr*)&address, &length);
+    return ntohs(address.sin_port);
+}
+
+static void* legacy_orders_client(void* arg) {
+    int index = (int)(long)arg;
+    for (int id = 1; id <= orders_per_client; ++id) {
+        int fd = connect_to(port);
+        if (fd < 0) {
+            break;
+        }
+        char line[64];
+        int length = snprintf(line, sizeof(line), "%d %d %d %d", id, id % 10, id / 10 % 10, 1000 + index);
+        send(fd, line, (size_t)length, MSG_NOSIGNAL);
+        close(fd);
+    }
+    return NULL;
+}
+
+static void* reactor_orders_client(void* arg) {
+    int index = (int)(long)arg;
+    int fd = connect_to(port);
+    if (fd < 0) {
+        return (void*)-1L;
+    }
+    pid_t pid = 1000 + index;
+    unsigned char* frame = malloc(FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD);
+    size_t offset = put_frame_header(frame, FRAME_HELLO, HELLO_PAYLOAD_SIZE);
+    put_u32(frame + offset, (uint32_t)pid);
+    put_u32(frame + offset + 4, (uint32_t)orders_per_client);
+    put_u32(frame + offset + 8, 10);
+    put_u32(frame + offset + 12, 10);
+    send(fd, frame, FRAME_HEADER_SIZE + HELLO_PAYLOAD_SIZE, MSG_NOSIGNAL);
+
+    for (int first = 1; first <= orders_per_client; first += BATCH_MAX_ORDERS) {
+        int count = orders_per_client - first + 1 < BATCH_MAX_ORDERS ? orders_per_client - first + 1 : BATCH_MAX_ORDERS;
+        uint32_t payload_length = BATCH_HEADER_SIZE + count * BATCH_ENTRY_SIZE;
+        offset = put_frame_header(frame, FRAME_ORDER_BATCH, payload_length);
+        put_u32(frame + offset, (uint32_t)pid);
+        put_u32(frame + offset + 4, (uint32_t)count);
+        unsigned char* entry = frame + offset + BATCH_HEADER_SIZE;
+        for (int id = first; id < first + count; ++id, entry += BATCH_ENTRY_SIZE) {
+            put_u32(entry, (uint32_t)id);
+            put_u32(entry + 4, (uint32_t)(id % 10));
+            put_u32(entry + 8, (uint32_t)(id / 10 % 10));
+        }
+        send(fd, frame, FRAME_HEADER_SIZE + payload_length, MSG_NOSIGNAL);
+    }
+    free(frame);
+    return (void*)(long)fd;
+}
+
+static double run_orders(const char* name, int target_port, int legacy) {
+    atomic_store(&received, 0);
+    port = target_port;
+    int total = client_count * orders_per_client;
+    pthread_t* threads = malloc(client_count * sizeof(pthread_t));
+    double start = now_seconds();
+    deadline = start + RUN_SECONDS;
+    for (int i = 0; i < client_count; ++i) {
+        pthread_create(&threads[i], NULL, legacy ? legacy_orders_client : reactor_orders_client, (void*)(long)i);
+    }
+    while (atomic_load(&received) < total && now_seconds() < deadline) {
+        usleep(200);
+    }
+    double seconds = now_seconds() - start;
+    int arrived = atomic_load(&received);
+    for (int i = 0; i < client_count; ++i) {
+        void* fd;
+        pthread_join(threads[i], &fd);
+        if (!legacy && (long)fd >= 0) {
+            close((int)(long)fd);
+        }
+    }
+    free(threads);
+    printf("orders    %-12s %6d of %6d in %6.3f s: %10.0f orders/s\n", name, arrived, total, seconds, arrived / seconds);
+    return arrived / seconds;
+}
+
+static double* latencies; // -1 until answered
+static atomic_int answered;
+
+// Subscribe, wait for the answer, hang up; one after another
+static void* subscribe_client(void* arg) {
+    int index = (int)(long)arg;
+    for (int i = 0; i < subscribes_per_client; ++i) {
+        double start = now_seconds();
+        int fd = connect_to(port);
+        if (fd < 0) {
+            break;
+        }
+        unsigned char frame[FRAME_HEADER_SIZE + SUBSCRIBE_PAYLOAD_SIZE];
+        size_t offset = put_frame_header(frame, FRAME_SUBSCRIBE, SUBSCRIBE_PAYLOAD_SIZE);
+        put_u32(frame + offset, (uint32_t)(1000 + index));
+        send(fd, frame, sizeof(frame), MSG_NOSIGNAL);
+        // Timeouts are retried until the run is over
+        unsigned char ack;
+        ssize_t n;
+        while ((n = recv(fd, &ack, 1, 0)) < 0 && errno == EAGAIN && now_seconds() < deadline) {
+        }
+        close(fd);
+        if (n != 1) {
+            break;
+        }
+        latencies[index * subscribes_per_client + i] = now_seconds() - start;
+        atomic_fetch_add(&answered, 1);
+    }
+    return NULL;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// p99 latency in ms; unanswered subscriptions count as the whole run
+static double run_subscribes(const char* name, int target_port) {
+    port = target_port;
+    int total = client_count * subscribes_per_client;
+    latencies = malloc(total * sizeof(double));
+    for (int i = 0; i < total; ++i) {
+        latencies[i] = -1;
+    }
+    atomic_store(&answered, 0);
+    double start = now_seconds();
+    deadline = start + RUN_SECONDS;
+    int silent[SILENT_PEERS];
+    for (int i = 0; i < SILENT_PEERS; ++i) {
+        silent[i] = connect_to(port);
+    }
+
+    pthread_t* threads = malloc(client_count * sizeof(pthread_t));
+    for (int i = 0; i < client_count; ++i) {
+        pthread_create(&threads[i], NULL, subscribe_client, (void*)(long)i);
+    }
+    for (int i = 0; i < client_count; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    double seconds = now_seconds() - start;
+    for (int i = 0; i < SILENT_PEERS; ++i) {
+        if (silent[i] >= 0) {
+            close(silent[i]);
+        }
+    }
+    free(threads);
+
+    for (int i = 0; i < total; ++i) {
+        if (latencies[i] < 0) {
+            latencies[i] = seconds;
+        }
+    }
+    qsort(latencies, total, sizeof(double), compare_doubles);
+    double p50 = latencies[total / 2] * 1000;
+    double p99 = latencies[total * 99 / 100] * 1000;
+    free(latencies);
+    int served = atomic_load(&answered);
+    printf("subscribe %-12s %6d of %6d in %6.3f s: %10.0f subscribes/s, p50 %8.2f ms, p99 %8.2f ms\n", name, served, total, seconds,
+           served / seconds, p50, p99);
+    return p99;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        client_count = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        orders_per_client = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        subscribes_per_client = atoi(argv[3]);
+    }
+    if (client_count < 1 || orders_per_client < 1 || subscribes_per_client < 1) {
+        fprintf(stderr, "Usage: %s [clients] [ordersPerClient] [subscribesPerClient]\n", argv[0]);
+        return 1;
+    }
+
+    int legacy_orders = listen_on(LEGACY_BACKLOG);
+    int thread_orders = listen_on(SOMAXCONN);
+    int legacy_subscribers = listen_on(LEGACY_BACKLOG);
+    int listen_fds[REACTOR_PORTS] = { listen_on(SOMAXCONN), -1, listen_on(SOMAXCONN) };
+    pthread_t thread;
+    pthread_create(&thread, NULL, legacy_accept_orders, (void*)(long)legacy_orders);
+    pthread_detach(thread);
+    pthread_create(&thread, NULL, legacy_accept_orders, (void*)(long)thread_orders);
+    pthread_detach(thread);
+    pthread_create(&thread, NULL, legacy_accept_subscribers, (void*)(long)legacy_subscribers);
+    pthread_detach(thread);
+
+    printf("%d clients, %d orders and %d subscriptions each, %d silent subscribers\n", client_count, orders_per_client,
+           subscribes_per_client, SILENT_PEERS);
+    run_orders("backlog 3", port_of(legacy_orders), 1);
+    double thread_rate = run_orders("thread/conn", port_of(thread_orders), 1);
+    double legacy_p99 = run_subscribes("blocking", port_of(legacy_subscribers));
+
+    int backends[2] = { REACTOR_EPOLL, REACTOR_URING };
+    int backend_count = reactor_pick_backend(REACTOR_AUTO) == REACTOR_URING ? 2 : 1;
+    for (int i = 0; i < backend_count; ++i) {
+        if (reactor_start(listen_fds, 1, backends[i]) < 0) {
+            return 1;
+        }
+        double rate = run_orders(reactor_backend_name(backends[i]), port_of(listen_fds[REACTOR_ORDERS]), 0);
+        double p99 = run_subscribes(reactor_backend_name(backends[i]), port_of(listen_fds[REACTOR_COMPLETION]));
+        reactor_stop();
+        printf("%-8s %.1fx the orders/s of thread/conn, subscribe p99 %.2f ms vs %.2f ms, target < %.0f ms: %s\n",
+               reactor_backend_name(backends[i]), rate / thread_rate, p99, legacy_p99, TARGET_P99_MS, p99 < TARGET_P99_MS ? "ok" : "MISSED");
+    }
+    return 0;
+}
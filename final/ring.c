@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sched.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include "ring.h"
+
+static void futex_wait(atomic_uint* word, unsigned int expected) {
+    syscall(SYS_futex, (unsigned int*)word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void futex_wake(atomic_uint* word, int count) {
+    syscall(SYS_futex, (unsigned int*)word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+int ring_init(OrderRing* ring, size_t capacity) {
+    // Capacity must be a power of two for the index mask
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    ring->cells = aligned_alloc(CACHE_LINE_SIZE, ((size * sizeof(RingCell) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE);
+    if (ring->cells == NULL) {
+        perror("Failed to allocate ring");
+        return -1;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        atomic_init(&ring->cells[i].sequence, i);
+    }
+    ring->mask = size - 1;
+    atomic_init(&ring->enqueue_pos, 0);
+    atomic_init(&ring->dequeue_pos, 0);
+    atomic_init(&ring->not_empty, 0);
+    atomic_init(&ring->waiters, 0);
+    return 0;
+}
+
+void ring_destroy(OrderRing* ring) {
+    free(ring->cells);
+    ring->cells = NULL;
+}
+
+// Returns 0 on success, -1 if the ring is full
+int ring_try_enqueue(OrderRing* ring, const Order* order) {
+    size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    RingCell* cell;
+
+    while (1) {
+        cell = &ring->cells[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    cell->order = *order;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+
+    // Only pay for the futex syscall when somebody is actually asleep
+    atomic_fetch_add_explicit(&ring->not_empty, 1, memory_order_seq_cst);
+    if (atomic_load_explicit(&ring->waiters, memory_order_seq_cst) > 0) {
+        futex_wake(&ring->not_empty, 1);
+    }
+    return 0;
+}
+
+// Returns 0 on success, -1 if the ring is empty
+int ring_try_dequeue(OrderRing* ring, Order* order) {
+    size_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    RingCell* cell;
+
+    while (1) {
+        cell = &ring->cells[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->dequeue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    *order = cell->order;
+    atomic_store_explicit(&cell->sequence, pos + ring->mask + 1, memory_order_release);
+    return 0;
+}
+
+// Blocking enqueue. A full ring is rare, so producers just yield.
+void ring_enqueue(OrderRing* ring, const Order* order) {
+    while (ring_try_enqueue(ring, order) < 0) {
+        sched_yield();
+    }
+}
+
+// Blocking dequeue, sleeps on the futex word while the ring is empty
+Order ring_dequeue(OrderRing* ring) {
+    Order order;
+    while (1) {
+        if (ring_try_dequeue(ring, &order) == 0) {
+            return order;
+        }
+
+        unsigned int seen = atomic_load_explicit(&ring->not_empty, memory_order_seq_cst);
+        atomic_fetch_add_explicit(&ring->waiters, 1, memory_order_seq_cst);
+        // Re-check after announcing ourselves so a racing enqueue is not missed
+        if (ring_try_dequeue(ring, &order) == 0) {
+            atomic_fetch_sub_explicit(&ring->waiters, 1, memory_order_seq_cst);
+            return order;
+        }
+        futex_wait(&ring->not_empty, seen);
+        atomic_fetch_sub_explicit(&ring->waiters, 1, memory_order_seq_cst);
+    }
+}
+
+// Approximate number of orders in the ring
+size_t ring_size(OrderRing* ring) {
+    size_t tail = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+}
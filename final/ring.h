@@ -0,0 +1,37 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include "pideshop.h"
+
+#define CACHE_LINE_SIZE 64
+#define RING_CAPACITY 1024
+
+// One slot of the ring. sequence tells producers and consumers whose turn it is.
+typedef struct {
+    atomic_size_t sequence;
+    Order order;
+} RingCell;
+
+// Bounded lock-free MPMC ring (Vyukov). Orders are stored by value, so
+// enqueue/dequeue never touch malloc. Head, tail and the futex word live on
+// their own cache lines to keep producers and consumers from false sharing.
+typedef struct {
+    RingCell* cells;
+    size_t mask;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t enqueue_pos;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t dequeue_pos;
+    _Alignas(CACHE_LINE_SIZE) atomic_uint not_empty; // Futex word, bumped on enqueue
+    atomic_int waiters;                              // Consumers sleeping on not_empty
+} OrderRing;
+
+int ring_init(OrderRing* ring, size_t capacity);
+void ring_destroy(OrderRing* ring);
+int ring_try_enqueue(OrderRing* ring, const Order* order);
+int ring_try_dequeue(OrderRing* ring, Order* order);
+void ring_enqueue(OrderRing* ring, const Order* order);
+Order ring_dequeue(OrderRing* ring);
+size_t ring_size(OrderRing* ring);
+
+#endif
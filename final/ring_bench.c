@@ -0,0 +1,202 @@
+// Order hand-off benchmark: 1 to 64 producers pass orders to as many
+// consumers, once through the lock-free MPMC ring (ring.c) and once through
+// the original malloc-per-node Queue with a mutex and condition variable.
+// Prints orders/s and the p99 of enqueue to dequeue latency.
+//   ./ring_bench [orders]
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include "ring.h"
+
+#define BENCH_MAX_THREADS 64
+#define SAMPLE_EVERY 16 // Latency of every 16th order
+
+typedef struct QueueNode {
+    Order order;
+    struct QueueNode* next;
+} QueueNode;
+
+typedef struct {
+    QueueNode* front;
+    QueueNode* rear;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} Queue;
+
+static int order_count = 200000;
+static int thread_count = 1;
+static OrderRing ring;
+static Queue legacy;
+static double* samples = NULL;
+static atomic_int sample_count = 0;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Eski kuyruk, server.c'deki haliyle
+static void legacy_enqueue(Queue* q, Order order) {
+    QueueNode* temp = (QueueNode*)malloc(sizeof(QueueNode));
+    temp->order = order;
+    temp->next = NULL;
+
+    pthread_mutex_lock(&q->mutex);
+    if (q->rear == NULL) {
+        q->front = q->rear = temp;
+    } else {
+        q->rear->next = temp;
+        q->rear = temp;
+    }
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+static Order legacy_dequeue(Queue* q) {
+    pthread_mutex_lock(&q->mutex);
+    while (q->front == NULL) {
+        pthread_cond_wait(&q->cond, &q->mutex);
+    }
+    QueueNode* temp = q->front;
+    Order order = temp->order;
+    q->front = q->front->next;
+    if (q->front == NULL) {
+        q->rear = NULL;
+    }
+    pthread_mutex_unlock(&q->mutex);
+    free(temp);
+    return order;
+}
+
+static void record(const Order* order) {
+    if (order->order_id % SAMPLE_EVERY == 0) {
+        samples[atomic_fetch_add(&sample_count, 1)] = now_seconds() - order->placed_at;
+    }
+}
+
+static void* ring_producer(void* arg) {
+    long id = (long)arg;
+    Order order = { 0 };
+    for (int i = id; i < order_count; i += thread_count) {
+        order.order_id = i;
+        order.placed_at = now_seconds();
+        ring_enqueue(&ring, &order);
+    }
+    return NULL;
+}
+
+static void* ring_consumer(void* arg) {
+    (void)arg;
+    while (1) {
+        Order order = ring_dequeue(&ring);
+        if (order.order_id < 0) {
+            return NULL; // Stop marker, one per consumer
+        }
+        record(&order);
+    }
+}
+
+static void* legacy_producer(void* arg) {
+    long id = (long)arg;
+    Order order = { 0 };
+    for (int i = id; i < order_count; i += thread_count) {
+        order.order_id = i;
+        order.placed_at = now_seconds();
+        legacy_enqueue(&legacy, order);
+    }
+    return NULL;
+}
+
+static void* legacy_consumer(void* arg) {
+    (void)arg;
+    while (1) {
+        Order order = legacy_dequeue(&legacy);
+        if (order.order_id < 0) {
+            return NULL;
+        }
+        record(&order);
+    }
+}
+
+static void stop_ring(void) {
+    Order order = { 0 };
+    order.order_id = -1;
+    ring_enqueue(&ring, &order);
+}
+
+static void stop_legacy(void) {
+    Order order = { 0 };
+    order.order_id = -1;
+    legacy_enqueue(&legacy, order);
+}
+
+// Orders/s for one queue, p99 latency in *p99
+static double run(void* (*producer)(void*), void* (*consumer)(void*), void (*stop)(void), double* p99) {
+    pthread_t producers[BENCH_MAX_THREADS];
+    pthread_t consumers[BENCH_MAX_THREADS];
+    atomic_store(&sample_count, 0);
+
+    double start = now_seconds();
+    for (long i = 0; i < thread_count; ++i) {
+        pthread_create(&consumers[i], NULL, consumer, NULL);
+        pthread_create(&producers[i], NULL, producer, (void*)i);
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        pthread_join(producers[i], NULL);
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        stop();
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        pthread_join(consumers[i], NULL);
+    }
+    double elapsed = now_seconds() - start;
+
+    int count = atomic_load(&sample_count);
+    qsort(samples, count, sizeof(double), compare_double);
+    *p99 = count > 0 ? samples[count * 99 / 100] : 0.0;
+    return order_count / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        order_count = atoi(argv[1]);
+    }
+    if (order_count < 1) {
+        fprintf(stderr, "Usage: %s [orders]\n", argv[0]);
+        return 1;
+    }
+
+    samples = malloc((order_count / SAMPLE_EVERY + 1) * sizeof(double));
+    if (samples == NULL || ring_init(&ring, RING_CAPACITY) < 0) {
+        perror("Failed to allocate");
+        return 1;
+    }
+    legacy.front = legacy.rear = NULL;
+    pthread_mutex_init(&legacy.mutex, NULL);
+    pthread_cond_init(&legacy.cond, NULL);
+
+    printf("%d orders, producers = consumers\n", order_count);
+    printf("%8s %14s %12s %14s %12s %8s\n", "threads", "ring ord/s", "ring p99", "queue ord/s", "queue p99", "speedup");
+    for (thread_count = 1; thread_count <= BENCH_MAX_THREADS; thread_count *= 2) {
+        double ring_p99, legacy_p99;
+        double ring_rate = run(ring_producer, ring_consumer, stop_ring, &ring_p99);
+        double legacy_rate = run(legacy_producer, legacy_consumer, stop_legacy, &legacy_p99);
+        printf("%8d %14.0f %9.1f us %14.0f %9.1f us %7.2fx\n", thread_count, ring_rate, ring_p99 * 1e6, legacy_rate, legacy_p99 * 1e6,
+               ring_rate / legacy_rate);
+    }
+
+    ring_destroy(&ring);
+    pthread_mutex_destroy(&legacy.mutex);
+    pthread_cond_destroy(&legacy.cond);
+    free(samples);
+    return 0;
+}
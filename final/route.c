@@ -0,0 +1,68 @@
+#include <math.h>
+#include "route.h"
+
+double route_distance(RoutePoint a, RoutePoint b) {
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    return sqrt(dx * dx + dy * dy);
+}
+
+// Closed tour: depot, stops in the given order, back to the depot
+double route_length(RoutePoint depot, const RoutePoint* stops, const int* order, int n) {
+    if (n == 0) {
+        return 0.0;
+    }
+    double length = route_distance(depot, stops[order[0]]);
+    for (int i = 1; i < n; ++i) {
+        length += route_distance(stops[order[i - 1]], stops[order[i]]);
+    }
+    return length + route_distance(stops[order[n - 1]], depot);
+}
+
+// Nearest-neighbour tour from the depot, then 2-opt until no reversal
+// shortens it. Writes the visiting order of stops, returns the tour length.
+double route_plan(RoutePoint depot, const RoutePoint* stops, int n, int* order) {
+    int visited[ROUTE_MAX_STOPS] = { 0 };
+    RoutePoint at = depot;
+    for (int i = 0; i < n; ++i) {
+        int best = -1;
+        double best_distance = 0.0;
+        for (int j = 0; j < n; ++j) {
+            if (visited[j]) {
+                continue;
+            }
+            double d = route_distance(at, stops[j]);
+            if (best == -1 || d < best_distance) {
+                best = j;
+                best_distance = d;
+            }
+        }
+        visited[best] = 1;
+        order[i] = best;
+        at = stops[best];
+    }
+
+    // Tour positions 0 and n + 1 are the depot; reversing order[i..j]
+    // replaces edges (i-1, i) and (j, j+1) with (i-1, j) and (i, j+1).
+    int improved = 1;
+    while (improved) {
+        improved = 0;
+        for (int i = 0; i < n - 1; ++i) {
+            for (int j = i + 1; j < n; ++j) {
+                RoutePoint before = i == 0 ? depot : stops[order[i - 1]];
+                RoutePoint after = j == n - 1 ? depot : stops[order[j + 1]];
+                double delta = route_distance(before, stops[order[j]]) + route_distance(stops[order[i]], after) -
+                               route_distance(before, stops[order[i]]) - route_distance(stops[order[j]], after);
+                if (delta < -1e-9) {
+                    for (int a = i, b = j; a < b; ++a, --b) {
+                        int tmp = order[a];
+                        order[a] = order[b];
+                        order[b] = tmp;
+                    }
+                    improved = 1;
+                }
+            }
+        }
+    }
+    return route_length(depot, stops, order, n);
+}
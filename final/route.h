@@ -0,0 +1,15 @@
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#define ROUTE_MAX_STOPS 16
+
+typedef struct {
+    int x;
+    int y;
+} RoutePoint;
+
+double route_distance(RoutePoint a, RoutePoint b);
+double route_length(RoutePoint depot, const RoutePoint* stops, const int* order, int n);
+double route_plan(RoutePoint depot, const RoutePoint* stops, int n, int* order);
+
+#endif
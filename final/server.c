@@ -10,156 +10,124 @@
 #include <complex.h>
 #include <time.h>
 #include <sys/time.h>
-
-#define MAX_COOKS 10
-#define MAX_DELIVERIES 10
-#define MAX_CLIENTS 100
-#define OVEN_CAPACITY 6
-#define APPARATUS 3
-#define BAG_CAPACITY 3
-#define BUFFER_SIZE 1024
-#define ROWS 30
-#define COLS 40
-
-typedef struct {
-    int order_id;
-    int customer_x;
-    int customer_y;
-    int state; // 0: placed, 1: prepared, 2: cooked, 3: delivering, 4: completed, 5: cancelled
-    int cook_id; // Pişiren aşçı kimliği
-    pid_t pid; // Client PID
-} Order;
-
+#include <errno.h>
+#include "pideshop.h"
+#include "reactor.h"
+#include "logger.h"
+#include "matrix.h"
+#include "pinv.h"
+#include "cooktime.h"
+#include "statusbus.h"
+#include "session.h"
+#include "kitchen.h"
+#include "route.h"
+#include "spatial.h"
+#include "sim.h"
+#include "cookpool.h"
+#include "metrics.h"
+#include "orderstore.h"
+#include "topology.h"
+#include "journal.h"
+#include "admission.h"
+#include "deadline.h"
+#include "shop.h"
+
+// Each one sits alone on pages near its thread's CPU, see topology_alloc_local
 typedef struct {
     pthread_t thread_id;
     int id;
+    int cpu; // Pinned CPU, -1 if the scheduler decides
     int work_count; // Aşçının kaç kez çalıştığını izlemek için sayaç
-} Cook;
+    pthread_mutex_t wait_mutex; // Prepare and bake sleeps, woken by a cancel of its order
+    pthread_cond_t wait_cond;
+    ShopCook shop; // Order in hand and its stage
+} __attribute__((aligned(CACHE_LINE))) Cook;
 
 typedef struct {
     pthread_t thread_id;
     int id;
+    int cpu;
     int delivery_count;
-    int current_orders; // Number of current orders the delivery person is carrying
     int work_count; // Teslimatçının kaç kez çalıştığını izlemek için sayaç
-    Order orders[BAG_CAPACITY]; // Array to store the orders
-} DeliveryPerson;
-
-typedef struct QueueNode {
-    Order order;
-    struct QueueNode* next;
-} QueueNode;
+    ShopBag bag; // Slots of the carried orders, freed on delivery, and the tour
+    Order orders[BAG_CAPACITY]; // Copies of the bag's orders
+    double busy_seconds; // On the road, for utilization
+} __attribute__((aligned(CACHE_LINE))) DeliveryPerson;
 
 typedef struct {
-    QueueNode* front;
-    QueueNode* rear;
-    pthread_mutex_t mutex;
-    pthread_cond_t cond;
-    int count; // Queue'daki öğe sayısını izlemek için sayaç
-} Queue;
-
-void init_queue(Queue* q) {
-    q->front = q->rear = NULL;
-    q->count = 0;
-    pthread_mutex_init(&q->mutex, NULL);
-    pthread_cond_init(&q->cond, NULL);
-}
-
-void enqueue(Queue* q, Order order) {
-    QueueNode* temp = (QueueNode*)malloc(sizeof(QueueNode));
-    temp->order = order;
-    temp->next = NULL;
-
-    pthread_mutex_lock(&q->mutex);
-    if (q->rear == NULL) {
-        q->front = q->rear = temp;
-    } else {
-        q->rear->next = temp;
-        q->rear = temp;
-    }
-    q->count++;
-    pthread_cond_signal(&q->cond); // Bekleyen bir thread'i uyandır
-    pthread_mutex_unlock(&q->mutex);
-}
-
-Order dequeue(Queue* q) {
-    pthread_mutex_lock(&q->mutex);
-    while (q->front == NULL) {
-        pthread_cond_wait(&q->cond, &q->mutex);
-    }
-    QueueNode* temp = q->front;
-    Order order = temp->order;
-    q->front = q->front->next;
-    if (q->front == NULL) {
-        q->rear = NULL;
-    }
-    q->count--;
-    pthread_mutex_unlock(&q->mutex);
-    free(temp);
-    return order;
-}
-
-void free_queue(Queue* q) {
-    pthread_mutex_lock(&q->mutex);
-    QueueNode* current = q->front;
-    while (current != NULL) {
-        QueueNode* temp = current;
-        current = current->next;
-        free(temp);
-    }
-    q->front = q->rear = NULL;
-    q->count = 0;
-    pthread_mutex_unlock(&q->mutex);
-}
-
-int get_queue_size(Queue* q) {
-    pthread_mutex_lock(&q->mutex);
-    int size = q->count;
-    pthread_mutex_unlock(&q->mutex);
-    return size;
-}
-
-Order* orders = NULL;
-size_t order_capacity = 0;
-Cook* cooks;
-DeliveryPerson* delivery_personnel;
+    long orders;
+    long tours;
+    double latency_total; // Cooked to delivered, seconds
+    double tour_length_total;
+    double busy_total;    // Courier seconds on the road
+} DeliveryStats;
+
+Order* orders = NULL; // Chunked store, addresses never move
+OrderIndexQueue cooked_orders;  // state 3, popped by couriers under delivery_mutex
+
+Cook** cooks;
+DeliveryPerson** delivery_personnel;
+int cook_count = 0;
+int courier_count = 0;
 pthread_mutex_t order_mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t order_cond = PTHREAD_COND_INITIALIZER;
 pthread_mutex_t delivery_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t delivery_cond = PTHREAD_COND_INITIALIZER;
-pthread_mutex_t completion_mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t completion_cond = PTHREAD_COND_INITIALIZER;
 int active_orders = 0;
 int total_orders = 0;
 int completed_orders = 0;
-int oven_occupancy = 0;
-int apparatus_available = APPARATUS;
 int *delivery_times;
 int delivery_speed;
 int status_socket;
 int completion_socket = -1;
 struct sockaddr_in status_address;
 struct sockaddr_in completion_address;
-int p, q; // Haritanın boyutları
+int metrics_socket = -1;
+struct sockaddr_in metrics_address;
+int matrix_rows = DEFAULT_MATRIX_ROWS; // -r: cook time matrix size
+int matrix_cols = DEFAULT_MATRIX_COLS; // -c
+int pinv_method = PINV_QR;             // -p: ne | qr | svd
+int cooktime_mode = COOKTIME_LIVE;     // -t: live | cached | size | pool
+int compute_pool_size = 1;             // -n: threads for -t pool
+int oven_doors = KITCHEN_ONE_DOOR;     // -o: 1 | 2 oven doors
+int dispatch_mode = DISPATCH_ROUTE;    // -g: greedy | route
+int cook_placement = COOKPOOL_ROUND_ROBIN; // -w: rr | client
+int worker_affinity = AFFINITY_NONE;   // -P: none | compact | scatter
+const char* journal_path = NULL;       // -J: order journal, off without it
+int journal_recover = 0;               // -R: resume the journal's unfinished orders
+AdmissionConfig admission_config = { ADMISSION_OFF, 0, 0, 0.0 }; // -X, -H, -W
+DeadlineConfig deadline_config = { SCHEDULE_FIFO, 0.0, 0.0 }; // -e, -D, -G; 0 = from the measured kitchen time
+DeadlineStats deadline_stats;
+pthread_mutex_t deadline_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+DeliveryStats delivery_stats;
+pthread_mutex_t delivery_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+double server_start;
+CancelStats cancel_stats;
+pthread_mutex_t cancel_mutex = PTHREAD_MUTEX_INITIALIZER; // Also guards cancel_stats
 
 int pending_deliveries = 0; // Aktif teslimat sayısı
 pthread_mutex_t pending_deliveries_mutex = PTHREAD_MUTEX_INITIALIZER; // Mutex for pending deliveries
 
-Queue client_queues[MAX_CLIENTS]; // Maksimum istemci sayısına göre ayarlanabilir
-int client_count = 0;
-
-pthread_mutex_t expand_mutex = PTHREAD_MUTEX_INITIALIZER; // Yeni mutex kilidi
+// Called with order_mutex held. Slots come from the session's arena.
+int alloc_order_slot(Session* session) {
+    return order_arena_alloc(&session->arena);
+}
 
-void expand_order_array() {
-    pthread_mutex_lock(&expand_mutex); // Kilidi al
-    size_t new_capacity = (order_capacity == 0) ? 10 : order_capacity * 2;
-    orders = realloc(orders, new_capacity * sizeof(Order));
-    if (orders == NULL) {
-        perror("Failed to expand order array");
-        exit(EXIT_FAILURE);
+// Called with order_mutex held. A chunk whose orders are all gone goes back
+// to the store; once the session has no live order left, all of them do.
+void free_order_slot(int slot) {
+    Session* session = orders[slot].session;
+    order_arena_free(&session->arena, slot);
+    if (orders[slot].session_prev != -1) {
+        orders[orders[slot].session_prev].session_next = orders[slot].session_next;
+    } else {
+        session->order_head = orders[slot].session_next;
+    }
+    if (orders[slot].session_next != -1) {
+        orders[orders[slot].session_next].session_prev = orders[slot].session_prev;
+    }
+    if (session->order_head == -1) {
+        order_arena_reset(&session->arena);
     }
-    order_capacity = new_capacity;
-    pthread_mutex_unlock(&expand_mutex); // Kilidi bırak
 }
 
 void increment_pending_deliveries() {
@@ -175,234 +143,319 @@ void decrement_pending_deliveries() {
     pthread_mutex_unlock(&pending_deliveries_mutex);
 }
 
-void wait_for_all_deliveries() {
-    pthread_mutex_lock(&pending_deliveries_mutex);
-    while (pending_deliveries > 0 || completed_orders < total_orders) {
-        pthread_cond_wait(&delivery_cond, &pending_deliveries_mutex);
-    }
-    pthread_mutex_unlock(&pending_deliveries_mutex);
+double monotonic_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
 }
 
-void check_and_expand_order_array() {
-    for (int i = 0; i < MAX_CLIENTS; ++i) {
-        int queue_size = get_queue_size(&client_queues[i]);
-        if (queue_size > order_capacity) {
-            expand_order_array(); // Orders dizisini genişletme işlemi
-        }
-    }
+int order_cancelled(int slot) {
+    return atomic_load(&orders[slot].cancelled);
 }
 
-// Rastgele karmaşık sayı matris oluşturma
-void create_matrix(complex double matrix[ROWS][COLS]) {
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            matrix[i][j] = (complex double)rand() / RAND_MAX + (complex double)rand() / RAND_MAX * I;
+// usleep that wakes up early when the order is cancelled, returns the seconds slept.
+// Only the cook's own condition is waited on, so a cancel wakes just its cook.
+double sleep_unless_cancelled(Cook* cook, int slot, double seconds) {
+    double start = monotonic_seconds();
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    long nanos = deadline.tv_nsec + (long)((seconds - (long)seconds) * 1e9);
+    deadline.tv_sec += (time_t)seconds + nanos / 1000000000L;
+    deadline.tv_nsec = nanos % 1000000000L;
+
+    pthread_mutex_lock(&cook->wait_mutex);
+    while (!order_cancelled(slot)) {
+        if (pthread_cond_timedwait(&cook->wait_cond, &cook->wait_mutex, &deadline) == ETIMEDOUT) {
+            break;
         }
     }
+    pthread_mutex_unlock(&cook->wait_mutex);
+    return monotonic_seconds() - start;
 }
 
-// Matris çarpma (C = A * B)
-void matrix_multiply(complex double A[ROWS][COLS], complex double B[COLS][ROWS], complex double C[ROWS][ROWS]) {
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < ROWS; j++) {
-            C[i][j] = 0.0 + 0.0 * I;
-            for (int k = 0; k < COLS; k++) {
-                C[i][j] += A[i][k] * B[k][j];
-            }
-        }
+// Token already set; under order_mutex, so state and cook_id are current.
+// A prepared order's cook may be queued in the kitchen instead of asleep.
+void wake_cook_of(int slot) {
+    if (orders[slot].state == 1 || orders[slot].state == 2) {
+        Cook* cook = cooks[orders[slot].cook_id];
+        pthread_mutex_lock(&cook->wait_mutex);
+        pthread_cond_signal(&cook->wait_cond);
+        pthread_mutex_unlock(&cook->wait_mutex);
     }
-}
-
-void matrix_multiply_alt(complex double A[COLS][ROWS], complex double B[ROWS][COLS], complex double C[COLS][COLS]) {
-    for (int i = 0; i < COLS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            C[i][j] = 0.0 + 0.0 * I;
-            for (int k = 0; k < ROWS; k++) {
-                C[i][j] += A[i][k] * B[k][j];
-            }
-        }
+    if (orders[slot].state == 1) {
+        kitchen_pass_wake(&cooks[orders[slot].cook_id]->shop.pass);
     }
 }
 
-// Matris transpoz (B = A^T)
-void matrix_transpose(complex double A[ROWS][COLS], complex double B[COLS][ROWS]) {
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            B[j][i] = A[i][j];
-        }
-    }
+void record_cancel(int stage, double cook_seconds, double oven_seconds, int bag_slots) {
+    pthread_mutex_lock(&cancel_mutex);
+    cancel_stats.stage[stage]++;
+    cancel_stats.cook_seconds += cook_seconds;
+    cancel_stats.oven_seconds += oven_seconds;
+    cancel_stats.bag_slots += bag_slots;
+    pthread_mutex_unlock(&cancel_mutex);
 }
 
-// Matris tersini hesaplama (gaussian elimination)
-int matrix_inverse(complex double A[COLS][COLS], complex double B[COLS][COLS]) {
-    int i, j, k;
-    complex double ratio;
-    complex double temp;
-    complex double augmented[COLS][2 * COLS];
-
-    // Augmenting Identity Matrix of Order n
-    for (i = 0; i < COLS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            augmented[i][j] = A[i][j];
-            augmented[i][j + COLS] = (i == j) ? 1.0 + 0.0 * I : 0.0 + 0.0 * I;
-        }
-    }
-
-    // Applying Gauss Jordan Elimination
-    for (i = 0; i < COLS; i++) {
-        if (cabs(augmented[i][i]) == 0.0) {
-            printf("Mathematical Error!");
-            return 0;
-        }
-        for (j = 0; j < COLS; j++) {
-            if (i != j) {
-                ratio = augmented[j][i] / augmented[i][i];
-                for (k = 0; k < 2 * COLS; k++) {
-                    augmented[j][k] -= ratio * augmented[i][k];
-                }
-            }
-        }
-    }
-
-    // Row Operation to Make Principal Diagonal to 1
-    for (i = 0; i < COLS; i++) {
-        temp = augmented[i][i];
-        for (int j = 0; j < 2 * COLS; j++) {
-            augmented[i][j] /= temp;
-        }
+// Status subscribers and the journal see every transition after placement
+void publish_state(pid_t pid, int order_id, int state) {
+    status_bus_publish(pid, order_id, state);
+    journal_state(pid, order_id, state);
+    if (state == STATE_COMPLETED) {
+        admission_release(monotonic_seconds());
+    } else if (state == STATE_CANCELLED) {
+        admission_cancel();
     }
+}
 
-    // Extracting inverse matrix
-    for (i = 0; i < COLS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            B[i][j] = augmented[i][j + COLS];
-        }
+// Called with order_mutex and delivery_mutex held by whoever holds the
+// order. in_bag: a courier took it, so it no longer counts as active.
+void drop_cancelled_locked(int slot, int in_bag) {
+    Session* session = orders[slot].session;
+    orders[slot].state = 5;
+    publish_state(orders[slot].pid, orders[slot].order_id, STATE_CANCELLED);
+    metrics_count(METRIC_CANCELLED);
+    if (!in_bag) {
+        active_orders--;
+        pthread_cond_broadcast(&delivery_cond); // Partial bags may leave now
     }
-
-    return 1;
+    free_order_slot(slot);
+    session_order_cancelled(session);
 }
 
-// Pseudo-ters hesaplama (Moore-Penrose yöntemi ile)
-void calculate_pseudo_inverse(complex double matrix[ROWS][COLS], complex double inverse[COLS][ROWS]) {
-    complex double matrix_T[COLS][ROWS];
-    complex double matrix_T_mul_matrix[COLS][COLS];
-    complex double inverse_matrix_T_mul_matrix[COLS][COLS];
-
-    // A^T
-    matrix_transpose(matrix, matrix_T);
-
-    // A^T * A
-    matrix_multiply_alt(matrix_T, matrix, matrix_T_mul_matrix);
-
-    // (A^T * A)^-1
-    if (!matrix_inverse(matrix_T_mul_matrix, inverse_matrix_T_mul_matrix)) {
-        printf("Matrix inversion failed!\n");
-        return;
-    }
+void drop_cancelled(int slot, int in_bag) {
+    pthread_mutex_lock(&order_mutex);
+    pthread_mutex_lock(&delivery_mutex);
+    drop_cancelled_locked(slot, in_bag);
+    pthread_mutex_unlock(&delivery_mutex);
+    pthread_mutex_unlock(&order_mutex);
+}
 
-    // A^+ = (A^T * A)^-1 * A^T
-    for (int i = 0; i < COLS; i++) {
-        for (int j = 0; j < ROWS; j++) {
-            inverse[i][j] = 0.0 + 0.0 * I;
-            for (int k = 0; k < COLS; k++) {
-                inverse[i][j] += inverse_matrix_T_mul_matrix[i][k] * matrix_T[k][j];
-            }
-        }
-    }
+void print_cancel_stats() {
+    pthread_mutex_lock(&cancel_mutex);
+    CancelStats stats = cancel_stats;
+    pthread_mutex_unlock(&cancel_mutex);
+    shop_print_cancel_stats(&stats);
 }
 
-// Aşçı çalışma süresi hesaplama
+// Aşçı çalışma süresi hesaplama, seçilen sağlayıcıdan (-t)
 double calculate_cook_time() {
-    complex double matrix[ROWS][COLS];
-    complex double inverse[COLS][ROWS];
-    create_matrix(matrix);
+    return cooktime_get(matrix_rows, matrix_cols);
+}
 
-    struct timeval start_time, end_time;
-    gettimeofday(&start_time, NULL);
-    
-    // Pseudo-ters hesaplama
-    for (int k = 0; k < 10; k++) {  // Daha uzun süreli bir hesaplama simülasyonu için döngü
-        calculate_pseudo_inverse(matrix, inverse);
+void* cook_function(void* arg);
+void* delivery_function(void* arg);
+void print_delivery_stats(int couriers);
+void print_stage_latency();
+void* handle_signals(void* arg);
+void log_activity(const char* message);
+int place_order(Session* session, int order_id, int customer_x, int customer_y, pid_t client_pid, int promise_ms);
+void restore_orders(const JournalReplay* replay);
+void* handle_metrics_requests(void* arg);
+
+// Seçilen yöntemin doğruluğunu ve hızını açılışta bir kez ölç
+void print_pinv_check() {
+    CMatrix a, inverse;
+    PinvWorkspace ws;
+    if (cmatrix_alloc(&a, matrix_rows, matrix_cols) < 0 || cmatrix_alloc(&inverse, matrix_cols, matrix_rows) < 0 ||
+        pinv_workspace_init(&ws, matrix_rows, matrix_cols, pinv_method) < 0) {
+        exit(EXIT_FAILURE);
     }
+    cmatrix_random(&a);
 
+    struct timeval start_time, end_time;
+    gettimeofday(&start_time, NULL);
+    pinv_compute(&a, &inverse, &ws);
     gettimeofday(&end_time, NULL);
+    double elapsed = (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_usec - start_time.tv_usec) / 1000000.0;
 
-    double cook_time = (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_usec - start_time.tv_usec) / 1000000.0;
-    return cook_time;
-}
+    printf("> Pseudo-inverse: %s, %dx%d, ||A A+ A - A|| / ||A|| = %.2e, %.3f ms\n", pinv_method_name(pinv_method), matrix_rows, matrix_cols, pinv_residual(&a, &inverse), elapsed * 1000.0);
 
-// Pişirme süresi hesaplama
-double calculate_bake_time(double cook_time) {
-    return cook_time / 2; // Pişirme süresi, hazırlık süresinin yarısı
+    cmatrix_free(&a);
+    cmatrix_free(&inverse);
+    pinv_workspace_free(&ws);
 }
 
-void* handle_client(void* arg);
-void* cook_function(void* arg);
-void* delivery_function(void* arg);
-void handle_signal(int signal);
-void log_activity(const char* message, const char* mode);
-void* handle_status_updates(void* arg);
-void* handle_completion_updates(void* arg);
-
-void* handle_client_queue(void* arg) {
-    int client_index = *(int*)arg;
-    Queue* q = &client_queues[client_index];
-    free(arg);
-    char log_msg[256];
-
-    while (1) {
-        Order order = dequeue(q);
-
-        // Siparişi hazırlama ve pişirme
-        double prepare_time = calculate_cook_time();
-        usleep((int)(prepare_time * 1000000));  // microseconds sleep
+int event_loop_count = 1; // -l: number of event loops
+int io_backend = REACTOR_EPOLL; // -u: epoll, or io_uring for sockets and log writes
+LoggerConfig logger_config = { LOG_FLUSH_INTERVAL_MS, LOG_DURABILITY_NONE, LOG_FORMAT_TEXT, 0 };
+int sim_orders = 0; // -s: run a discrete-event simulation of this many orders instead of serving
+double sim_arrival_rate = 0.0; // -a
+int sim_p = SIM_DEFAULT_MAP, sim_q = SIM_DEFAULT_MAP; // -m
+double sim_cancel_share = 0.0; // -C share:ms, orders their client cancels ms after sending
+int sim_cancel_ms = 0;
+
+void print_usage(const char* prog_name) {
+    fprintf(stderr, "Usage: %s [ipaddress] [port] [CookthreadPoolSize] [DeliveryPoolSize] [k] [-l eventLoops] [-u epoll|uring|auto] [-f logFlushMs] [-d logDurability] [-b] [-r rows] [-c cols] [-p ne|qr|svd] [-t live|cached|size|pool] [-n computeThreads] [-o 1|2 ovenDoors] [-g greedy|route] [-w rr|client] [-P none|compact|scatter] [-J journalFile] [-R] [-X off|pause|reject] [-H high[:low]] [-W maxWaitMs] [-e fifo|edf] [-D promiseMs] [-G agingMs] [-s simulatedOrders] [-a arrivalsPerSec] [-m PxQ] [-C cancelShare:afterMs]\n", prog_name);
+}
 
-        pthread_mutex_lock(&order_mutex);
-        while (apparatus_available == 0 || oven_occupancy == OVEN_CAPACITY) {
-            pthread_cond_wait(&order_cond, &order_mutex);
+// Optional flags after the positional arguments
+int parse_options(int argc, char* argv[], int first) {
+    for (int i = first; i < argc; ++i) {
+        if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            event_loop_count = atoi(argv[++i]);
+            if (event_loop_count < 1 || event_loop_count > REACTOR_MAX_LOOPS) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            io_backend = reactor_parse_backend(argv[++i]);
+            if (io_backend < 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            logger_config.flush_interval_ms = atoi(argv[++i]);
+            if (logger_config.flush_interval_ms <= 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            logger_config.durability = atoi(argv[++i]);
+            if (logger_config.durability != LOG_DURABILITY_NONE && logger_config.durability != LOG_DURABILITY_FLUSH) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-b") == 0) {
+            logger_config.format = LOG_FORMAT_BINARY;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            matrix_rows = atoi(argv[++i]);
+            if (matrix_rows <= 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            matrix_cols = atoi(argv[++i]);
+            if (matrix_cols <= 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            pinv_method = pinv_parse_method(argv[++i]);
+            if (pinv_method < 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            cooktime_mode = cooktime_parse_mode(argv[++i]);
+            if (cooktime_mode < 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            compute_pool_size = atoi(argv[++i]);
+            if (compute_pool_size < 1 || compute_pool_size > COOKTIME_MAX_THREADS) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            ++i;
+            if (strcmp(argv[i], "greedy") == 0) {
+                dispatch_mode = DISPATCH_GREEDY;
+            } else if (strcmp(argv[i], "route") == 0) {
+                dispatch_mode = DISPATCH_ROUTE;
+            } else {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            cook_placement = cook_pool_parse_placement(argv[++i]);
+            if (cook_placement < 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            worker_affinity = topology_parse_affinity(argv[++i]);
+            if (worker_affinity < 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-J") == 0 && i + 1 < argc) {
+            journal_path = argv[++i];
+        } else if (strcmp(argv[i], "-R") == 0) {
+            journal_recover = 1;
+        } else if (strcmp(argv[i], "-X") == 0 && i + 1 < argc) {
+            admission_config.mode = admission_parse_mode(argv[++i]);
+            if (admission_config.mode < 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc) {
+            // Low watermark defaults to three quarters of the high one
+            int fields = sscanf(argv[++i], "%d:%d", &admission_config.high_watermark, &admission_config.low_watermark);
+            if (fields < 1 || admission_config.high_watermark < 1) {
+                return -1;
+            }
+            if (fields == 1) {
+                admission_config.low_watermark = admission_config.high_watermark * 3 / 4;
+            }
+            if (admission_config.low_watermark < 0 || admission_config.low_watermark > admission_config.high_watermark) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            deadline_config.mode = deadline_parse_mode(argv[++i]);
+            if (deadline_config.mode < 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-D") == 0 && i + 1 < argc) {
+            deadline_config.kitchen_allowance = atoi(argv[++i]) / 1000.0;
+            if (deadline_config.kitchen_allowance <= 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-G") == 0 && i + 1 < argc) {
+            deadline_config.aging_limit = atoi(argv[++i]) / 1000.0;
+            if (deadline_config.aging_limit <= 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-W") == 0 && i + 1 < argc) {
+            admission_config.max_wait = atoi(argv[++i]) / 1000.0;
+            if (admission_config.max_wait <= 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            sim_orders = atoi(argv[++i]);
+            if (sim_orders < 1) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            sim_arrival_rate = atof(argv[++i]);
+            if (sim_arrival_rate < 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &sim_p, &sim_q) != 2 || sim_p < 1 || sim_q < 1) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%lf:%d", &sim_cancel_share, &sim_cancel_ms) != 2 || sim_cancel_share < 0 || sim_cancel_share > 1 ||
+                sim_cancel_ms < 0) {
+                return -1;
+            }
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            oven_doors = atoi(argv[++i]);
+            if (oven_doors != KITCHEN_ONE_DOOR && oven_doors != KITCHEN_TWO_DOOR) {
+                return -1;
+            }
+        } else {
+            return -1;
         }
-        apparatus_available--;
-        oven_occupancy++;
-        order.state = 2;
-        pthread_mutex_unlock(&order_mutex);
-
-        double bake_time = calculate_bake_time(prepare_time);
-        usleep((int)(bake_time * 1000000));  // microseconds sleep
-
-        pthread_mutex_lock(&order_mutex);
-        oven_occupancy--;
-        apparatus_available++;
-        order.state = 3;
-        pthread_cond_signal(&order_cond);
-        pthread_mutex_unlock(&order_mutex);
-
-        // Pişirme süresini log'a yaz
-        snprintf(log_msg, sizeof(log_msg), "> Cook %d cooked order %d in %.7f seconds", order.cook_id, order.order_id, bake_time);
-        printf("%s\n", log_msg);
-        log_activity(log_msg, "a");
-
-        // Teslimat kuyruğuna ekle
-        pthread_mutex_lock(&delivery_mutex);
-        enqueue(&client_queues[client_index], order);
-        pthread_cond_signal(&delivery_cond);
-        pthread_mutex_unlock(&delivery_mutex);
     }
+    return 0;
+}
 
-    return NULL;
+// Promises left to the kitchen default to a multiple of one prepare and
+// bake, so they scale with the matrix size and the cook time mode
+void init_deadlines() {
+    if (deadline_config.kitchen_allowance == 0) {
+        double cook_time = calculate_cook_time();
+        deadline_config.kitchen_allowance = DEADLINE_KITCHEN_SLACK * (cook_time + shop_bake_time(cook_time));
+    }
+    if (deadline_config.aging_limit == 0) {
+        deadline_config.aging_limit = DEADLINE_AGING_FACTOR * deadline_config.kitchen_allowance;
+    }
+    printf("> Scheduling: %s, kitchen allowance %.3f ms plus %.0fx travel, aging limit %.3f ms\n", deadline_mode_name(deadline_config.mode),
+           deadline_config.kitchen_allowance * 1000.0, DEADLINE_TRAVEL_FACTOR, deadline_config.aging_limit * 1000.0);
 }
 
 void cleanup() {
     // Free allocated memory for orders, cooks, delivery personnel, and delivery times
-    free(orders);
+    order_store_destroy();
+    for (int i = 0; cooks != NULL && i < cook_count; ++i) {
+        topology_free_local(cooks[i], sizeof(Cook));
+    }
+    for (int i = 0; delivery_personnel != NULL && i < courier_count; ++i) {
+        topology_free_local(delivery_personnel[i], sizeof(DeliveryPerson));
+    }
     free(cooks);
     free(delivery_personnel);
     free(delivery_times);
 
-    // Free all client queues
-    for (int i = 0; i < MAX_CLIENTS; ++i) {
-        free_queue(&client_queues[i]);
-    }
-
     // Close sockets
     if (status_socket != -1) {
         close(status_socket);
@@ -410,11 +463,14 @@ void cleanup() {
     if (completion_socket != -1) {
         close(completion_socket);
     }
+    if (metrics_socket != -1) {
+        close(metrics_socket);
+    }
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 6) {
-        fprintf(stderr, "Usage: %s [ipaddress] [port] [CookthreadPoolSize] [DeliveryPoolSize] [k]\n", argv[0]);
+    if (argc < 6 || parse_options(argc, argv, 6) < 0) {
+        print_usage(argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -424,33 +480,123 @@ int main(int argc, char* argv[]) {
     int delivery_pool_size = atoi(argv[4]);
     delivery_speed = atoi(argv[5]);
 
-    orders = NULL;
-    order_capacity = 0;
-    cooks = (Cook*) malloc(cook_pool_size * sizeof(Cook));
-    delivery_personnel = (DeliveryPerson*) malloc(delivery_pool_size * sizeof(DeliveryPerson));
+    // io_uring yalnızca çekirdek destekliyorsa, yoksa epoll
+    io_backend = reactor_pick_backend(io_backend);
+    logger_config.use_uring = io_backend == REACTOR_URING;
+
+    // Simülasyon modu: soket yok, sanal saatle aynı mutfak ve kurye adımları
+    if (sim_orders > 0) {
+        if (cooktime_init(cooktime_mode, matrix_rows, matrix_cols, pinv_method, compute_pool_size) < 0 ||
+            logger_init(LOG_FILE_NAME, &logger_config) < 0) {
+            exit(EXIT_FAILURE);
+        }
+        init_deadlines();
+        SimConfig sim_config = { cook_pool_size, delivery_pool_size, delivery_speed, sim_orders, sim_arrival_rate,
+                                 sim_p, sim_q, OVEN_CAPACITY, APPARATUS, oven_doors, dispatch_mode, cook_placement,
+                                 matrix_rows, matrix_cols, cooktime_mode, (unsigned int)time(NULL), deadline_config, 0.0, 0.0,
+                                 sim_cancel_share, sim_cancel_ms / 1000.0, 0 };
+        int rc = sim_run(&sim_config, NULL);
+        logger_shutdown();
+        cooktime_shutdown();
+        exit(rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
+    // SIGINT/SIGTERM yalnızca kapanış thread'ine gelir: her thread bu maskeyi
+    // miras alsın diye hiçbir thread başlamadan önce engellenir
+    sigset_t shutdown_signals;
+    sigemptyset(&shutdown_signals);
+    sigaddset(&shutdown_signals, SIGINT);
+    sigaddset(&shutdown_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &shutdown_signals, NULL);
+
+    orders = order_store_init();
+    if (orders == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    // Aşçılar ve kuryeler sırayla CPU alır: önce aşçılar, sonra kuryeler
+    if (topology_init() < 0) {
+        worker_affinity = AFFINITY_NONE;
+    }
+    cooks = (Cook**) calloc(cook_pool_size, sizeof(Cook*));
+    delivery_personnel = (DeliveryPerson**) calloc(delivery_pool_size, sizeof(DeliveryPerson*));
     delivery_times = (int*) malloc(delivery_pool_size * sizeof(int));
+    if (cooks == NULL || delivery_personnel == NULL || delivery_times == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
 
     for (int i = 0; i < cook_pool_size; ++i) {
-        cooks[i].id = i;
-        cooks[i].work_count = 0; // Aşçı iş sayacını başlat
+        int cpu = topology_cpu_for(worker_affinity, i);
+        cooks[i] = topology_alloc_local(sizeof(Cook), topology_node_of(cpu));
+        if (cooks[i] == NULL) {
+            exit(EXIT_FAILURE);
+        }
+        cook_count++;
+        cooks[i]->id = i;
+        cooks[i]->cpu = cpu;
+        cooks[i]->work_count = 0; // Aşçı iş sayacını başlat
+        pthread_mutex_init(&cooks[i]->wait_mutex, NULL);
+        pthread_cond_init(&cooks[i]->wait_cond, NULL);
+        shop_cook_init(&cooks[i]->shop, i, NULL);
     }
 
     for (int i = 0; i < delivery_pool_size; ++i) {
-        delivery_personnel[i].id = i;
-        delivery_personnel[i].delivery_count = 0;
-        delivery_personnel[i].current_orders = 0;
-        delivery_personnel[i].work_count = 0; // Teslimatçı iş sayacını başlat
+        int cpu = topology_cpu_for(worker_affinity, cook_pool_size + i);
+        delivery_personnel[i] = topology_alloc_local(sizeof(DeliveryPerson), topology_node_of(cpu));
+        if (delivery_personnel[i] == NULL) {
+            exit(EXIT_FAILURE);
+        }
+        courier_count++;
+        delivery_personnel[i]->id = i;
+        delivery_personnel[i]->cpu = cpu;
+        delivery_personnel[i]->delivery_count = 0;
+        delivery_personnel[i]->busy_seconds = 0.0;
+        delivery_personnel[i]->bag.count = 0;
+        delivery_personnel[i]->work_count = 0; // Teslimatçı iş sayacını başlat
     }
 
-    for (int i = 0; i < MAX_CLIENTS; ++i) {
-        init_queue(&client_queues[i]);
+    // Her aşçının kendi kuyruğu var, boşta kalan diğerlerinden çalar
+    if (cook_pool_init(cook_pool_size, cook_placement, deadline_config.mode) < 0) {
+        exit(EXIT_FAILURE);
+    }
+    init_index_queue(&cooked_orders);
+    ShopConfig shop_config = { matrix_rows, matrix_cols, deadline_config.mode, dispatch_mode, delivery_speed };
+    shop_init(&shop_config);
+
+    // En geniş SIMD çekirdeğini seç ve skaler yolla karşılaştır
+    matrix_select_kernel();
+    printf("> Matrix kernel: %s (relative error vs scalar %.2e)\n", matrix_kernel_name(), matrix_self_check(matrix_rows, matrix_cols));
+    topology_print();
+    printf("> Worker affinity: %s\n", topology_affinity_name(worker_affinity));
+    print_pinv_check();
+
+    if (cooktime_init(cooktime_mode, matrix_rows, matrix_cols, pinv_method, compute_pool_size) < 0) {
+        exit(EXIT_FAILURE);
+    }
+    // Geri yüklenen siparişlerin de söz ve öncelikleri bu ayarlarla hesaplanır
+    init_deadlines();
+
+    // Günlükten yarım kalan siparişleri geri yükle, sonra yeni günlüğe başla
+    if (journal_path != NULL) {
+        JournalReplay replay = { 0 };
+        if (journal_recover) {
+            if (journal_replay(journal_path, &replay) < 0) {
+                exit(EXIT_FAILURE);
+            }
+            restore_orders(&replay);
+            printf("> Journal replay: %ld records in %.3f s, %d orders of %d sessions resumed, %ld torn bytes dropped\n",
+                   replay.records, replay.seconds, replay.order_count, replay.session_count, replay.torn_bytes);
+        }
+        if (journal_start(journal_path, journal_recover ? &replay : NULL) < 0) {
+            exit(EXIT_FAILURE);
+        }
+        journal_replay_free(&replay);
     }
 
     // Initialize server socket
-    int server_fd, new_socket;
+    int server_fd;
     struct sockaddr_in address;
     int opt = 1;
-    int addrlen = sizeof(address);
 
     if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
         perror("socket failed");
@@ -469,7 +615,7 @@ int main(int argc, char* argv[]) {
         perror("bind failed");
         exit(EXIT_FAILURE);
     }
-    if (listen(server_fd, 3) < 0) {
+    if (listen(server_fd, SOMAXCONN) < 0) {
         perror("listen");
         exit(EXIT_FAILURE);
     }
@@ -488,7 +634,7 @@ int main(int argc, char* argv[]) {
         perror("bind failed for status socket");
         exit(EXIT_FAILURE);
     }
-    if (listen(status_socket, 3) < 0) {
+    if (listen(status_socket, SOMAXCONN) < 0) {
         perror("listen failed for status socket");
         exit(EXIT_FAILURE);
     }
@@ -507,122 +653,97 @@ int main(int argc, char* argv[]) {
         perror("bind failed for completion socket");
         exit(EXIT_FAILURE);
     }
-    if (listen(completion_socket, 3) < 0) {
+    if (listen(completion_socket, SOMAXCONN) < 0) {
         perror("listen failed for completion socket");
         exit(EXIT_FAILURE);
     }
 
-    signal(SIGINT, handle_signal);
-    signal(SIGTERM, handle_signal);
+    // Initialize metrics socket, Prometheus text on every connection
+    if ((metrics_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        perror("metrics socket failed");
+        exit(EXIT_FAILURE);
+    }
+    setsockopt(metrics_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
 
-    pthread_t* cook_threads = malloc(cook_pool_size * sizeof(pthread_t));
-    pthread_t* delivery_threads = malloc(delivery_pool_size * sizeof(pthread_t));
+    metrics_address.sin_family = AF_INET;
+    metrics_address.sin_addr.s_addr = inet_addr(ipaddress);
+    metrics_address.sin_port = htons(port + 3); // Metrik portu için üç sonraki port
 
-    for (int i = 0; i < cook_pool_size; ++i) {
-        pthread_create(&cook_threads[i], NULL, cook_function, (void*)&cooks[i]);
+    if (bind(metrics_socket, (struct sockaddr *)&metrics_address, sizeof(metrics_address)) < 0) {
+        perror("bind failed for metrics socket");
+        exit(EXIT_FAILURE);
     }
-
-    for (int i = 0; i < delivery_pool_size; ++i) {
-        pthread_create(&delivery_threads[i], NULL, delivery_function, (void*)&delivery_personnel[i]);
+    if (listen(metrics_socket, SOMAXCONN) < 0) {
+        perror("listen failed for metrics socket");
+        exit(EXIT_FAILURE);
     }
 
-    pthread_t status_thread, completion_thread;
-    pthread_create(&status_thread, NULL, handle_status_updates, NULL);
-    pthread_create(&completion_thread, NULL, handle_completion_updates, NULL);
-
-    printf("> PideShop active waiting for connection ...\n");
+    if (kitchen_init(APPARATUS, OVEN_CAPACITY, oven_doors) < 0) {
+        exit(EXIT_FAILURE);
+    }
 
-    // Log dosyasını başlangıçta temizle
-    log_activity("", "w");
+    // Log dosyasını başlangıçta temizle, arka plandaki flusher thread'i başlat
+    if (logger_init(LOG_FILE_NAME, &logger_config) < 0) {
+        exit(EXIT_FAILURE);
+    }
 
-    while (1) {
-        check_and_expand_order_array(); // Orders dizisini kontrol et ve gerekirse genişlet
+    // Sipariş durumlarını abonelere toplu halde yayınla
+    if (status_bus_start() < 0) {
+        exit(EXIT_FAILURE);
+    }
 
-        int customer_count = 0;
-        int *client_sockets = NULL;
-        pid_t *client_pids = NULL; // Store PIDs of clients
-        pid_t last_client_pid; // Store the PID of the last client
+    server_start = monotonic_seconds();
+    pthread_t signal_thread;
+    pthread_create(&signal_thread, NULL, handle_signals, &shutdown_signals);
 
-        // Accept an initial connection to get the number of clients
-        if ((new_socket = accept(server_fd, (struct sockaddr *)&address, (socklen_t*)&addrlen)) < 0) {
-            perror("accept");
-            exit(EXIT_FAILURE);
-        }
+    pthread_t* cook_threads = malloc(cook_pool_size * sizeof(pthread_t));
+    pthread_t* delivery_threads = malloc(delivery_pool_size * sizeof(pthread_t));
 
-        // Read the number of clients
-        int number_of_clients;
-        read(new_socket, &number_of_clients, sizeof(int));
-        // Read p and q values
-        read(new_socket, &p, sizeof(int));
-        read(new_socket, &q, sizeof(int));
-        close(new_socket);
+    for (int i = 0; i < cook_pool_size; ++i) {
+        topology_create_thread(&cook_threads[i], cooks[i]->cpu, cook_function, (void*)cooks[i]);
+    }
 
-        // Allocate memory for client sockets and PIDs based on the number of clients
-        client_sockets = (int *)malloc(number_of_clients * sizeof(int));
-        client_pids = (pid_t *)malloc(number_of_clients * sizeof(pid_t));
+    for (int i = 0; i < delivery_pool_size; ++i) {
+        topology_create_thread(&delivery_threads[i], delivery_personnel[i]->cpu, delivery_function, (void*)delivery_personnel[i]);
+    }
 
-        for (int i = 0; i < number_of_clients; ++i) {
-            if ((new_socket = accept(server_fd, (struct sockaddr *)&address, (socklen_t*)&addrlen)) < 0) {
-                perror("accept");
-                exit(EXIT_FAILURE);
-            }
+    // Doygunlukta sipariş alımını durdur, kuyruk boşalınca tekrar aç
+    admission_init(&admission_config, reactor_resume);
 
-            client_sockets[i] = new_socket;
-            read(new_socket, &client_pids[i], sizeof(pid_t)); // Read client PID from socket
-            last_client_pid = client_pids[i]; // Update the last client PID
-            customer_count++;
-        }
+    pthread_t metrics_thread;
+    pthread_create(&metrics_thread, NULL, handle_metrics_requests, NULL);
 
-        char log_msg[256];
-        snprintf(log_msg, sizeof(log_msg), "\n------ Client PID: %d connected. ------", client_pids[0]);
-        printf("%s\n", log_msg);
-        log_activity(log_msg, "a");
-
-        char customer_log[256];
-        snprintf(customer_log, sizeof(customer_log), "> %d new customers.. Serving", customer_count);
-        printf("%s\n", customer_log);
-        log_activity(customer_log, "a");
-
-        int* client_index = malloc(sizeof(int));
-        *client_index = client_count++;
-        for (int i = 0; i < number_of_clients; ++i) {
-            int* client_socket = malloc(sizeof(int));
-            *client_socket = client_sockets[i];
-            pthread_t client_thread;
-            pthread_create(&client_thread, NULL, handle_client, client_socket);
-            pthread_detach(client_thread);
-        }
+    printf("> PideShop active waiting for connection ...\n");
 
-        pthread_t client_queue_thread;
-        pthread_create(&client_queue_thread, NULL, handle_client_queue, client_index);
-        pthread_detach(client_queue_thread);
 
-        // Wait until all orders are completed
-        pthread_mutex_lock(&completion_mutex);
-        while (completed_orders < total_orders) {
-            pthread_cond_wait(&completion_cond, &completion_mutex);
-        }
-        pthread_mutex_unlock(&completion_mutex);
+    // Siparişleri ve abonelikleri event loop'lar kabul eder ve ayrıştırır
+    printf("> I/O backend: %s, %d event loop(s)\n", reactor_backend_name(io_backend), event_loop_count);
+    int listen_fds[REACTOR_PORTS] = { server_fd, status_socket, completion_socket };
+    if (reactor_start(listen_fds, event_loop_count, io_backend) < 0) {
+        exit(EXIT_FAILURE);
+    }
 
-        // Wait for all deliveries to be completed
-        wait_for_all_deliveries();
+    while (1) {
+        // Her müşteri kendi siparişleri bitince raporlanır, diğerlerini beklemeden
+        SessionReport report;
+        session_wait_finished(&report);
 
         // En fazla çalışan cook ve delivery person'u bul
         int max_cook_work = 0;
         int max_cook_id = -1;
         for (int i = 0; i < cook_pool_size; ++i) {
-            if (cooks[i].work_count > max_cook_work) {
-                max_cook_work = cooks[i].work_count;
-                max_cook_id = cooks[i].id;
+            if (cooks[i]->work_count > max_cook_work) {
+                max_cook_work = cooks[i]->work_count;
+                max_cook_id = cooks[i]->id;
             }
         }
 
         int max_delivery_work = 0;
         int max_delivery_id = -1;
         for (int i = 0; i < delivery_pool_size; ++i) {
-            if (delivery_personnel[i].delivery_count > max_delivery_work) {
-                max_delivery_work = delivery_personnel[i].work_count;
-                max_delivery_id = delivery_personnel[i].id;
+            if (delivery_personnel[i]->delivery_count > max_delivery_work) {
+                max_delivery_work = delivery_personnel[i]->work_count;
+                max_delivery_id = delivery_personnel[i]->id;
             }
         }
 
@@ -630,20 +751,51 @@ int main(int argc, char* argv[]) {
         printf("> Most hardworking cook: Cook %d with %d orders prepared and cooked\n", max_cook_id, max_cook_work);
         printf("> Most hardworking delivery person: Delivery Person %d with %d deliveries\n", max_delivery_id, max_delivery_work);
 
-        printf("> done serving client @ XXX PID %d\n", last_client_pid);
-        printf("> active waiting for connections\n");
-
+        printf("> Served %d orders in %.3f seconds (%.2f orders/sec)\n", report.orders, report.seconds, report.seconds > 0 ? report.orders / report.seconds : 0.0);
+        if (report.cancelled > 0) {
+            printf("> %d orders of PID %d were cancelled\n", report.cancelled, report.pid);
+        }
 
-        // Reset counters for next batch of customers
-        total_orders = 0;
-        completed_orders = 0;
-        active_orders = 0;
+        CookTimeStats cook_stats;
+        cooktime_get_stats(&cook_stats);
+        printf("> Cook time provider %s: %ld lookups, %ld computations, %.3f seconds computing\n", cooktime_mode_name(cooktime_mode), cook_stats.lookups, cook_stats.computations, cook_stats.compute_total);
 
-        // Free allocated memory for client sockets and PIDs
-        free(client_sockets);
-        free(client_pids);
+        cook_pool_print_stats();
+        print_stage_latency();
+        OrderStoreStats store_stats;
+        pthread_mutex_lock(&order_mutex);
+        order_store_get_stats(&store_stats);
+        pthread_mutex_unlock(&order_mutex);
+        printf("> Order store: %ld chunks of %d committed, %ld free, %ld refills, %ld session resets, %ld chunks reclaimed early\n",
+               store_stats.chunks_committed, ORDER_CHUNK_SIZE, store_stats.chunks_free, store_stats.chunk_takes, store_stats.arena_resets,
+               store_stats.chunks_reclaimed);
+        if (journal_path != NULL) {
+            JournalStats journal_stats;
+            journal_get_stats(&journal_stats);
+            printf("> Journal: %ld records in %ld commits (largest %ld), %ld appends waited for the disk\n", journal_stats.records,
+                   journal_stats.commits, journal_stats.largest_commit, journal_stats.full_waits);
+        }
+        if (admission_config.mode != ADMISSION_OFF) {
+            AdmissionStats admission_stats;
+            admission_get_stats(&admission_stats);
+            printf("> Admission (%s): %ld admitted, %ld turned away, intake closed %ld times, peak %d live, %d live now (predicted wait %.3f s)\n",
+                   admission_config.mode == ADMISSION_PAUSE ? "pause" : "reject", admission_stats.admitted, admission_stats.rejected,
+                   admission_stats.pauses, admission_stats.max_live, admission_stats.live, admission_stats.predicted_wait);
+        }
+        pthread_mutex_lock(&deadline_stats_mutex);
+        DeadlineStats deadlines = deadline_stats;
+        pthread_mutex_unlock(&deadline_stats_mutex);
+        deadline_print(&deadline_config, &deadlines);
+        kitchen_print_stats();
+        print_cancel_stats();
+        print_delivery_stats(delivery_pool_size);
+
+        printf("> done serving client @ XXX PID %d\n", report.pid);
+        printf("> active waiting for connections\n");
     }
 
+    reactor_stop();
+
     // Cleanup threads
     for (int i = 0; i < cook_pool_size; ++i) {
         pthread_join(cook_threads[i], NULL);
@@ -653,8 +805,7 @@ int main(int argc, char* argv[]) {
         pthread_join(delivery_threads[i], NULL);
     }
 
-    pthread_join(status_thread, NULL);
-    pthread_join(completion_thread, NULL);
+    pthread_join(metrics_thread, NULL);
 
     // Cleanup
     cleanup();
@@ -662,110 +813,340 @@ int main(int argc, char* argv[]) {
     return 0;
 }
 
-void* handle_client(void* arg) {
-    int client_socket = *(int*)arg;
-    free(arg);
+void reactor_on_init(int number_of_clients, int p, int q, pid_t pid, int promise_ms) {
+    Session* session = session_open(pid, number_of_clients, p, q);
+    if (session == NULL) {
+        fprintf(stderr, "> Too many waiting clients, PID %d ignored\n", pid);
+        return;
+    }
+    session->promise_ms = promise_ms > 0 ? promise_ms : 0;
+    journal_session(pid, number_of_clients, p, q);
+
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "\n------ Client PID: %d connected. ------", pid);
+    printf("%s\n", log_msg);
+    log_activity(log_msg);
 
-    char buffer[BUFFER_SIZE] = {0};
-    int valread = read(client_socket, buffer, BUFFER_SIZE);
-    if (valread < 0) {
-        perror("read");
-        close(client_socket);
-        return NULL;
+    snprintf(log_msg, sizeof(log_msg), "> %d new customers.. Serving (%d active sessions)", number_of_clients, session_active_count());
+    printf("%s\n", log_msg);
+    log_activity(log_msg);
+}
+
+// Pause mode leaves order frames unread while intake is closed
+int reactor_can_admit(void) {
+    return admission_config.mode != ADMISSION_PAUSE || admission_accepting();
+}
+
+int reactor_on_order(int order_id, int customer_x, int customer_y, pid_t client_pid, int promise_ms) {
+    int retry_ms = admission_try();
+    if (retry_ms > 0) {
+        return retry_ms;
+    }
+    Session* session = session_accept_order(client_pid);
+    if (session == NULL) {
+        fprintf(stderr, "> Order %d from PID %d was not announced, dropped\n", order_id, client_pid);
+        admission_add(-1);
+        return 0;
     }
 
-    // Process client request and manage orders
-    int order_id, customer_x, customer_y;
-    pid_t client_pid;
-    sscanf(buffer, "%d %d %d %d", &order_id, &customer_x, &customer_y, &client_pid);
+    int slot = place_order(session, order_id, customer_x, customer_y, client_pid, promise_ms);
+    if (slot < 0) {
+        fprintf(stderr, "> Order store is full, order %d from PID %d dropped\n", order_id, client_pid);
+        admission_add(-1);
+        journal_unsent(client_pid, 1);
+        session_order_cancelled(session);
+        return 0;
+    }
+    // Journaled before any cook can move it on
+    journal_placed(client_pid, order_id, customer_x, customer_y);
+    cook_pool_submit(slot, (unsigned int)client_pid, orders[slot].priority);
+
+    status_bus_publish(client_pid, order_id, STATE_PLACED);
+    metrics_count(METRIC_PLACED);
+    return 0;
+}
+
+// Takes a slot in the session's arena and links the order into the
+// session's list. Returns the slot, -1 when the store is full. The promise
+// is the order's own, else its session's, else computed from the distance.
+int place_order(Session* session, int order_id, int customer_x, int customer_y, pid_t client_pid, int promise_ms) {
+    double travel = deadline_travel(customer_x, customer_y, session->p, session->q, delivery_speed);
+    if (promise_ms <= 0) {
+        promise_ms = session->promise_ms;
+    }
+    double promise = promise_ms > 0 ? promise_ms / 1000.0 : deadline_promise(&deadline_config, travel);
 
     pthread_mutex_lock(&order_mutex);
-    if (total_orders >= order_capacity) {
-        expand_order_array(); // Orders dizisini genişletme işlemi
-    }
-    orders[total_orders].order_id = order_id;
-    orders[total_orders].customer_x = customer_x;
-    orders[total_orders].customer_y = customer_y;
-    orders[total_orders].state = 0;
-    orders[total_orders].pid = client_pid;
+    int slot = alloc_order_slot(session);
+    if (slot < 0) {
+        pthread_mutex_unlock(&order_mutex);
+        return -1;
+    }
+    orders[slot].order_id = order_id;
+    orders[slot].customer_x = customer_x;
+    orders[slot].customer_y = customer_y;
+    orders[slot].state = 0;
+    orders[slot].pid = client_pid;
+    orders[slot].session = session;
+    atomic_store(&orders[slot].cancelled, 0);
+    orders[slot].placed_at = monotonic_seconds();
+    orders[slot].deadline = orders[slot].placed_at + promise;
+    orders[slot].priority = deadline_key(&deadline_config, orders[slot].placed_at, orders[slot].deadline, travel);
+    orders[slot].session_prev = -1;
+    orders[slot].session_next = session->order_head;
+    if (session->order_head != -1) {
+        orders[session->order_head].session_prev = slot;
+    }
+    session->order_head = slot;
     total_orders++;
     active_orders++;
-    pthread_cond_signal(&order_cond);
     pthread_mutex_unlock(&order_mutex);
+    return slot;
+}
 
-    close(client_socket);
-    return NULL;
+// Orders the journal left unfinished. Those that had not come out of the
+// oven start over at a cook; cooked ones, even if a courier had them on
+// the road, wait for a courier again.
+void restore_orders(const JournalReplay* replay) {
+    for (int i = 0; i < replay->session_count; ++i) {
+        const JournalSession* restored = &replay->sessions[i];
+        if (session_restore(restored->pid, restored->received, restored->completed, restored->cancelled, restored->p, restored->q) == NULL) {
+            fprintf(stderr, "> Session of PID %d could not be restored\n", restored->pid);
+        }
+    }
+    for (int i = 0; i < replay->order_count; ++i) {
+        const JournalOrder* restored = &replay->orders[i];
+        Session* session = session_accept_order(restored->pid);
+        if (session == NULL) {
+            continue;
+        }
+        int slot = place_order(session, restored->order_id, restored->customer_x, restored->customer_y, restored->pid, 0);
+        if (slot < 0) {
+            fprintf(stderr, "> Order store is full, order %d from PID %d dropped\n", restored->order_id, restored->pid);
+            session_order_cancelled(session);
+            continue;
+        }
+        admission_add(1);
+        if (restored->state < STATE_COOKED) {
+            cook_pool_submit(slot, (unsigned int)restored->pid, orders[slot].priority);
+            continue;
+        }
+        pthread_mutex_lock(&order_mutex);
+        pthread_mutex_lock(&delivery_mutex);
+        orders[slot].state = 3;
+        orders[slot].cooked_at = monotonic_seconds();
+        push_order_index(&cooked_orders, orders, slot);
+        spatial_insert(&session->cooked, orders, slot);
+        pthread_mutex_unlock(&delivery_mutex);
+        pthread_mutex_unlock(&order_mutex);
+    }
+}
+
+// FRAME_CANCEL or a dropped connection. Sets the token of every matching
+// live order of pid, walking only that session's order list. Orders
+// waiting for a courier are dropped here; the rest are dropped by the cook
+// or courier holding them at its next stage boundary.
+void reactor_on_cancel(pid_t pid, int order_id) {
+    Session* session = session_lookup(pid);
+    if (session == NULL) {
+        if (order_id != 0) {
+            pthread_mutex_lock(&cancel_mutex);
+            cancel_stats.too_late++;
+            pthread_mutex_unlock(&cancel_mutex);
+        }
+        return;
+    }
+
+    int requested = 0;
+    int ready = 0;
+    pthread_mutex_lock(&order_mutex);
+    pthread_mutex_lock(&delivery_mutex);
+    int slot = session->order_head;
+    while (slot != -1) {
+        int next = orders[slot].session_next;
+        if ((order_id == 0 || orders[slot].order_id == order_id) && orders[slot].state != 5 &&
+            !atomic_exchange(&orders[slot].cancelled, 1)) {
+            requested++;
+            if (orders[slot].state == 3) {
+                remove_order_index(&cooked_orders, orders, slot);
+                spatial_remove(&session->cooked, orders, slot);
+                drop_cancelled_locked(slot, 0);
+                ready++;
+            } else {
+                wake_cook_of(slot);
+            }
+        }
+        slot = next;
+    }
+    pthread_mutex_unlock(&delivery_mutex);
+    pthread_mutex_unlock(&order_mutex);
+
+    // Pipelined orders still on their way in will not come
+    int unsent = order_id == 0 ? session_cancel_unsent(pid) : 0;
+    if (unsent > 0) {
+        journal_unsent(pid, unsent);
+    }
+
+    pthread_mutex_lock(&cancel_mutex);
+    cancel_stats.requested += requested;
+    cancel_stats.unsent += unsent;
+    cancel_stats.too_late += order_id != 0 && requested == 0;
+    cancel_stats.stage[CANCEL_READY] += ready;
+    cancel_stats.bag_slots += ready;
+    pthread_mutex_unlock(&cancel_mutex);
+
+    if (requested > 0 || unsent > 0) {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "> PID %d cancelled %d orders (%d not sent yet)", pid, requested + unsent, unsent);
+        printf("%s\n", log_msg);
+        log_activity(log_msg);
+    }
+}
+
+// FRAME_SUBSCRIBE on port+1 or port+2, read by the event loops. Status
+// subscribers get FRAME_STATUS_BATCH frames from the status bus; a client
+// gets FRAME_COMPLETE as soon as its own orders are delivered.
+void reactor_on_subscribe(int port, int fd, pid_t pid) {
+    if (port == REACTOR_STATUS) {
+        if (status_bus_subscribe(fd, pid) < 0) {
+            fprintf(stderr, "> Too many status subscribers\n");
+        }
+    } else if (pid == 0) {
+        close(fd);
+    } else {
+        session_subscribe(fd, pid);
+    }
 }
 
 void* cook_function(void* arg) {
     Cook* cook = (Cook*)arg;
+    ShopCook* shop = &cook->shop;
     char log_msg[256];
 
     while (1) {
-        pthread_mutex_lock(&order_mutex);
-        while (active_orders == 0) {
-            pthread_cond_wait(&order_cond, &order_mutex);
+        int order_index = cook_pool_take(cook->id);
+        double queued = monotonic_seconds() - orders[order_index].placed_at;
+        metrics_record(METRIC_QUEUE_WAIT, queued);
+        if (queued > deadline_config.aging_limit) {
+            pthread_mutex_lock(&deadline_stats_mutex);
+            deadline_stats.aged++;
+            pthread_mutex_unlock(&deadline_stats_mutex);
         }
 
-        int order_index = -1;
-        for (int i = 0; i < total_orders; ++i) {
-            if (orders[i].state == 0) {
-                order_index = i;
-                break;
-            }
-        }
+        // Aşamalar ve iptal kontrolleri shop.c'de, burada yalnızca beklenir
+        shop_cook_begin(shop, orders, order_index);
+        int step;
+        while ((step = shop_cook_step(shop, orders, monotonic_seconds())) != SHOP_COOKED && step != SHOP_DROPPED) {
+            switch (step) {
+                case SHOP_STARTED:
+                    pthread_mutex_lock(&order_mutex);
+                    orders[order_index].state = 1;
+                    orders[order_index].cook_id = cook->id; // Aşçının kimliğini sakla
+                    cook->work_count++; // Aşçı iş sayacını artır
+                    pthread_mutex_unlock(&order_mutex);
+                    break;
 
-        if (order_index != -1) {
-            orders[order_index].state = 1;
-            orders[order_index].cook_id = cook->id; // Aşçının kimliğini sakla
-            cook->work_count++; // Aşçı iş sayacını artır
-            pthread_mutex_unlock(&order_mutex);
+                case SHOP_SLEEP:
+                    shop->slept = sleep_unless_cancelled(cook, order_index, shop->sleep);
+                    break;
 
-            // Hazırlama süresi hesaplama ve simülasyon
-            double prepare_time = calculate_cook_time();
-            usleep((int)(prepare_time * 1000000));  // microseconds sleep
+                case SHOP_PREPARED:
+                    // Hazırlama süresini log'a yaz
+                    snprintf(log_msg, sizeof(log_msg), "> Cook %d prepared order %d in %.7f seconds", cook->id, orders[order_index].order_id, shop->prepare_time);
+                    printf("%s\n", log_msg);
+                    log_activity(log_msg);
+                    publish_state(orders[order_index].pid, orders[order_index].order_id, STATE_PREPARED);
+                    metrics_record(METRIC_PREPARE, shop->slept);
+                    metrics_count(METRIC_PREPARED);
+                    break;
 
-            // Hazırlama süresini log'a yaz
-            snprintf(log_msg, sizeof(log_msg), "> Cook %d prepared order %d in %.7f seconds", cook->id, orders[order_index].order_id, prepare_time);
-            printf("%s\n", log_msg);
-            log_activity(log_msg, "a");
+                case SHOP_BLOCKED:
+                    // Fırın, kürek ya da kapak sırası
+                    kitchen_pass_wait(&shop->pass);
+                    break;
 
-            pthread_mutex_lock(&order_mutex);
-            while (apparatus_available == 0 || oven_occupancy == OVEN_CAPACITY) {
-                pthread_cond_wait(&order_cond, &order_mutex);
+                case SHOP_IN_OVEN:
+                    metrics_record(METRIC_OVEN_WAIT, monotonic_seconds() - shop->queued_at);
+                    pthread_mutex_lock(&order_mutex);
+                    orders[order_index].state = 2;
+                    pthread_mutex_unlock(&order_mutex);
+                    break;
             }
-            apparatus_available--;
-            oven_occupancy++;
-            orders[order_index].state = 2;
-            pthread_mutex_unlock(&order_mutex);
+        }
+        if (step == SHOP_DROPPED) {
+            record_cancel(shop->drop_stage, shop->saved_cook, shop->saved_oven, 1);
+            drop_cancelled(order_index, 0);
+            continue;
+        }
 
-            // Pişirme süresi hesaplama ve simülasyon
-            double bake_time = calculate_bake_time(prepare_time);
-            usleep((int)(bake_time * 1000000));  // microseconds sleep
+        // Pişirme süresini log'a yaz
+        snprintf(log_msg, sizeof(log_msg), "> Cook %d cooked order %d in %.7f seconds", cook->id, orders[order_index].order_id, shop->bake_time);
+        printf("%s\n", log_msg);
+        log_activity(log_msg);
+        publish_state(orders[order_index].pid, orders[order_index].order_id, STATE_COOKED);
+        metrics_record(METRIC_BAKE, shop->slept);
+        metrics_count(METRIC_COOKED);
 
-            pthread_mutex_lock(&order_mutex);
-            oven_occupancy--;
-            apparatus_available++;
+        // State 3 and the cooked queue change together, so a canceller
+        // holding both locks knows whether it may take the order out
+        pthread_mutex_lock(&order_mutex);
+        pthread_mutex_lock(&delivery_mutex);
+        if (order_cancelled(order_index)) {
+            pthread_mutex_lock(&cancel_mutex);
+            cancel_stats.stage[CANCEL_OVEN]++;
+            pthread_mutex_unlock(&cancel_mutex);
+            drop_cancelled_locked(order_index, 0);
+        } else {
             orders[order_index].state = 3;
-            pthread_cond_signal(&order_cond);
-            pthread_mutex_unlock(&order_mutex);
-
-            // Pişirme süresini log'a yaz
-            snprintf(log_msg, sizeof(log_msg), "> Cook %d cooked order %d in %.7f seconds", cook->id, orders[order_index].order_id, bake_time);
-            printf("%s\n", log_msg);
-            log_activity(log_msg, "a");
-
-            pthread_mutex_lock(&delivery_mutex);
+            orders[order_index].cooked_at = monotonic_seconds();
+            push_order_index(&cooked_orders, orders, order_index);
+            spatial_insert(&orders[order_index].session->cooked, orders, order_index);
             pthread_cond_signal(&delivery_cond);
-            pthread_mutex_unlock(&delivery_mutex);
-        } else {
-            pthread_mutex_unlock(&order_mutex);
         }
+        pthread_mutex_unlock(&delivery_mutex);
+        pthread_mutex_unlock(&order_mutex);
     }
 
     return NULL;
 }
 
+// Called with delivery_mutex held. Bag rules are shop_take_cooked's; the
+// courier keeps a copy of each order for after its slot is freed.
+int take_cooked_orders(DeliveryPerson* delivery_person) {
+    int first = delivery_person->bag.count;
+    int taken = shop_take_cooked(&cooked_orders, orders, &delivery_person->bag);
+    for (int i = first; i < first + taken; ++i) {
+        delivery_person->orders[i] = orders[delivery_person->bag.slots[i]];
+        delivery_person->work_count++; // Teslimatçı iş sayacını artır
+    }
+    active_orders -= taken;
+    return taken;
+}
+
+// Where orders spend their time, from the metrics histograms
+void print_stage_latency() {
+    static const char* names[METRIC_STAGES] = { "queue", "prepare", "oven wait", "bake", "bag wait", "travel" };
+    char line[512] = "> Stage p50/p99 ms:";
+    for (int s = 0; s < METRIC_STAGES; ++s) {
+        snprintf(line + strlen(line), sizeof(line) - strlen(line), " %s %.1f/%.1f,", names[s],
+                 metrics_quantile(s, 0.5) * 1000.0, metrics_quantile(s, 0.99) * 1000.0);
+    }
+    line[strlen(line) - 1] = '\0';
+    printf("%s\n", line);
+}
+
+void print_delivery_stats(int couriers) {
+    pthread_mutex_lock(&delivery_stats_mutex);
+    DeliveryStats stats = delivery_stats;
+    pthread_mutex_unlock(&delivery_stats_mutex);
+    double uptime = monotonic_seconds() - server_start;
+    printf("> Delivery (%s): %ld orders in %ld tours, avg tour %.1f, avg latency %.3f s, courier utilization %.1f%%\n",
+           dispatch_mode == DISPATCH_ROUTE ? "route" : "greedy", stats.orders, stats.tours,
+           stats.tours > 0 ? stats.tour_length_total / stats.tours : 0.0,
+           stats.orders > 0 ? stats.latency_total / stats.orders : 0.0,
+           uptime > 0 ? 100.0 * stats.busy_total / (uptime * couriers) : 0.0);
+}
+
 void* delivery_function(void* arg) {
     DeliveryPerson* delivery_person = (DeliveryPerson*)arg;
     char log_msg[256];
@@ -774,157 +1155,168 @@ void* delivery_function(void* arg) {
         pthread_mutex_lock(&delivery_mutex);
 
         // Kuryenin çantası dolana kadar bekle
-        while (delivery_person->current_orders < BAG_CAPACITY && active_orders > 0) {
-            // Teslim edilmek üzere olan bir sipariş bulun
-            int order_found = 0;
-            for (int i = 0; i < total_orders; ++i) {
-                if (orders[i].state == 3) {
-                    orders[i].state = 4; // Siparişin durumunu güncelle
-                    delivery_person->orders[delivery_person->current_orders++] = orders[i];
-                    delivery_person->work_count++; // Teslimatçı iş sayacını artır
-                    active_orders--;
-                    order_found = 1;
-                    break;
-                }
+        while (1) {
+            // Teslim edilmek üzere olan siparişleri bulun
+            int taken = take_cooked_orders(delivery_person);
+            if (taken > 0 && active_orders == 0) {
+                // Couriers holding a partial bag must not wait for a full one
+                pthread_cond_broadcast(&delivery_cond);
+            }
+            if (shop_bag_leaves(&delivery_person->bag, taken, active_orders, cooked_orders.count)) {
+                break;
             }
-
             // Eğer hazır sipariş yoksa bekle
-            if (!order_found) {
+            if (taken == 0) {
                 pthread_cond_wait(&delivery_cond, &delivery_mutex);
             }
         }
 
         pthread_mutex_unlock(&delivery_mutex);
 
-        // Eğer en az bir sipariş varsa çık ve teslim et
-        if (delivery_person->current_orders > 0) {
-            increment_pending_deliveries(); // Aktif teslimat sayısını artır
+        // Çanta boş çıkmaz, teslim et
+        increment_pending_deliveries(); // Aktif teslimat sayısını artır
+        ShopBag* bag = &delivery_person->bag;
+        int count = bag->count;
 
-            // Teslim alma işlemini logla
-            snprintf(log_msg, sizeof(log_msg), "> Delivery Person %d took orders:", delivery_person->id);
-            for (int i = 0; i < delivery_person->current_orders; ++i) {
-                snprintf(log_msg + strlen(log_msg), sizeof(log_msg) - strlen(log_msg), " %d,", delivery_person->orders[i].order_id);
-            }
-            printf("%s\n", log_msg);
-            log_activity(log_msg, "a");
-
-            for (int i = 0; i < delivery_person->current_orders; ++i) {
-                // Teslimat süresini simüle et
-                int distance = sqrt(pow(delivery_person->orders[i].customer_x - p / 2, 2) + pow(delivery_person->orders[i].customer_y - q / 2, 2)); // Haritanın ortasındaki dükkan
-                int delivery_time = distance / delivery_speed; // Basitleştirilmiş teslimat süresi hesaplaması
-                printf("Delivery time: %d seconds\n", delivery_time);
-                sleep(delivery_time);
-
-                delivery_person->delivery_count++;
-                snprintf(log_msg, sizeof(log_msg), "> Delivery Person %d delivered order %d to location (%d, %d) and Thanks Cook %d and Moto %d", delivery_person->id, delivery_person->orders[i].order_id, delivery_person->orders[i].customer_x, delivery_person->orders[i].customer_y, delivery_person->orders[i].cook_id, delivery_person->id);
-                printf("%s\n", log_msg);
-                log_activity(log_msg, "a");
-
-                // Durum güncellemesini status soket'e gönder
-                int status_fd = socket(AF_INET, SOCK_STREAM, 0);
-                if (status_fd < 0) {
-                    perror("status socket creation failed");
-                } else {
-                    if (connect(status_fd, (struct sockaddr*)&status_address, sizeof(status_address)) == 0) {
-                        send(status_fd, log_msg, strlen(log_msg), 0);
-                    } else {
-                        perror("status socket connection failed");
-                    }
-                    close(status_fd);
-                }
-
-                pthread_mutex_lock(&order_mutex);
-                delivery_person->orders[i].state = 4;
-                completed_orders++;
-                pthread_mutex_unlock(&order_mutex);
-            }
-
-
-
-            // Teslimatçı siparişlerini sıfırla
-            delivery_person->current_orders = 0;
-
-            // Eğer tüm siparişler tamamlandıysa tamamlanma sinyali gönder
-            pthread_mutex_lock(&completion_mutex);
-            pthread_cond_signal(&completion_cond);
-            pthread_mutex_unlock(&completion_mutex);
-
-            decrement_pending_deliveries(); // Aktif teslimat sayısını azalt
+        // Teslim alma işlemini logla
+        snprintf(log_msg, sizeof(log_msg), "> Delivery Person %d took orders:", delivery_person->id);
+        for (int i = 0; i < count; ++i) {
+            snprintf(log_msg + strlen(log_msg), sizeof(log_msg) - strlen(log_msg), " %d,", delivery_person->orders[i].order_id);
+        }
+        printf("%s\n", log_msg);
+        log_activity(log_msg);
+        for (int i = 0; i < count; ++i) {
+            publish_state(delivery_person->orders[i].pid, delivery_person->orders[i].order_id, STATE_DELIVERING);
         }
-    }
 
-    return NULL;
-}
+        shop_tour_begin(bag, orders);
+        double departure = monotonic_seconds();
+        for (int i = 0; i < count; ++i) {
+            metrics_record(METRIC_BAG_WAIT, departure - delivery_person->orders[i].cooked_at);
+        }
+        double latency_total = 0.0;
+
+        int delivered = 0;
+        int i;
+        double travel_time;
+        int cancelled;
+        while ((i = shop_tour_next(bag, orders, &travel_time, &cancelled)) >= 0) {
+            Order* order = &delivery_person->orders[i];
+            if (cancelled) {
+                record_cancel(CANCEL_ON_ROAD, 0.0, 0.0, 1);
+                drop_cancelled(bag->slots[i], 1);
+                continue;
+            }
+            // Teslimat süresini simüle et, bir önceki duraktan bu durağa
+            usleep((useconds_t)(travel_time * 1000000));
+            double arrived = monotonic_seconds();
+            latency_total += arrived - order->cooked_at;
+            pthread_mutex_lock(&deadline_stats_mutex);
+            deadline_record(&deadline_stats, arrived, order->deadline);
+            pthread_mutex_unlock(&deadline_stats_mutex);
+            metrics_record(METRIC_TRAVEL, arrived - departure);
+            metrics_count(METRIC_DELIVERED);
+
+            delivery_person->delivery_count++;
+            snprintf(log_msg, sizeof(log_msg), "> Delivery Person %d delivered order %d to location (%d, %d) and Thanks Cook %d and Moto %d", delivery_person->id, order->order_id, order->customer_x, order->customer_y, order->cook_id, delivery_person->id);
+            printf("%s\n", log_msg);
+            log_activity(log_msg);
 
-void* handle_status_updates(void* arg) {
-    int new_socket;
-    struct sockaddr_in address;
-    int addrlen = sizeof(address);
+            publish_state(order->pid, order->order_id, STATE_COMPLETED);
 
-    while (1) {
-        if ((new_socket = accept(status_socket, (struct sockaddr *)&address, (socklen_t*)&addrlen)) < 0) {
-            perror("status socket accept failed");
-            continue;
+            pthread_mutex_lock(&order_mutex);
+            order->state = 4;
+            completed_orders++;
+            free_order_slot(bag->slots[i]);
+            pthread_mutex_unlock(&order_mutex);
+            session_order_done(order->session);
+            delivered++;
         }
 
-        char buffer[BUFFER_SIZE];
-        int valread;
-        while ((valread = read(new_socket, buffer, BUFFER_SIZE)) > 0) {
-            buffer[valread] = '\0';
-         //   printf("Status Update: %s\n", buffer);
-        }
+        // Dükkana geri dön
+        usleep((useconds_t)(travel_time * 1000000));
+        double busy = monotonic_seconds() - departure;
+        delivery_person->busy_seconds += busy;
 
-        close(new_socket);
+        pthread_mutex_lock(&delivery_stats_mutex);
+        delivery_stats.orders += delivered;
+        delivery_stats.tours++;
+        delivery_stats.latency_total += latency_total;
+        delivery_stats.tour_length_total += bag->length;
+        delivery_stats.busy_total += busy;
+        pthread_mutex_unlock(&delivery_stats_mutex);
+
+        // Teslimatçı siparişlerini sıfırla
+        bag->count = 0;
+
+        decrement_pending_deliveries(); // Aktif teslimat sayısını azalt
     }
 
     return NULL;
 }
 
-void* handle_completion_updates(void* arg) {
-    int new_socket;
-    struct sockaddr_in address;
-    int addrlen = sizeof(address);
+// Plaintext Prometheus exposition: any request gets the current metrics
+void* handle_metrics_requests(void* arg) {
+    (void)arg;
+    char* body = malloc(METRICS_RENDER_SIZE);
+    if (body == NULL) {
+        perror("Failed to allocate metrics buffer");
+        return NULL;
+    }
 
     while (1) {
-        if ((new_socket = accept(completion_socket, (struct sockaddr *)&address, (socklen_t*)&addrlen)) < 0) {
-            perror("completion socket accept failed");
+        int new_socket = accept(metrics_socket, NULL, NULL);
+        if (new_socket < 0) {
+            perror("metrics socket accept failed");
             continue;
         }
 
-        pthread_mutex_lock(&completion_mutex);
-        while (completed_orders < total_orders) {
-            pthread_cond_wait(&completion_cond, &completion_mutex);
+        // Read the request line; a silent scraper still gets an answer
+        struct timeval timeout = { 1, 0 };
+        setsockopt(new_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        char request[1024];
+        ssize_t ignored = read(new_socket, request, sizeof(request));
+        (void)ignored;
+
+        size_t length = metrics_render(body, METRICS_RENDER_SIZE);
+        char header[128];
+        int header_length = snprintf(header, sizeof(header),
+                                      "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n", length);
+        send(new_socket, header, header_length, MSG_NOSIGNAL);
+        size_t sent_total = 0;
+        while (sent_total < length) {
+            ssize_t sent = send(new_socket, body + sent_total, length - sent_total, MSG_NOSIGNAL);
+            if (sent <= 0) {
+                break;
+            }
+            sent_total += (size_t)sent;
         }
-        pthread_mutex_unlock(&completion_mutex);
-
-        char buffer[BUFFER_SIZE];
-        snprintf(buffer, BUFFER_SIZE, "All orders completed");
-
-        send(new_socket, buffer, strlen(buffer), 0);
         close(new_socket);
     }
 
+    free(body);
     return NULL;
 }
 
-void handle_signal(int signal) {
-    if (signal == SIGINT || signal == SIGTERM) {
+// Shutdown runs in an ordinary thread, never in a handler: it takes the
+// same locks the workers take
+void* handle_signals(void* arg) {
+    const sigset_t* set = (const sigset_t*)arg;
+    int received;
+    if (sigwait(set, &received) == 0) {
         printf("\n> ^C.. Upps quitting.. writing log file\n");
-        log_activity("> Server shut down", "a");
-
-        // Free all allocated memory
-        cleanup();
+        log_activity("> Server shut down");
+        status_bus_stop();
+        journal_stop(); // Unfinished orders are resumed by the next start with -R
+        logger_shutdown(); // Drain staged log records before exiting
 
+        // Cooks and couriers are still running on orders[] and their own
+        // structs, so nothing is freed here; exit gives it all back
         exit(EXIT_SUCCESS);
     }
+    return NULL;
 }
 
-void log_activity(const char* message, const char* mode) {
-    FILE* log_file = fopen("pide_shop.log", mode);
-    if (log_file == NULL) {
-        perror("fopen");
-        return;
-    }
-    fprintf(log_file, "%s\n", message);
-    fclose(log_file);
+void log_activity(const char* message) {
+    logger_write(message);
 }
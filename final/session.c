@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include "protocol.h"
+#include "session.h"
+
+static Session sessions[SESSION_TABLE_SIZE];
+static Session* finished[SESSION_TABLE_SIZE]; // Done sessions not yet reported, FIFO
+static int finished_head = 0;
+static int finished_count = 0;
+static int active_sessions = 0; // Opened by HELLO, not yet reported
+static pthread_mutex_t session_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t finished_cond = PTHREAD_COND_INITIALIZER;
+
+// Reported sessions keep their slot so a late completion subscriber still
+// gets its push; such slots are reused once the table runs out of free ones.
+static Session* find_session(pid_t pid, int create) {
+    unsigned int h = ((unsigned int)pid * 2654435761u) & (SESSION_TABLE_SIZE - 1);
+    Session* free_slot = NULL;
+    Session* stale_slot = NULL;
+    for (int probe = 0; probe < SESSION_TABLE_SIZE; ++probe) {
+        Session* session = &sessions[(h + probe) & (SESSION_TABLE_SIZE - 1)];
+        if (session->pid == pid) {
+            return session;
+        }
+        if (session->pid == 0 && free_slot == NULL) {
+            free_slot = session;
+        } else if (session->reported && stale_slot == NULL) {
+            stale_slot = session;
+        }
+    }
+    if (free_slot == NULL) {
+        free_slot = stale_slot;
+    }
+    if (!create || free_slot == NULL) {
+        return NULL;
+    }
+    spatial_free(&free_slot->cooked);
+    memset(free_slot, 0, sizeof(*free_slot));
+    free_slot->pid = pid;
+    free_slot->expected = -1;
+    free_slot->order_head = -1;
+    free_slot->notify_fd = -1;
+    gettimeofday(&free_slot->start, NULL);
+    return free_slot;
+}
+
+static void release_if_settled(Session* session) {
+    if (session->reported && session->notified) {
+        session->pid = 0;
+    }
+}
+
+static void push_complete(Session* session) {
+    unsigned char frame[FRAME_HEADER_SIZE + COMPLETE_PAYLOAD_SIZE];
+    size_t offset = put_frame_header(frame, FRAME_COMPLETE, COMPLETE_PAYLOAD_SIZE);
+    put_u32(frame + offset, (uint32_t)session->pid);
+    put_u32(frame + offset + 4, (uint32_t)session->completed);
+    put_u32(frame + offset + 8, (uint32_t)session->cancelled);
+    // 20 bytes fit in any socket buffer, a failure means the client is gone
+    send(session->notify_fd, frame, sizeof(frame), MSG_NOSIGNAL | MSG_DONTWAIT);
+    close(session->notify_fd);
+    session->notify_fd = -1;
+    session->notified = 1;
+}
+
+// Called with the table locked after every change of a session's counters
+static void check_finished(Session* session) {
+    if (session->expected < 0 || session->completed + session->cancelled < session->expected || session->done) {
+        return;
+    }
+    session->done = 1;
+    if (session->notify_fd != -1) {
+        push_complete(session);
+    }
+    finished[(finished_head + finished_count) % SESSION_TABLE_SIZE] = session;
+    finished_count++;
+    pthread_cond_signal(&finished_cond);
+}
+
+// HELLO from pid. Returns NULL when the table is full.
+Session* session_open(pid_t pid, int orders, int p, int q) {
+    pthread_mutex_lock(&session_mutex);
+    Session* session = find_session(pid, 1);
+    if (session == NULL || (session->done && !session->reported)) {
+        pthread_mutex_unlock(&session_mutex);
+        return NULL;
+    }
+    if (session->done) {
+        // Same process starts over after its earlier batch was reported
+        session->done = session->notified = session->reported = 0;
+        session->expected = -1;
+        session->received = session->completed = session->cancelled = 0;
+    }
+    if (session->expected < 0) {
+        // Every earlier order of this slot is delivered, so the grid is empty
+        spatial_free(&session->cooked);
+        if (spatial_init(&session->cooked, p, q) < 0) {
+            pthread_mutex_unlock(&session_mutex);
+            return NULL;
+        }
+        session->expected = orders;
+        gettimeofday(&session->start, NULL);
+        active_sessions++;
+    } else {
+        session->expected += orders; // Same process announced another batch
+    }
+    session->p = p;
+    session->q = q;
+    check_finished(session);
+    pthread_mutex_unlock(&session_mutex);
+    return session;
+}
+
+// Session the next order of pid belongs to, NULL if it was never announced
+// or already sent everything it announced.
+Session* session_accept_order(pid_t pid) {
+    pthread_mutex_lock(&session_mutex);
+    Session* session = find_session(pid, 0);
+    if (session != NULL && (session->expected < 0 || session->received == session->expected)) {
+        session = NULL;
+    }
+    if (session != NULL) {
+        session->received++;
+    }
+    pthread_mutex_unlock(&session_mutex);
+    return session;
+}
+
+void session_order_done(Session* session) {
+    pthread_mutex_lock(&session_mutex);
+    session->completed++;
+    check_finished(session);
+    pthread_mutex_unlock(&session_mutex);
+}
+
+void session_order_cancelled(Session* session) {
+    pthread_mutex_lock(&session_mutex);
+    session->cancelled++;
+    check_finished(session);
+    pthread_mutex_unlock(&session_mutex);
+}
+
+// Journal replay: the session as the journal left it, its client gone.
+// received orders is all it will ever get; the live ones come back through
+// session_accept_order.
+Session* session_restore(pid_t pid, int received, int completed, int cancelled, int p, int q) {
+    Session* session = session_open(pid, received, p, q);
+    if (session == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&session_mutex);
+    session->received = completed + cancelled;
+    session->completed = completed;
+    session->cancelled = cancelled;
+    pthread_mutex_unlock(&session_mutex);
+    return session;
+}
+
+// Live session of pid, NULL if it has none waiting for orders or deliveries
+Session* session_lookup(pid_t pid) {
+    pthread_mutex_lock(&session_mutex);
+    Session* session = find_session(pid, 0);
+    if (session != NULL && (session->expected < 0 || session->done)) {
+        session = NULL;
+    }
+    pthread_mutex_unlock(&session_mutex);
+    return session;
+}
+
+// Orders pid announced but never sent are given up, so the session can
+// finish with what it has. Returns how many.
+int session_cancel_unsent(pid_t pid) {
+    pthread_mutex_lock(&session_mutex);
+    Session* session = find_session(pid, 0);
+    int unsent = 0;
+    if (session != NULL && session->expected >= 0 && !session->done) {
+        unsent = session->expected - session->received;
+        session->cancelled += unsent;
+        session->expected = session->received;
+        check_finished(session);
+    }
+    pthread_mutex_unlock(&session_mutex);
+    return unsent;
+}
+
+// Takes ownership of fd. FRAME_COMPLETE is pushed once the session's orders
+// are delivered, right away if they already are.
+int session_subscribe(int fd, pid_t pid) {
+    pthread_mutex_lock(&session_mutex);
+    Session* session = find_session(pid, 1);
+    if (session == NULL || session->notify_fd != -1 || session->notified) {
+        pthread_mutex_unlock(&session_mutex);
+        close(fd);
+        return -1;
+    }
+    session->notify_fd = fd;
+    if (session->done) {
+        push_complete(session);
+        release_if_settled(session);
+    }
+    pthread_mutex_unlock(&session_mutex);
+    return 0;
+}
+
+void session_wait_finished(SessionReport* report) {
+    pthread_mutex_lock(&session_mutex);
+    while (finished_count == 0) {
+        pthread_cond_wait(&finished_cond, &session_mutex);
+    }
+    Session* session = finished[finished_head];
+    finished_head = (finished_head + 1) % SESSION_TABLE_SIZE;
+    finished_count--;
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    report->pid = session->pid;
+    report->orders = session->completed;
+    report->cancelled = session->cancelled;
+    report->seconds = (now.tv_sec - session->start.tv_sec) + (now.tv_usec - session->start.tv_usec) / 1000000.0;
+    session->reported = 1;
+    active_sessions--;
+    release_if_settled(session);
+    pthread_mutex_unlock(&session_mutex);
+}
+
+// Sessions still waiting for orders or deliveries
+int session_active_count(void) {
+    pthread_mutex_lock(&session_mutex);
+    int count = active_sessions;
+    pthread_mutex_unlock(&session_mutex);
+    return count;
+}
@@ -0,0 +1,51 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <sys/types.h>
+#include <sys/time.h>
+#include "pideshop.h"
+#include "spatial.h"
+#include "orderstore.h"
+
+#define SESSION_TABLE_SIZE 256 // Sessions alive at once, power of two > MAX_CLIENTS
+
+// One HungryVeryMuch batch. Sessions live in a fixed table, so Order.session
+// stays valid until the session's last order is delivered.
+typedef struct Session {
+    pid_t pid;       // 0 = free slot
+    int p, q;        // Map dimensions from HELLO, the shop is at the centre
+    int promise_ms;  // From HELLO for every order, 0 = computed from the distance
+    int expected;    // Announced by HELLO, -1 while the completion subscriber came first
+    int received;
+    int completed;
+    int cancelled;   // Dropped before delivery, counts toward done like completed
+    int order_head;  // Live orders, linked through Order.session_next under the server's order_mutex
+    OrderArena arena; // Slots of those orders, reset when the last one is gone
+    SpatialGrid cooked; // Orders waiting for a courier, under the server's delivery_mutex
+    int notify_fd;   // Completion port connection, -1 if none
+    int done;        // Every expected order delivered or cancelled
+    int notified;    // FRAME_COMPLETE already pushed
+    int reported;    // Summary already taken by main()
+    struct timeval start;
+} Session;
+
+// A session whose orders are all delivered, handed to main() for its summary
+typedef struct {
+    pid_t pid;
+    int orders;
+    int cancelled;
+    double seconds; // From HELLO to the last delivery
+} SessionReport;
+
+Session* session_open(pid_t pid, int orders, int p, int q);
+Session* session_accept_order(pid_t pid);
+void session_order_done(Session* session);
+void session_order_cancelled(Session* session);
+Session* session_restore(pid_t pid, int received, int completed, int cancelled, int p, int q);
+Session* session_lookup(pid_t pid);
+int session_cancel_unsent(pid_t pid);
+int session_subscribe(int fd, pid_t pid);
+void session_wait_finished(SessionReport* report);
+int session_active_count(void);
+
+#endif
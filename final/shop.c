@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include "shop.h"
+#include "cooktime.h"
+#include "deadline.h"
+#include "session.h"
+#include "spatial.h"
+
+// Cook stages between two shop_cook_step calls
+#define COOK_IDLE 0
+#define COOK_TAKEN 1
+#define COOK_PREPARING 2  // SHOP_SLEEP handed out
+#define COOK_PREPARED 3
+#define COOK_LOADING 4
+#define COOK_BAKING 5     // SHOP_SLEEP handed out
+#define COOK_UNLOADING 6
+
+static ShopConfig config = { DEFAULT_MATRIX_ROWS, DEFAULT_MATRIX_COLS, SCHEDULE_FIFO, DISPATCH_ROUTE, 1 };
+
+void shop_init(const ShopConfig* shop_config) {
+    config = *shop_config;
+}
+
+// Pişirme süresi, hazırlık süresinin yarısı
+double shop_bake_time(double cook_time) {
+    return cook_time / 2;
+}
+
+void init_index_queue(OrderIndexQueue* iq) {
+    iq->head = iq->tail = -1;
+    iq->count = 0;
+}
+
+void push_order_index(OrderIndexQueue* iq, Order* orders, int index) {
+    orders[index].next = -1;
+    orders[index].prev = iq->tail;
+    if (iq->tail == -1) {
+        iq->head = iq->tail = index;
+    } else {
+        orders[iq->tail].next = index;
+        iq->tail = index;
+    }
+    iq->count++;
+}
+
+void remove_order_index(OrderIndexQueue* iq, Order* orders, int index) {
+    if (orders[index].prev != -1) {
+        orders[orders[index].prev].next = orders[index].next;
+    } else {
+        iq->head = orders[index].next;
+    }
+    if (orders[index].next != -1) {
+        orders[orders[index].next].prev = orders[index].prev;
+    } else {
+        iq->tail = orders[index].prev;
+    }
+    iq->count--;
+}
+
+void shop_cook_init(ShopCook* cook, int id, void (*on_grant)(KitchenWaiter* waiter)) {
+    cook->id = id;
+    cook->slot = -1;
+    cook->stage = COOK_IDLE;
+    kitchen_pass_init(&cook->pass, on_grant, id);
+}
+
+void shop_cook_begin(ShopCook* cook, Order* orders, int slot) {
+    cook->slot = slot;
+    cook->stage = COOK_TAKEN;
+    cook->slept = 0.0;
+    // Under FIFO every cook is equal at the oven, so it stays first come first served
+    cook->priority = config.schedule == SCHEDULE_EDF ? orders[slot].priority : 0.0;
+}
+
+static int drop(ShopCook* cook, int stage, double saved_cook, double saved_oven) {
+    cook->stage = COOK_IDLE;
+    cook->drop_stage = stage;
+    cook->saved_cook = saved_cook > 0 ? saved_cook : 0.0;
+    cook->saved_oven = saved_oven > 0 ? saved_oven : 0.0;
+    return SHOP_DROPPED;
+}
+
+static int token_set(const ShopCook* cook, Order* orders) {
+    return atomic_load(&orders[cook->slot].cancelled);
+}
+
+// Her aşamadan önce iptal jetonuna bakılır. A cook queued for the oven,
+// apparatus or door leaves the queue and gives back what it held. A pide
+// already slid in comes straight out again without baking; one in the
+// middle of baking comes out once the caller's wait is cut short.
+int shop_cook_step(ShopCook* cook, Order* orders, double now) {
+    switch (cook->stage) {
+        case COOK_TAKEN:
+            if (token_set(cook, orders)) {
+                return drop(cook, CANCEL_QUEUED, 0.0, 0.0);
+            }
+            cook->prepare_time = cooktime_get(config.rows, config.cols);
+            cook->stage = COOK_PREPARING;
+            return SHOP_STARTED;
+
+        case COOK_PREPARING:
+            cook->sleep = cook->prepare_time;
+            cook->stage = COOK_PREPARED;
+            return SHOP_SLEEP;
+
+        case COOK_PREPARED:
+            if (token_set(cook, orders)) {
+                return drop(cook, CANCEL_PREPARING, cook->prepare_time - cook->slept, 0.0);
+            }
+            cook->queued_at = now;
+            kitchen_pass_begin(&cook->pass, KITCHEN_LOAD, cook->priority);
+            cook->stage = COOK_LOADING;
+            return SHOP_PREPARED;
+
+        case COOK_LOADING:
+            if (!kitchen_pass_run(&cook->pass)) {
+                if (token_set(cook, orders)) {
+                    kitchen_pass_withdraw(&cook->pass);
+                    return drop(cook, CANCEL_OVEN_QUEUE, 0.0, 0.0);
+                }
+                return SHOP_BLOCKED;
+            }
+            cook->bake_time = shop_bake_time(cook->prepare_time);
+            cook->sleep = cook->bake_time;
+            cook->stage = COOK_BAKING;
+            if (token_set(cook, orders)) {
+                // Skip the bake, the whole of it goes back as oven time
+                cook->slept = 0.0;
+                kitchen_pass_begin(&cook->pass, KITCHEN_UNLOAD, cook->priority);
+                cook->stage = COOK_UNLOADING;
+            }
+            return SHOP_IN_OVEN;
+
+        case COOK_BAKING:
+            kitchen_pass_begin(&cook->pass, KITCHEN_UNLOAD, cook->priority);
+            cook->stage = COOK_UNLOADING;
+            return SHOP_SLEEP;
+
+        case COOK_UNLOADING:
+            if (!kitchen_pass_run(&cook->pass)) {
+                return SHOP_BLOCKED;
+            }
+            if (token_set(cook, orders)) {
+                return drop(cook, CANCEL_OVEN, 0.0, cook->bake_time - cook->slept);
+            }
+            cook->stage = COOK_IDLE;
+            return SHOP_COOKED;
+    }
+    return SHOP_COOKED;
+}
+
+void shop_cook_destroy(ShopCook* cook) {
+    kitchen_pass_destroy(&cook->pass);
+}
+
+// Moves cooked orders into the bag and returns how many. The oldest cooked
+// order always goes first so nothing starves. A bag holds orders of one
+// session only, since every session has its own map and shop; in route
+// mode the rest of the bag is filled with the orders closest to the first.
+int shop_take_cooked(OrderIndexQueue* cooked, Order* orders, ShopBag* bag) {
+    int candidates[BAG_CAPACITY];
+    int count = 0;
+    if (bag->count == 0) {
+        candidates[count] = cooked->head;
+        count += candidates[count] != -1;
+    } else if (bag->count == BAG_CAPACITY) {
+        return 0;
+    } else if (config.dispatch_mode == DISPATCH_GREEDY) {
+        int head = cooked->head;
+        if (head != -1 && orders[head].session == orders[bag->slots[0]].session) {
+            candidates[count++] = head;
+        }
+    } else {
+        const Order* seed = &orders[bag->slots[0]];
+        count = spatial_k_nearest(&seed->session->cooked, orders, seed->customer_x, seed->customer_y,
+                                  BAG_CAPACITY - bag->count, candidates);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        int slot = candidates[i];
+        remove_order_index(cooked, orders, slot);
+        spatial_remove(&orders[slot].session->cooked, orders, slot);
+        orders[slot].state = 4; // Siparişin durumunu güncelle
+        bag->slots[bag->count++] = slot;
+    }
+    return count;
+}
+
+// Kuryenin çantası dolana kadar bekler. A partial bag leaves once nothing
+// else is coming, or when another session's orders are ready, rather than
+// block them.
+int shop_bag_leaves(const ShopBag* bag, int taken, int active_orders, int cooked_waiting) {
+    if (bag->count == 0) {
+        return 0;
+    }
+    return bag->count == BAG_CAPACITY || active_orders == 0 || (taken == 0 && cooked_waiting > 0);
+}
+
+// Dükkan haritanın ortasında; durakları rota sırasına koy
+void shop_tour_begin(ShopBag* bag, const Order* orders) {
+    const struct Session* session = orders[bag->slots[0]].session;
+    bag->shop.x = session->p / 2;
+    bag->shop.y = session->q / 2;
+    for (int i = 0; i < bag->count; ++i) {
+        bag->stops[i].x = orders[bag->slots[i]].customer_x;
+        bag->stops[i].y = orders[bag->slots[i]].customer_y;
+        bag->visit[i] = i;
+    }
+    bag->length = config.dispatch_mode == DISPATCH_ROUTE ? route_plan(bag->shop, bag->stops, bag->count, bag->visit)
+                                                         : route_length(bag->shop, bag->stops, bag->visit, bag->count);
+    bag->next_stop = 0;
+    bag->at = bag->shop;
+}
+
+// Cancelled on the way: the stop is skipped, the next leg starts from here
+int shop_tour_next(ShopBag* bag, Order* orders, double* travel, int* cancelled) {
+    if (bag->next_stop == bag->count) {
+        *travel = route_distance(bag->at, bag->shop) / config.speed;
+        *cancelled = 0;
+        bag->at = bag->shop;
+        return -1;
+    }
+    int i = bag->visit[bag->next_stop++];
+    *cancelled = atomic_load(&orders[bag->slots[i]].cancelled);
+    *travel = 0.0;
+    if (!*cancelled) {
+        *travel = route_distance(bag->at, bag->stops[i]) / config.speed;
+        bag->at = bag->stops[i];
+    }
+    return i;
+}
+
+void shop_print_cancel_stats(const CancelStats* stats) {
+    if (stats->requested == 0 && stats->too_late == 0 && stats->unsent == 0) {
+        return;
+    }
+    long dropped = 0;
+    for (int i = 0; i < CANCEL_STAGES; ++i) {
+        dropped += stats->stage[i];
+    }
+    // A token set while the courier was already at the door is delivered anyway
+    printf("> Cancelled: %ld of %ld requested orders, %ld unsent, %ld too late; queued %ld, preparing %ld, oven queue %ld, oven %ld, ready %ld, on the road %ld\n",
+           dropped, stats->requested, stats->unsent, stats->too_late, stats->stage[CANCEL_QUEUED], stats->stage[CANCEL_PREPARING],
+           stats->stage[CANCEL_OVEN_QUEUE], stats->stage[CANCEL_OVEN], stats->stage[CANCEL_READY], stats->stage[CANCEL_ON_ROAD]);
+    printf(">   recovered %.3f cook seconds, %.3f oven slot seconds, %ld bag slots\n", stats->cook_seconds, stats->oven_seconds, stats->bag_slots);
+}
@@ -0,0 +1,102 @@
+#ifndef SHOP_H
+#define SHOP_H
+
+#include "pideshop.h"
+#include "kitchen.h"
+#include "route.h"
+
+// The order's way through the shop, shared by the threaded server and the
+// simulation (-s): a cook's stages with their cancel checks and kitchen
+// passes, the courier's bag and tour. The callers only differ in how they
+// wait and what they log; nothing here sleeps or takes the server's locks.
+
+// Where an order was when its cancellation took effect
+#define CANCEL_QUEUED 0    // Before any cook touched it
+#define CANCEL_PREPARING 1
+#define CANCEL_OVEN_QUEUE 2 // Queued for the oven, apparatus or door; the queue is left
+#define CANCEL_OVEN 3      // Inside the oven
+#define CANCEL_READY 4     // Cooked, waiting for a courier
+#define CANCEL_ON_ROAD 5   // In a bag, its stop is skipped
+#define CANCEL_STAGES 6
+
+// What the cook's caller does after shop_cook_step, then steps again
+#define SHOP_STARTED 0  // Order is the cook's now: state 1
+#define SHOP_SLEEP 1    // Wait cook->sleep seconds, less if cancelled, and put the time in cook->slept
+#define SHOP_PREPARED 2 // Prepared, the oven is next
+#define SHOP_BLOCKED 3  // Queued for a kitchen resource, step again once cook->pass.waiter is granted
+#define SHOP_IN_OVEN 4  // Oven slot taken: state 2
+#define SHOP_COOKED 5   // Out of the oven; the cook is free
+#define SHOP_DROPPED 6  // Cancelled at cook->drop_stage; the cook is free
+
+typedef struct {
+    int rows, cols;    // Cook time matrix
+    int schedule;      // SCHEDULE_FIFO | SCHEDULE_EDF, EDF also orders the kitchen queues
+    int dispatch_mode; // DISPATCH_GREEDY | DISPATCH_ROUTE
+    int speed;         // Map units per second
+} ShopConfig;
+
+typedef struct {
+    long requested;            // Tokens set
+    long too_late;             // Already delivered, or never existed
+    long unsent;               // Announced by HELLO but never sent
+    long stage[CANCEL_STAGES];
+    double cook_seconds;       // Preparation not spent
+    double oven_seconds;       // Oven slot time given back
+    long bag_slots;            // Bag space never used or freed on the road
+} CancelStats;
+
+// FIFO of order slots threaded through Order.next/prev, so push/pop/remove are O(1)
+typedef struct {
+    int head;
+    int tail;
+    int count;
+} OrderIndexQueue;
+
+typedef struct {
+    int id;
+    int slot;            // Order in hand, kept after SHOP_COOKED and SHOP_DROPPED
+    int stage;
+    double priority;     // Kitchen queue key
+    double prepare_time;
+    double bake_time;
+    double sleep;        // SHOP_SLEEP: seconds to wait
+    double slept;        // Set by the caller after SHOP_SLEEP
+    double queued_at;    // When the oven pass started, for the oven wait
+    int drop_stage;      // SHOP_DROPPED: CANCEL_*
+    double saved_cook;   // SHOP_DROPPED: preparation not spent
+    double saved_oven;   // SHOP_DROPPED: oven slot time given back
+    KitchenPass pass;
+} ShopCook;
+
+// A courier's orders and the tour through them
+typedef struct {
+    int slots[BAG_CAPACITY];
+    int count;
+    RoutePoint shop;
+    RoutePoint stops[BAG_CAPACITY];
+    int visit[BAG_CAPACITY]; // Tour order, indexes into slots
+    int next_stop;
+    RoutePoint at;
+    double length;
+} ShopBag;
+
+void shop_init(const ShopConfig* config);
+double shop_bake_time(double cook_time);
+
+void init_index_queue(OrderIndexQueue* iq);
+void push_order_index(OrderIndexQueue* iq, Order* orders, int index);
+void remove_order_index(OrderIndexQueue* iq, Order* orders, int index);
+
+void shop_cook_init(ShopCook* cook, int id, void (*on_grant)(KitchenWaiter* waiter));
+void shop_cook_begin(ShopCook* cook, Order* orders, int slot);
+int shop_cook_step(ShopCook* cook, Order* orders, double now); // SHOP_*
+void shop_cook_destroy(ShopCook* cook);
+
+int shop_take_cooked(OrderIndexQueue* cooked, Order* orders, ShopBag* bag);
+int shop_bag_leaves(const ShopBag* bag, int taken, int active_orders, int cooked_waiting);
+void shop_tour_begin(ShopBag* bag, const Order* orders);
+int shop_tour_next(ShopBag* bag, Order* orders, double* travel, int* cancelled); // Bag index, -1 with the way back in travel
+
+void shop_print_cancel_stats(const CancelStats* stats);
+
+#endif
@@ -0,0 +1,524 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "pideshop.h"
+#include "logger.h"
+#include "cooktime.h"
+#include "spatial.h"
+#include "session.h"
+#include "kitchen.h"
+#include "cookpool.h"
+#include "shop.h"
+#include "sim.h"
+
+// Discrete-event run of the shop: the server's own cook, kitchen and
+// courier steps (shop.c, kitchen.c, cookpool.c), but every sleep becomes an
+// event on a virtual clock and every kitchen wait a grant event. One
+// session, one map.
+
+#define EVENT_ARRIVAL 0   // id = order
+#define EVENT_COOK 1      // id = cook, its sleep is over unless cancelled first
+#define EVENT_GRANTED 2   // id = cook, the kitchen resource it queued for is its now
+#define EVENT_DELIVERED 3 // id = courier, next stop of its tour
+#define EVENT_RETURNED 4  // id = courier
+#define EVENT_CANCEL 5    // id = order
+
+typedef struct {
+    double time;
+    long seq; // Ties run in scheduling order
+    int type;
+    int id;
+} SimEvent;
+
+typedef struct {
+    ShopCook shop;
+    int idle;
+    long timer;        // seq of the pending EVENT_COOK, -1 if none
+    double slept_from;
+    int work_count;
+} SimCook;
+
+typedef struct {
+    ShopBag bag;
+    int stop;          // Bag index of the stop it is driving to
+    double departed;
+    int work_count;
+    int delivery_count;
+} SimCourier;
+
+static SimEvent* heap = NULL;
+static int heap_size = 0;
+static int heap_capacity = 0;
+static long event_seq = 0;
+static double now = 0.0;
+
+static const SimConfig* config;
+static Order* orders = NULL;
+static unsigned char* finished = NULL;   // Delivered or dropped
+static unsigned char* cancelling = NULL; // Its client will cancel it
+static SimCook* cooks = NULL;
+static SimCourier* couriers = NULL;
+static Session session;
+static OrderIndexQueue cooked;
+static int arrived = 0;
+static int active_orders = 0; // Arrived, not yet in a bag nor dropped
+static int delivered = 0;
+static int dropped = 0;
+static int next_waker = 0; // Idle cooks are tried from here on, like the pool's wakeups
+static int* idle_couriers = NULL; // FIFO, the head fills its bag
+static int idle_courier_head = 0;
+static int idle_courier_count = 0;
+static DeadlineStats deadline_stats;
+static CancelStats cancel_stats;
+
+static struct {
+    long tours;
+    double tour_length_total;
+    double latency_total;
+    double busy_total;
+} stats;
+
+static long schedule(double time, int type, int id) {
+    if (heap_size == heap_capacity) {
+        heap_capacity = heap_capacity == 0 ? 1024 : heap_capacity * 2;
+        heap = realloc(heap, heap_capacity * sizeof(SimEvent));
+        if (heap == NULL) {
+            perror("Failed to grow event queue");
+            exit(EXIT_FAILURE);
+        }
+    }
+    SimEvent event = { time, event_seq++, type, id };
+    int i = heap_size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap[parent].time < event.time || (heap[parent].time == event.time && heap[parent].seq < event.seq)) {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = event;
+    return event.seq;
+}
+
+static SimEvent next_event(void) {
+    SimEvent top = heap[0];
+    SimEvent last = heap[--heap_size];
+    int i = 0;
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= heap_size) {
+            break;
+        }
+        if (child + 1 < heap_size && (heap[child + 1].time < heap[child].time ||
+            (heap[child + 1].time == heap[child].time && heap[child + 1].seq < heap[child].seq))) {
+            child++;
+        }
+        if (last.time < heap[child].time || (last.time == heap[child].time && last.seq < heap[child].seq)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+static double sim_clock(void) {
+    return now;
+}
+
+// Called by the releasing cook with the resource locked: resume later
+static void kitchen_granted(KitchenWaiter* waiter) {
+    schedule(now, EVENT_GRANTED, waiter->owner);
+}
+
+static void dispatch_couriers(void);
+
+// drop_cancelled_locked; in_bag: a courier took it, so it no longer counts as active
+static void drop_order(int slot, int in_bag) {
+    orders[slot].state = 5;
+    finished[slot] = 1;
+    dropped++;
+    if (!in_bag) {
+        active_orders--;
+        dispatch_couriers(); // Partial bags may leave now
+    }
+}
+
+// Same promise and key as place_order. A client promise waits in deadline
+// until the order arrives, 0 if it has none.
+static void place(int slot) {
+    double travel = deadline_travel(orders[slot].customer_x, orders[slot].customer_y, config->p, config->q, config->speed);
+    double promise = orders[slot].deadline > 0 ? orders[slot].deadline : deadline_promise(&config->deadline, travel);
+    orders[slot].placed_at = now;
+    orders[slot].deadline = now + promise;
+    orders[slot].priority = deadline_key(&config->deadline, now, orders[slot].deadline, travel);
+    active_orders++;
+    cook_pool_submit(slot, (unsigned int)orders[slot].pid, orders[slot].priority);
+}
+
+// cook_function with events for waits: steps the cook until it sleeps,
+// queues in the kitchen or finds no order in the pool
+static void run_cook(int id) {
+    SimCook* cook = &cooks[id];
+    ShopCook* shop = &cook->shop;
+    char log_msg[256];
+    while (1) {
+        if (cook->idle) {
+            int slot = cook_pool_try_take(id);
+            if (slot < 0) {
+                return;
+            }
+            cook->idle = 0;
+            if (now - orders[slot].placed_at > config->deadline.aging_limit) {
+                deadline_stats.aged++;
+            }
+            shop_cook_begin(shop, orders, slot);
+        }
+
+        int slot = shop->slot;
+        switch (shop_cook_step(shop, orders, now)) {
+            case SHOP_STARTED:
+                orders[slot].state = 1;
+                orders[slot].cook_id = id;
+                cook->work_count++;
+                break;
+
+            case SHOP_SLEEP:
+                cook->slept_from = now;
+                cook->timer = schedule(now + shop->sleep, EVENT_COOK, id);
+                return;
+
+            case SHOP_PREPARED:
+                snprintf(log_msg, sizeof(log_msg), "> Cook %d prepared order %d in %.7f seconds", id, orders[slot].order_id, shop->prepare_time);
+                logger_write(log_msg);
+                break;
+
+            case SHOP_BLOCKED:
+                return;
+
+            case SHOP_IN_OVEN:
+                orders[slot].state = 2;
+                break;
+
+            case SHOP_COOKED:
+                snprintf(log_msg, sizeof(log_msg), "> Cook %d cooked order %d in %.7f seconds", id, orders[slot].order_id, shop->bake_time);
+                logger_write(log_msg);
+                orders[slot].state = 3;
+                orders[slot].cooked_at = now;
+                push_order_index(&cooked, orders, slot);
+                spatial_insert(&session.cooked, orders, slot);
+                cook->idle = 1;
+                dispatch_couriers();
+                break;
+
+            case SHOP_DROPPED:
+                cancel_stats.stage[shop->drop_stage]++;
+                cancel_stats.cook_seconds += shop->saved_cook;
+                cancel_stats.oven_seconds += shop->saved_oven;
+                cancel_stats.bag_slots++;
+                cook->idle = 1;
+                drop_order(slot, 0);
+                break;
+        }
+    }
+}
+
+// A submit wakes one parked cook in the server; here every idle one looks
+static void wake_idle_cooks(void) {
+    for (int k = 0; k < config->cooks; ++k) {
+        int id = (next_waker + k) % config->cooks;
+        if (cooks[id].idle) {
+            run_cook(id);
+        }
+    }
+    next_waker = (next_waker + 1) % config->cooks;
+}
+
+// Schedules the courier's next stop, or its way back. Cancelled stops are
+// dropped without driving there.
+static void next_leg(int id) {
+    SimCourier* courier = &couriers[id];
+    double travel;
+    int cancelled;
+    int i;
+    while ((i = shop_tour_next(&courier->bag, orders, &travel, &cancelled)) >= 0 && cancelled) {
+        cancel_stats.stage[CANCEL_ON_ROAD]++;
+        cancel_stats.bag_slots++;
+        drop_order(courier->bag.slots[i], 1);
+    }
+    courier->stop = i;
+    schedule(now + travel, i >= 0 ? EVENT_DELIVERED : EVENT_RETURNED, id);
+}
+
+static void depart(int id) {
+    SimCourier* courier = &couriers[id];
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "> Delivery Person %d took orders:", id);
+    for (int i = 0; i < courier->bag.count; ++i) {
+        snprintf(log_msg + strlen(log_msg), sizeof(log_msg) - strlen(log_msg), " %d,", orders[courier->bag.slots[i]].order_id);
+    }
+    logger_write(log_msg);
+
+    shop_tour_begin(&courier->bag, orders);
+    stats.tours++;
+    stats.tour_length_total += courier->bag.length;
+    courier->departed = now;
+    next_leg(id);
+}
+
+// delivery_function's bag loop: the head of the idle couriers fills its
+// bag by shop_take_cooked and leaves by shop_bag_leaves
+static void dispatch_couriers(void) {
+    while (idle_courier_count > 0) {
+        int id = idle_couriers[idle_courier_head];
+        SimCourier* courier = &couriers[id];
+        int taken = shop_take_cooked(&cooked, orders, &courier->bag);
+        active_orders -= taken;
+        courier->work_count += taken;
+        if (shop_bag_leaves(&courier->bag, taken, active_orders, cooked.count)) {
+            idle_courier_head = (idle_courier_head + 1) % config->couriers;
+            idle_courier_count--;
+            depart(id);
+        } else if (taken == 0) {
+            break; // Keeps filling when more orders come out of the oven
+        }
+    }
+}
+
+// reactor_on_cancel for one order
+static void cancel(int slot) {
+    if (finished[slot]) {
+        cancel_stats.too_late++;
+        return;
+    }
+    if (atomic_exchange(&orders[slot].cancelled, 1)) {
+        return;
+    }
+    cancel_stats.requested++;
+    if (orders[slot].state == 3) {
+        remove_order_index(&cooked, orders, slot);
+        spatial_remove(&session.cooked, orders, slot);
+        cancel_stats.stage[CANCEL_READY]++;
+        cancel_stats.bag_slots++;
+        drop_order(slot, 0);
+    } else if (orders[slot].state == 1 || orders[slot].state == 2) {
+        // wake_cook_of: a sleeping cook stops early, one queued for the oven
+        // leaves the queue. Not granted means no EVENT_GRANTED is pending.
+        SimCook* cook = &cooks[orders[slot].cook_id];
+        if (cook->timer >= 0) {
+            cook->timer = -1;
+            cook->shop.slept = now - cook->slept_from;
+            run_cook(orders[slot].cook_id);
+        } else if (orders[slot].state == 1 && kitchen_pass_queued(&cook->shop.pass)) {
+            run_cook(orders[slot].cook_id);
+        }
+    }
+}
+
+static void handle(const SimEvent* event) {
+    char log_msg[256];
+    switch (event->type) {
+        case EVENT_ARRIVAL:
+            place(event->id);
+            arrived++;
+            if (cancelling[event->id]) {
+                schedule(now + config->cancel_after, EVENT_CANCEL, event->id);
+            }
+            if (arrived < config->orders) {
+                double gap = config->arrival_rate > 0 ? -log(1.0 - rand() / (RAND_MAX + 1.0)) / config->arrival_rate : 0.0;
+                schedule(now + gap, EVENT_ARRIVAL, arrived);
+            }
+            wake_idle_cooks();
+            break;
+
+        case EVENT_COOK: {
+            SimCook* cook = &cooks[event->id];
+            if (cook->timer != event->seq) {
+                break; // Cut short by a cancel
+            }
+            cook->timer = -1;
+            cook->shop.slept = now - cook->slept_from;
+            run_cook(event->id);
+            break;
+        }
+
+        case EVENT_GRANTED:
+            run_cook(event->id);
+            break;
+
+        case EVENT_DELIVERED: {
+            SimCourier* courier = &couriers[event->id];
+            int slot = courier->bag.slots[courier->stop];
+            Order* order = &orders[slot];
+            courier->delivery_count++;
+            delivered++;
+            finished[slot] = 1;
+            stats.latency_total += now - order->cooked_at;
+            deadline_record(&deadline_stats, now, order->deadline);
+            snprintf(log_msg, sizeof(log_msg), "> Delivery Person %d delivered order %d to location (%d, %d) and Thanks Cook %d and Moto %d", event->id, order->order_id, order->customer_x, order->customer_y, order->cook_id, event->id);
+            logger_write(log_msg);
+            next_leg(event->id);
+            break;
+        }
+
+        case EVENT_RETURNED: {
+            SimCourier* courier = &couriers[event->id];
+            stats.busy_total += now - courier->departed;
+            courier->bag.count = 0;
+            idle_couriers[(idle_courier_head + idle_courier_count++) % config->couriers] = event->id;
+            dispatch_couriers();
+            break;
+        }
+
+        case EVENT_CANCEL:
+            cancel(event->id);
+            break;
+    }
+}
+
+static void print_report(double wall, long events) {
+    int max_cook = 0, max_courier = 0;
+    for (int i = 1; i < config->cooks; ++i) {
+        if (cooks[i].work_count > cooks[max_cook].work_count) {
+            max_cook = i;
+        }
+    }
+    for (int i = 1; i < config->couriers; ++i) {
+        if (couriers[i].delivery_count > couriers[max_courier].delivery_count) {
+            max_courier = i;
+        }
+    }
+
+    printf("> Most hardworking cook: Cook %d with %d orders prepared and cooked\n", max_cook, cooks[max_cook].work_count);
+    printf("> Most hardworking delivery person: Delivery Person %d with %d deliveries\n", max_courier, couriers[max_courier].delivery_count);
+    printf("> Served %d orders in %.3f seconds (%.2f orders/sec)\n", delivered, now, now > 0 ? delivered / now : 0.0);
+    CookTimeStats cook_stats;
+    cooktime_get_stats(&cook_stats);
+    printf("> Cook time provider %s: %ld lookups, %ld computations, %.3f seconds computing\n", cooktime_mode_name(config->cooktime_mode), cook_stats.lookups, cook_stats.computations, cook_stats.compute_total);
+    cook_pool_print_stats();
+    kitchen_print_stats();
+    printf("> Delivery (%s): %d orders in %ld tours, avg tour %.1f, avg latency %.3f s, courier utilization %.1f%%\n",
+           config->dispatch_mode == DISPATCH_ROUTE ? "route" : "greedy", delivered, stats.tours,
+           stats.tours > 0 ? stats.tour_length_total / stats.tours : 0.0,
+           delivered > 0 ? stats.latency_total / delivered : 0.0,
+           now > 0 ? 100.0 * stats.busy_total / (now * config->couriers) : 0.0);
+    shop_print_cancel_stats(&cancel_stats);
+    deadline_print(&config->deadline, &deadline_stats);
+    printf("> Simulated %.3f seconds in %.3f seconds wall clock, %ld events (%.0fx)\n", now, wall, events, wall > 0 ? now / wall : 0.0);
+}
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int sim_run(const SimConfig* sim_config, SimResult* result) {
+    config = sim_config;
+    if (config->cooks < 1 || config->couriers < 1 || config->speed < 1 || config->orders < 1 || config->cancel_share < 0 ||
+        config->cancel_after < 0) {
+        fprintf(stderr, "Invalid simulation configuration\n");
+        return -1;
+    }
+    // Every run starts from an empty shop, so one process can compare runs
+    heap_size = 0;
+    event_seq = 0;
+    now = 0.0;
+    arrived = active_orders = delivered = dropped = next_waker = 0;
+    idle_courier_head = idle_courier_count = 0;
+    init_index_queue(&cooked);
+    memset(&stats, 0, sizeof(stats));
+    memset(&deadline_stats, 0, sizeof(deadline_stats));
+    memset(&cancel_stats, 0, sizeof(cancel_stats));
+    memset(&session, 0, sizeof(session));
+    session.p = config->p;
+    session.q = config->q;
+
+    ShopConfig shop_config = { config->rows, config->cols, config->deadline.mode, config->dispatch_mode, config->speed };
+    shop_init(&shop_config);
+    kitchen_set_clock(sim_clock);
+    if (kitchen_init(config->apparatus, config->oven_slots, config->oven_doors) < 0) {
+        kitchen_set_clock(NULL);
+        return -1;
+    }
+    if (cook_pool_init(config->cooks, config->cook_placement, config->deadline.mode) < 0) {
+        kitchen_destroy();
+        kitchen_set_clock(NULL);
+        return -1;
+    }
+
+    orders = calloc(config->orders, sizeof(Order));
+    finished = calloc(config->orders, 1);
+    cancelling = calloc(config->orders, 1);
+    cooks = calloc(config->cooks, sizeof(SimCook));
+    couriers = calloc(config->couriers, sizeof(SimCourier));
+    idle_couriers = malloc(config->couriers * sizeof(int));
+    if (orders == NULL || finished == NULL || cancelling == NULL || cooks == NULL || couriers == NULL || idle_couriers == NULL ||
+        spatial_init(&session.cooked, config->p, config->q) < 0) {
+        perror("Failed to allocate simulation");
+        return -1;
+    }
+
+    srand(config->seed);
+    for (int i = 0; i < config->orders; ++i) {
+        orders[i].order_id = i + 1;
+        orders[i].customer_x = rand() % config->p;
+        orders[i].customer_y = rand() % config->q;
+        orders[i].deadline = config->express_share > 0 && rand() < config->express_share * RAND_MAX ? config->express_promise : 0.0;
+        cancelling[i] = config->cancel_share > 0 && rand() < config->cancel_share * RAND_MAX;
+        orders[i].cook_id = -1;
+        orders[i].session = &session;
+        orders[i].next = orders[i].prev = -1;
+        atomic_init(&orders[i].cancelled, 0);
+    }
+    for (int i = 0; i < config->cooks; ++i) {
+        shop_cook_init(&cooks[i].shop, i, kitchen_granted);
+        cooks[i].idle = 1;
+        cooks[i].timer = -1;
+    }
+    for (int i = 0; i < config->couriers; ++i) {
+        idle_couriers[idle_courier_count++] = i;
+    }
+
+    double wall_start = wall_seconds();
+    schedule(0.0, EVENT_ARRIVAL, 0);
+    long events = 0;
+    while (heap_size > 0) {
+        SimEvent event = next_event();
+        now = event.time;
+        handle(&event);
+        events++;
+    }
+    double wall = wall_seconds() - wall_start;
+    if (result != NULL) {
+        result->seconds = now;
+        result->delivered = delivered;
+        result->cancelled = dropped;
+        result->deadlines = deadline_stats;
+    }
+    if (!config->quiet) {
+        print_report(wall, events);
+    }
+
+    for (int i = 0; i < config->cooks; ++i) {
+        shop_cook_destroy(&cooks[i].shop);
+    }
+    cook_pool_destroy();
+    kitchen_destroy();
+    kitchen_set_clock(NULL);
+    spatial_free(&session.cooked);
+    free(heap);
+    heap = NULL;
+    heap_capacity = 0;
+    free(orders);
+    free(finished);
+    free(cancelling);
+    free(cooks);
+    free(couriers);
+    free(idle_couriers);
+    return 0;
+}
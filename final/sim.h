@@ -0,0 +1,40 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "deadline.h"
+
+#define SIM_DEFAULT_MAP 100 // p and q when -m is not given
+
+typedef struct {
+    int cooks;
+    int couriers;
+    int speed;          // Map units per second, like k
+    int orders;         // Orders to simulate
+    double arrival_rate; // Orders per second, 0 = all at time zero
+    int p, q;
+    int oven_slots;
+    int apparatus;
+    int oven_doors;     // KITCHEN_ONE_DOOR | KITCHEN_TWO_DOOR
+    int dispatch_mode;  // DISPATCH_GREEDY | DISPATCH_ROUTE
+    int cook_placement; // COOKPOOL_ROUND_ROBIN | COOKPOOL_LOCALITY
+    int rows, cols;     // Cook time matrix
+    int cooktime_mode;
+    unsigned int seed;
+    DeadlineConfig deadline; // Promises and the cook and oven order
+    double express_share;    // Orders that come with a client promise instead of a computed one
+    double express_promise;  // Seconds
+    double cancel_share;     // Orders whose client cancels them cancel_after seconds after they arrive
+    double cancel_after;
+    int quiet;          // No report, the caller reads SimResult
+} SimConfig;
+
+typedef struct {
+    double seconds;     // Simulated time to the last event
+    int delivered;
+    int cancelled;
+    DeadlineStats deadlines;
+} SimResult;
+
+int sim_run(const SimConfig* config, SimResult* result); // result may be NULL
+
+#endif
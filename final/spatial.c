@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "spatial.h"
+
+static int* alloc_heads(int dim) {
+    int* heads = malloc((size_t)dim * dim * sizeof(int));
+    if (heads != NULL) {
+        for (int i = 0; i < dim * dim; ++i) {
+            heads[i] = -1;
+        }
+    }
+    return heads;
+}
+
+static void set_dim(SpatialGrid* grid, int dim) {
+    grid->dim = dim;
+    grid->cell_width = (grid->width + dim - 1) / dim;
+    grid->cell_height = (grid->height + dim - 1) / dim;
+}
+
+int spatial_init(SpatialGrid* grid, int width, int height) {
+    grid->width = width > 0 ? width : 1;
+    grid->height = height > 0 ? height : 1;
+    set_dim(grid, SPATIAL_MIN_DIM);
+    grid->count = 0;
+    grid->heads = alloc_heads(grid->dim);
+    if (grid->heads == NULL) {
+        perror("Failed to allocate spatial grid");
+        return -1;
+    }
+    return 0;
+}
+
+void spatial_free(SpatialGrid* grid) {
+    free(grid->heads);
+    grid->heads = NULL;
+    grid->count = 0;
+}
+
+static int clamp_cell(int value, int cell_size, int dim) {
+    int cell = value / cell_size;
+    if (cell < 0) {
+        return 0;
+    }
+    return cell < dim ? cell : dim - 1;
+}
+
+static int cell_of(const SpatialGrid* grid, int x, int y) {
+    return clamp_cell(y, grid->cell_height, grid->dim) * grid->dim + clamp_cell(x, grid->cell_width, grid->dim);
+}
+
+static void link_slot(SpatialGrid* grid, Order* orders, int slot) {
+    int cell = cell_of(grid, orders[slot].customer_x, orders[slot].customer_y);
+    orders[slot].grid_prev = -1;
+    orders[slot].grid_next = grid->heads[cell];
+    if (grid->heads[cell] != -1) {
+        orders[grid->heads[cell]].grid_prev = slot;
+    }
+    grid->heads[cell] = slot;
+}
+
+// Relinks every order into a grid of dim x dim cells. Growing at
+// SPATIAL_MAX_LOAD per cell and shrinking below a quarter per cell keeps
+// this amortized O(1) per insert or remove.
+static void rebuild(SpatialGrid* grid, Order* orders, int dim) {
+    int* heads = alloc_heads(dim);
+    if (heads == NULL) {
+        return; // Keep the current grid, queries just scan more
+    }
+    int* old_heads = grid->heads;
+    int old_cells = grid->dim * grid->dim;
+    grid->heads = heads;
+    set_dim(grid, dim);
+    for (int cell = 0; cell < old_cells; ++cell) {
+        int slot = old_heads[cell];
+        while (slot != -1) {
+            int next = orders[slot].grid_next;
+            link_slot(grid, orders, slot);
+            slot = next;
+        }
+    }
+    free(old_heads);
+}
+
+void spatial_insert(SpatialGrid* grid, Order* orders, int slot) {
+    if (grid->count >= grid->dim * grid->dim * SPATIAL_MAX_LOAD && grid->dim < SPATIAL_MAX_DIM &&
+        (grid->cell_width > 1 || grid->cell_height > 1)) {
+        rebuild(grid, orders, grid->dim * 2);
+    }
+    link_slot(grid, orders, slot);
+    grid->count++;
+}
+
+void spatial_remove(SpatialGrid* grid, Order* orders, int slot) {
+    if (orders[slot].grid_prev != -1) {
+        orders[orders[slot].grid_prev].grid_next = orders[slot].grid_next;
+    } else {
+        grid->heads[cell_of(grid, orders[slot].customer_x, orders[slot].customer_y)] = orders[slot].grid_next;
+    }
+    if (orders[slot].grid_next != -1) {
+        orders[orders[slot].grid_next].grid_prev = orders[slot].grid_prev;
+    }
+    grid->count--;
+    // A sparse fine grid would make queries walk many empty cells
+    if (grid->dim > SPATIAL_MIN_DIM && grid->count < grid->dim * grid->dim / 4) {
+        rebuild(grid, orders, grid->dim / 2);
+    }
+}
+
+// Scans rings of cells around (x, y). Anything in ring r + 1 is at least
+// r cells away, so the search stops once the k-th best match is that close.
+// Writes up to k slots to out, nearest first, and returns how many.
+int spatial_k_nearest(const SpatialGrid* grid, const Order* orders, int x, int y, int k, int* out) {
+    long distances[SPATIAL_MAX_K];
+    int found = 0;
+    if (k > SPATIAL_MAX_K) {
+        k = SPATIAL_MAX_K;
+    }
+    if (grid->count == 0 || k <= 0) {
+        return 0;
+    }
+
+    int dim = grid->dim;
+    int cx = clamp_cell(x, grid->cell_width, dim);
+    int cy = clamp_cell(y, grid->cell_height, dim);
+    int cell_min = grid->cell_width < grid->cell_height ? grid->cell_width : grid->cell_height;
+
+    for (int r = 0; r < dim; ++r) {
+        for (int gy = cy - r; gy <= cy + r; ++gy) {
+            if (gy < 0 || gy >= dim) {
+                continue;
+            }
+            int step = (gy == cy - r || gy == cy + r || r == 0) ? 1 : 2 * r;
+            for (int gx = cx - r; gx <= cx + r; gx += step) {
+                if (gx < 0 || gx >= dim) {
+                    continue;
+                }
+                for (int slot = grid->heads[gy * dim + gx]; slot != -1; slot = orders[slot].grid_next) {
+                    long dx = orders[slot].customer_x - x;
+                    long dy = orders[slot].customer_y - y;
+                    long distance = dx * dx + dy * dy;
+                    if (found == k && distance >= distances[k - 1]) {
+                        continue;
+                    }
+                    // Insertion into the sorted best-k list
+                    int i = found < k ? found++ : k - 1;
+                    while (i > 0 && distances[i - 1] > distance) {
+                        distances[i] = distances[i - 1];
+                        out[i] = out[i - 1];
+                        i--;
+                    }
+                    distances[i] = distance;
+                    out[i] = slot;
+                }
+            }
+        }
+        long reach = (long)r * cell_min;
+        if (found == k && distances[k - 1] <= reach * reach) {
+            break;
+        }
+    }
+    return found;
+}
+
+int spatial_nearest(const SpatialGrid* grid, const Order* orders, int x, int y) {
+    int slot;
+    return spatial_k_nearest(grid, orders, x, y, 1, &slot) == 1 ? slot : -1;
+}
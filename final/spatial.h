@@ -0,0 +1,32 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include "pideshop.h"
+
+#define SPATIAL_MIN_DIM 16   // Cells per axis of a new grid
+#define SPATIAL_MAX_DIM 1024
+#define SPATIAL_MAX_LOAD 4   // Mean orders per cell before the grid doubles
+#define SPATIAL_MAX_K 64     // Largest k for spatial_k_nearest
+
+// Uniform grid over one map. Each cell is a doubly linked list of order
+// slots threaded through Order.grid_prev / Order.grid_next, so remove is
+// O(1). The grid doubles its resolution as the backlog grows and halves it
+// as it drains, which keeps the cells a query visits short.
+typedef struct {
+    int width;
+    int height;
+    int dim;
+    int cell_width;
+    int cell_height;
+    int* heads; // dim^2 slots, -1 = empty cell
+    int count;
+} SpatialGrid;
+
+int spatial_init(SpatialGrid* grid, int width, int height);
+void spatial_free(SpatialGrid* grid);
+void spatial_insert(SpatialGrid* grid, Order* orders, int slot);
+void spatial_remove(SpatialGrid* grid, Order* orders, int slot);
+int spatial_nearest(const SpatialGrid* grid, const Order* orders, int x, int y);
+int spatial_k_nearest(const SpatialGrid* grid, const Order* orders, int x, int y, int k, int* out);
+
+#endif
@@ -0,0 +1,105 @@
+// Courier dispatch scaling benchmark: with N cooked orders pending, take the
+// BAG_CAPACITY orders nearest to a random point and replace them with new
+// ones, so the backlog stays at N. Compares the grid with a linear scan.
+//   ./spatial_bench [map_size] [operations]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "spatial.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Reference: k nearest by scanning every pending order
+static int linear_k_nearest(const Order* orders, const char* pending, int n, int x, int y, int k, int* out) {
+    long distances[SPATIAL_MAX_K];
+    int found = 0;
+    for (int slot = 0; slot < n; ++slot) {
+        if (!pending[slot]) {
+            continue;
+        }
+        long dx = orders[slot].customer_x - x;
+        long dy = orders[slot].customer_y - y;
+        long distance = dx * dx + dy * dy;
+        if (found == k && distance >= distances[k - 1]) {
+            continue;
+        }
+        int i = found < k ? found++ : k - 1;
+        while (i > 0 && distances[i - 1] > distance) {
+            distances[i] = distances[i - 1];
+            out[i] = out[i - 1];
+            i--;
+        }
+        distances[i] = distance;
+        out[i] = slot;
+    }
+    return found;
+}
+
+static void place(Order* orders, int slot, int map_size) {
+    orders[slot].customer_x = rand() % map_size;
+    orders[slot].customer_y = rand() % map_size;
+}
+
+static double run(int n, int map_size, int operations, int use_grid, long* checksum) {
+    Order* orders = malloc(n * sizeof(Order));
+    char* pending = calloc(n, 1);
+    SpatialGrid grid;
+    if (orders == NULL || pending == NULL || spatial_init(&grid, map_size, map_size) < 0) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    srand(42);
+    for (int slot = 0; slot < n; ++slot) {
+        place(orders, slot, map_size);
+        pending[slot] = 1;
+        spatial_insert(&grid, orders, slot);
+    }
+
+    int taken[BAG_CAPACITY];
+    double start = now_seconds();
+    for (int op = 0; op < operations; ++op) {
+        int x = rand() % map_size;
+        int y = rand() % map_size;
+        int count = use_grid ? spatial_k_nearest(&grid, orders, x, y, BAG_CAPACITY, taken)
+                             : linear_k_nearest(orders, pending, n, x, y, BAG_CAPACITY, taken);
+        for (int i = 0; i < count; ++i) {
+            // Ties may pick different slots, the distances must agree
+            long dx = orders[taken[i]].customer_x - x;
+            long dy = orders[taken[i]].customer_y - y;
+            *checksum += dx * dx + dy * dy;
+            spatial_remove(&grid, orders, taken[i]);
+            place(orders, taken[i], map_size);
+            spatial_insert(&grid, orders, taken[i]);
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    spatial_free(&grid);
+    free(orders);
+    free(pending);
+    return elapsed / operations;
+}
+
+int main(int argc, char* argv[]) {
+    int map_size = argc > 1 ? atoi(argv[1]) : 10000;
+    int operations = argc > 2 ? atoi(argv[2]) : 20000;
+
+    printf("map %dx%d, k = %d, %d dispatches per size\n", map_size, map_size, BAG_CAPACITY, operations);
+    printf("%8s | %12s | %12s | %s\n", "pending", "grid ns/op", "linear ns/op", "same distances");
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        long grid_checksum = 0, linear_checksum = 0;
+        double grid_time = run(n, map_size, operations, 1, &grid_checksum);
+        // The linear scan is O(n) per dispatch, keep its total work bounded
+        int linear_operations = operations < 2000 ? operations : 2000;
+        long grid_prefix = 0;
+        run(n, map_size, linear_operations, 1, &grid_prefix);
+        double linear_time = run(n, map_size, linear_operations, 0, &linear_checksum);
+        printf("%8d | %12.0f | %12.0f | %s\n", n, grid_time * 1e9, linear_time * 1e9,
+               grid_prefix == linear_checksum ? "yes" : "no");
+    }
+    return 0;
+}
@@ -0,0 +1,249 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include "protocol.h"
+#include "statusbus.h"
+
+#define STATUS_HASH_SIZE (2 * STATUS_MAX_PENDING)
+
+typedef struct {
+    int fd;
+    pid_t pid; // 0 follows every order
+} Subscriber;
+
+// Events of the current window. A (pid, order_id) pair appears once:
+// a newer state overwrites the older one, so slow readers see the latest.
+static StatusEvent* pending = NULL;
+static StatusEvent* sending = NULL; // Window being sent, swapped with pending
+static int pending_count = 0;
+static int* slots = NULL; // Open addressing, index + 1 into pending, 0 = empty
+static unsigned int* slot_of = NULL; // Slot each pending event sits in, cleared on swap
+static pthread_mutex_t bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bus_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t space_cond = PTHREAD_COND_INITIALIZER;
+static int bus_running = 0;
+static pthread_t publisher_thread;
+
+static Subscriber subscribers[STATUS_MAX_SUBSCRIBERS];
+static int subscriber_count = 0;
+static pthread_mutex_t subscriber_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int hash_event(pid_t pid, int order_id) {
+    unsigned int h = (unsigned int)pid * 2654435761u ^ (unsigned int)order_id * 40503u;
+    return h & (STATUS_HASH_SIZE - 1);
+}
+
+void status_bus_publish(pid_t pid, int order_id, int state) {
+    pthread_mutex_lock(&bus_mutex);
+    if (!bus_running) {
+        pthread_mutex_unlock(&bus_mutex);
+        return;
+    }
+
+    unsigned int h = hash_event(pid, order_id);
+    while (slots[h] != 0) {
+        StatusEvent* event = &pending[slots[h] - 1];
+        if (event->pid == pid && event->order_id == order_id) {
+            event->state = state; // Coalesce with the earlier event
+            pthread_mutex_unlock(&bus_mutex);
+            return;
+        }
+        h = (h + 1) & (STATUS_HASH_SIZE - 1);
+    }
+
+    while (pending_count == STATUS_MAX_PENDING && bus_running) {
+        pthread_cond_signal(&bus_cond);
+        pthread_cond_wait(&space_cond, &bus_mutex);
+        h = hash_event(pid, order_id); // Table was cleared meanwhile
+    }
+    if (!bus_running) {
+        pthread_mutex_unlock(&bus_mutex);
+        return;
+    }
+
+    pending[pending_count].pid = pid;
+    pending[pending_count].order_id = order_id;
+    pending[pending_count].state = state;
+    slot_of[pending_count] = h;
+    slots[h] = ++pending_count;
+    pthread_mutex_unlock(&bus_mutex);
+}
+
+static void remove_subscriber(int index) {
+    close(subscribers[index].fd);
+    subscribers[index] = subscribers[--subscriber_count];
+}
+
+// A subscriber filtered to one PID gets nothing once that client is done,
+// so send never fails for it; its hang-up is seen here instead
+static void drop_closed_subscribers(void) {
+    struct pollfd fds[STATUS_MAX_SUBSCRIBERS];
+    for (int i = 0; i < subscriber_count; ++i) {
+        fds[i].fd = subscribers[i].fd;
+        fds[i].events = POLLRDHUP;
+        fds[i].revents = 0;
+    }
+    if (poll(fds, subscriber_count, 0) <= 0) {
+        return;
+    }
+    // remove_subscriber moves the last one into i, so walk backwards
+    for (int i = subscriber_count - 1; i >= 0; --i) {
+        if (fds[i].revents & (POLLRDHUP | POLLHUP | POLLERR | POLLNVAL)) {
+            remove_subscriber(i);
+        }
+    }
+}
+
+// One subscriber, one window: frames of up to STATUS_MAX_EVENTS events
+static int send_window(Subscriber* subscriber, const StatusEvent* events, int count, unsigned char* frame) {
+    int index = 0;
+    while (index < count) {
+        size_t offset = FRAME_HEADER_SIZE + STATUS_HEADER_SIZE;
+        uint32_t in_frame = 0;
+        for (; index < count && in_frame < STATUS_MAX_EVENTS; ++index) {
+            if (subscriber->pid != 0 && events[index].pid != subscriber->pid) {
+                continue;
+            }
+            put_u32(frame + offset, (uint32_t)events[index].pid);
+            put_u32(frame + offset + 4, (uint32_t)events[index].order_id);
+            put_u32(frame + offset + 8, (uint32_t)events[index].state);
+            offset += STATUS_ENTRY_SIZE;
+            in_frame++;
+        }
+        if (in_frame == 0) {
+            break;
+        }
+        put_frame_header(frame, FRAME_STATUS_BATCH, (uint32_t)(offset - FRAME_HEADER_SIZE));
+        put_u32(frame + FRAME_HEADER_SIZE, in_frame);
+
+        // A subscriber that cannot keep up is dropped instead of stalling everyone
+        size_t sent_total = 0;
+        while (sent_total < offset) {
+            ssize_t sent = send(subscriber->fd, frame + sent_total, offset - sent_total, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+            sent_total += (size_t)sent;
+        }
+    }
+    return 0;
+}
+
+static void* publisher_function(void* arg) {
+    (void)arg;
+    unsigned char* frame = malloc(FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD);
+    if (frame == NULL) {
+        perror("Failed to allocate status frame");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&bus_mutex);
+    while (bus_running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += STATUS_FLUSH_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&bus_cond, &bus_mutex, &deadline);
+        if (pending_count == 0) {
+            continue;
+        }
+
+        // Swap windows so publishers keep going while we send. Every used
+        // slot belongs to one event of the window, so the table ends empty.
+        StatusEvent* window = pending;
+        int count = pending_count;
+        for (int i = 0; i < count; ++i) {
+            slots[slot_of[i]] = 0;
+        }
+        pending = sending;
+        sending = window;
+        pending_count = 0;
+        pthread_cond_broadcast(&space_cond);
+        pthread_mutex_unlock(&bus_mutex);
+
+        pthread_mutex_lock(&subscriber_mutex);
+        drop_closed_subscribers();
+        for (int i = 0; i < subscriber_count; ) {
+            if (send_window(&subscribers[i], window, count, frame) < 0) {
+                remove_subscriber(i);
+            } else {
+                i++;
+            }
+        }
+        pthread_mutex_unlock(&subscriber_mutex);
+
+        pthread_mutex_lock(&bus_mutex);
+    }
+    pthread_mutex_unlock(&bus_mutex);
+
+    free(frame);
+    return NULL;
+}
+
+int status_bus_start(void) {
+    pending = malloc(STATUS_MAX_PENDING * sizeof(StatusEvent));
+    sending = malloc(STATUS_MAX_PENDING * sizeof(StatusEvent));
+    slots = calloc(STATUS_HASH_SIZE, sizeof(int));
+    slot_of = malloc(STATUS_MAX_PENDING * sizeof(unsigned int));
+    if (pending == NULL || sending == NULL || slots == NULL || slot_of == NULL) {
+        perror("Failed to allocate status bus");
+        return -1;
+    }
+    bus_running = 1;
+    if (pthread_create(&publisher_thread, NULL, publisher_function, NULL) != 0) {
+        perror("pthread_create");
+        bus_running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+// Takes ownership of fd
+int status_bus_subscribe(int fd, pid_t pid) {
+    pthread_mutex_lock(&subscriber_mutex);
+    if (subscriber_count == STATUS_MAX_SUBSCRIBERS) {
+        drop_closed_subscribers();
+    }
+    if (subscriber_count == STATUS_MAX_SUBSCRIBERS) {
+        pthread_mutex_unlock(&subscriber_mutex);
+        close(fd);
+        return -1;
+    }
+    subscribers[subscriber_count].fd = fd;
+    subscribers[subscriber_count].pid = pid;
+    subscriber_count++;
+    pthread_mutex_unlock(&subscriber_mutex);
+    return 0;
+}
+
+void status_bus_stop(void) {
+    pthread_mutex_lock(&bus_mutex);
+    if (!bus_running) {
+        pthread_mutex_unlock(&bus_mutex);
+        return;
+    }
+    bus_running = 0;
+    pthread_cond_broadcast(&bus_cond);
+    pthread_cond_broadcast(&space_cond);
+    pthread_mutex_unlock(&bus_mutex);
+    pthread_join(publisher_thread, NULL);
+
+    pthread_mutex_lock(&subscriber_mutex);
+    while (subscriber_count > 0) {
+        remove_subscriber(0);
+    }
+    pthread_mutex_unlock(&subscriber_mutex);
+}
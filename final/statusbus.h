@@ -0,0 +1,21 @@
+#ifndef STATUSBUS_H
+#define STATUSBUS_H
+
+#include <sys/types.h>
+
+#define STATUS_FLUSH_MS 50         // Publisher batching window
+#define STATUS_MAX_PENDING 65536   // Distinct orders per window, power of two
+#define STATUS_MAX_SUBSCRIBERS 256
+
+typedef struct {
+    pid_t pid;
+    int order_id;
+    int state;
+} StatusEvent;
+
+int status_bus_start(void);
+void status_bus_publish(pid_t pid, int order_id, int state);
+int status_bus_subscribe(int fd, pid_t pid);
+void status_bus_stop(void);
+
+#endif
@@ -0,0 +1,42 @@
+#!/bin/bash
+# Overload stress test: the same open-loop load at about twice what the
+# kitchen can serve, once taking everything and once with admission
+# control. Without it the backlog and p99 grow for as long as the run
+# lasts; with it p99 of the admitted orders stays bounded and the excess
+# is turned away (and shed by the generator after its retries).
+#   ./stress.sh [rate] [orders] [p99LimitMs]
+RATE=${1:-1300}
+ORDERS=${2:-4000}
+LIMIT_MS=${3:-1500}
+SERVER_ARGS="2 2 1000" # cooks, couriers, k: about 600 orders/s
+
+run() {
+    local port=$((20000 + RANDOM % 20000))
+    ./PideShop 127.0.0.1 $port $SERVER_ARGS "$@" > stress_server.log 2>&1 &
+    local server=$!
+    sleep 0.3
+    timeout 300 ./HungryVeryMuch 127.0.0.1 $port $ORDERS 10 10 -r $RATE -t 2 | grep -v "^> PID" | tee stress_client.log
+    kill $server
+    wait $server 2>/dev/null
+    grep "Admission" stress_server.log | tail -1
+}
+
+p99() {
+    awk '/from schedule/ { print $9 }' stress_client.log
+}
+
+echo "== no admission control"
+run
+open_p99=$(p99)
+echo "== -X reject -H 200"
+run -X reject -H 200
+admitted_p99=$(p99)
+rm -f stress_server.log stress_client.log
+
+echo "p99 from schedule: $open_p99 ms without, $admitted_p99 ms with admission control, limit $LIMIT_MS ms"
+if awk -v p="$admitted_p99" -v l="$LIMIT_MS" 'BEGIN { exit !(p != "" && p <= l) }'; then
+    echo "ok"
+else
+    echo "MISSED"
+    exit 1
+fi
@@ -0,0 +1,271 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "topology.h"
+
+#define SYSFS_CPU "/sys/devices/system/cpu"
+#define MPOL_PREFERRED 1 // From <numaif.h>, kept here so libnuma is not needed
+
+static CpuInfo cpus[TOPOLOGY_MAX_CPUS];
+static int cpu_count = 0;
+static int node_count = 1;
+static int compact_order[TOPOLOGY_MAX_CPUS]; // Indices into cpus
+static int scatter_order[TOPOLOGY_MAX_CPUS];
+
+static int read_int(const char* path, int fallback) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return fallback;
+    }
+    int value;
+    if (fscanf(file, "%d", &value) != 1) {
+        value = fallback;
+    }
+    fclose(file);
+    return value;
+}
+
+// The CPU directory has a nodeN link on NUMA kernels
+static int read_node(int cpu) {
+    char path[128];
+    snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d", cpu);
+    DIR* dir = opendir(path);
+    if (dir == NULL) {
+        return 0;
+    }
+    int node = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+// "0-3,8-11" style list
+static int parse_cpu_list(const char* list, int* out, int max) {
+    int count = 0;
+    const char* p = list;
+    while (*p != '\0' && *p != '\n' && count < max) {
+        char* end;
+        int first = (int)strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        int last = first;
+        if (*end == '-') {
+            p = end + 1;
+            last = (int)strtol(p, &end, 10);
+        }
+        for (int cpu = first; cpu <= last && count < max; ++cpu) {
+            out[count++] = cpu;
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+static int compare_compact(const void* a, const void* b) {
+    const CpuInfo* x = &cpus[*(const int*)a];
+    const CpuInfo* y = &cpus[*(const int*)b];
+    if (x->node != y->node) return x->node - y->node;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->core != y->core) return x->core - y->core;
+    return x->sibling - y->sibling;
+}
+
+static int compare_scatter(const void* a, const void* b) {
+    const CpuInfo* x = &cpus[*(const int*)a];
+    const CpuInfo* y = &cpus[*(const int*)b];
+    if (x->sibling != y->sibling) return x->sibling - y->sibling;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->core != y->core) return x->core - y->core;
+    return x->node - y->node;
+}
+
+int topology_init(void) {
+    int online[TOPOLOGY_MAX_CPUS];
+    char list[4096] = "";
+    FILE* file = fopen(SYSFS_CPU "/online", "r");
+    if (file != NULL) {
+        if (fgets(list, sizeof(list), file) == NULL) {
+            list[0] = '\0';
+        }
+        fclose(file);
+    }
+    int count = parse_cpu_list(list, online, TOPOLOGY_MAX_CPUS);
+    if (count == 0) {
+        // No sysfs: plain CPU numbers, one core each
+        count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (count < 1) {
+            return -1;
+        }
+        count = count < TOPOLOGY_MAX_CPUS ? count : TOPOLOGY_MAX_CPUS;
+        for (int i = 0; i < count; ++i) {
+            online[i] = i;
+        }
+    }
+
+    // Only CPUs this process may run on (taskset, cgroup cpusets)
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        int kept = 0;
+        for (int i = 0; i < count; ++i) {
+            if (online[i] < CPU_SETSIZE && CPU_ISSET(online[i], &allowed)) {
+                online[kept++] = online[i];
+            }
+        }
+        count = kept > 0 ? kept : count;
+    }
+
+    char path[128];
+    node_count = 1;
+    for (int i = 0; i < count; ++i) {
+        CpuInfo* info = &cpus[i];
+        info->cpu = online[i];
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/core_id", info->cpu);
+        info->core = read_int(path, info->cpu);
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/physical_package_id", info->cpu);
+        info->package = read_int(path, 0);
+        info->node = read_node(info->cpu);
+        if (info->node + 1 > node_count) {
+            node_count = info->node + 1;
+        }
+        info->sibling = 0;
+        for (int j = 0; j < i; ++j) {
+            if (cpus[j].core == info->core && cpus[j].package == info->package) {
+                info->sibling++;
+            }
+        }
+        compact_order[i] = scatter_order[i] = i;
+    }
+    cpu_count = count;
+    qsort(compact_order, count, sizeof(int), compare_compact);
+
+    // Within each sibling rank, alternate nodes so consecutive workers spread out
+    qsort(scatter_order, count, sizeof(int), compare_scatter);
+    int* spread = malloc(count * sizeof(int));
+    if (spread != NULL) {
+        int filled = 0;
+        for (int start = 0; start < count;) {
+            int end = start;
+            while (end < count && cpus[scatter_order[end]].sibling == cpus[scatter_order[start]].sibling) {
+                end++;
+            }
+            for (int round = 0; filled < end; ++round) {
+                for (int node = 0; node < node_count; ++node) {
+                    int seen = 0;
+                    for (int i = start; i < end; ++i) {
+                        if (cpus[scatter_order[i]].node == node && seen++ == round) {
+                            spread[filled++] = scatter_order[i];
+                            break;
+                        }
+                    }
+                }
+            }
+            start = end;
+        }
+        memcpy(scatter_order, spread, count * sizeof(int));
+        free(spread);
+    }
+    return cpu_count;
+}
+
+int topology_parse_affinity(const char* name) {
+    if (strcmp(name, "none") == 0) {
+        return AFFINITY_NONE;
+    }
+    if (strcmp(name, "compact") == 0) {
+        return AFFINITY_COMPACT;
+    }
+    if (strcmp(name, "scatter") == 0) {
+        return AFFINITY_SCATTER;
+    }
+    return -1;
+}
+
+const char* topology_affinity_name(int mode) {
+    static const char* names[] = { "none", "compact", "scatter" };
+    return mode >= 0 && mode <= AFFINITY_SCATTER ? names[mode] : "?";
+}
+
+// More workers than CPUs wrap around
+int topology_cpu_for(int mode, int index) {
+    if (mode == AFFINITY_NONE || cpu_count == 0) {
+        return -1;
+    }
+    const int* order = mode == AFFINITY_COMPACT ? compact_order : scatter_order;
+    return cpus[order[index % cpu_count]].cpu;
+}
+
+int topology_node_of(int cpu) {
+    for (int i = 0; i < cpu_count; ++i) {
+        if (cpus[i].cpu == cpu) {
+            return cpus[i].node;
+        }
+    }
+    return 0;
+}
+
+int topology_node_count(void) {
+    return node_count;
+}
+
+void topology_print(void) {
+    int cores = 0, packages = 0;
+    for (int i = 0; i < cpu_count; ++i) {
+        cores += cpus[i].sibling == 0;
+        packages = cpus[i].package + 1 > packages ? cpus[i].package + 1 : packages;
+    }
+    printf("> CPU topology: %d CPUs, %d cores, %d packages, %d NUMA nodes\n", cpu_count, cores, packages, node_count);
+}
+
+int topology_create_thread(pthread_t* thread, int cpu, void* (*function)(void*), void* arg) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    }
+    int rc = pthread_create(thread, &attr, function, arg);
+    pthread_attr_destroy(&attr);
+    if (rc != 0 && cpu >= 0) {
+        rc = pthread_create(thread, NULL, function, arg); // CPU went away, run unpinned
+    }
+    return rc;
+}
+
+void* topology_alloc_local(size_t size, int node) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size = (size + page - 1) & ~(page - 1);
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        perror("Failed to allocate thread state");
+        return NULL;
+    }
+    if (node_count > 1 && node < (int)sizeof(unsigned long) * 8) {
+        // Preferred, not bound: a full node falls back instead of failing.
+        // Must happen before the first touch, which is what places the page.
+        unsigned long mask = 1UL << node;
+        syscall(SYS_mbind, memory, size, MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0);
+    }
+    return memory;
+}
+
+void topology_free_local(void* memory, size_t size) {
+    if (memory != NULL) {
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        munmap(memory, (size + page - 1) & ~(page - 1));
+    }
+}
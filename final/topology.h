@@ -0,0 +1,40 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#define CACHE_LINE 64
+#define TOPOLOGY_MAX_CPUS 1024
+
+// Where worker threads go
+#define AFFINITY_NONE 0    // Scheduler decides, as before
+#define AFFINITY_COMPACT 1 // Hyperthread siblings first, then the next core, node by node
+#define AFFINITY_SCATTER 2 // One thread per physical core, alternating nodes, siblings last
+
+typedef struct {
+    int cpu;
+    int core;    // topology/core_id, unique only within a package
+    int package;
+    int node;    // NUMA node, 0 without NUMA
+    int sibling; // Rank among the hardware threads of its core
+} CpuInfo;
+
+int topology_init(void); // Reads sysfs, returns the online CPU count or -1
+int topology_parse_affinity(const char* name);
+const char* topology_affinity_name(int mode);
+int topology_cpu_for(int mode, int index); // CPU for the index'th worker, -1 to leave it unpinned
+int topology_node_of(int cpu);             // 0 for -1 or unknown
+int topology_node_count(void);
+void topology_print(void);
+
+// Starts the thread already bound to cpu (-1: unbound), so even its stack is
+// touched on the right node
+int topology_create_thread(pthread_t* thread, int cpu, void* (*function)(void*), void* arg);
+
+// Zeroed, page-aligned memory whose pages prefer node. Nothing else shares
+// the pages, so per-thread state neither false-shares nor crosses nodes.
+void* topology_alloc_local(size_t size, int node);
+void topology_free_local(void* memory, size_t size);
+
+#endif
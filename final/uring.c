@@ -0,0 +1,289 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "uring.h"
+
+// Kernel 6.12 headers; older headers lack them, older kernels refuse them
+#ifndef IORING_FEAT_MIN_TIMEOUT
+#define IORING_FEAT_MIN_TIMEOUT (1U << 15)
+#endif
+
+typedef struct {
+    __u64 sigmask;
+    __u32 sigmask_sz;
+    __u32 min_wait_usec;
+    __u64 ts;
+} WaitArg;
+
+// Opcodes the reactor and the logger submit
+static const int needed_ops[] = { IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_READ, IORING_OP_WRITEV, IORING_OP_FSYNC, IORING_OP_ASYNC_CANCEL };
+
+static int setup(unsigned entries, struct io_uring_params* params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int enter(int fd, unsigned to_submit, unsigned wait_count, unsigned flags, WaitArg* arg) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, wait_count, flags, arg, arg != NULL ? sizeof(*arg) : 0);
+}
+
+static int do_register(int fd, unsigned opcode, void* arg, unsigned count) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+int uring_init(Uring* ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(*ring));
+    params.flags = IORING_SETUP_CLAMP;
+    ring->fd = setup(entries, &params);
+    if (ring->fd < 0) {
+        return -1;
+    }
+
+    // Both rings share one mapping when the kernel allows it
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    int single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && ring->cq_ring_size > ring->sq_ring_size) {
+        ring->sq_ring_size = ring->cq_ring_size;
+    }
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        close(ring->fd);
+        return -1;
+    }
+    ring->cq_ring = ring->sq_ring;
+    if (!single_mmap) {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            munmap(ring->sq_ring, ring->sq_ring_size);
+            close(ring->fd);
+            return -1;
+        }
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        uring_exit(ring);
+        return -1;
+    }
+
+    char* sq = ring->sq_ring;
+    char* cq = ring->cq_ring;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    ring->sq_entries = params.sq_entries;
+    ring->features = params.features;
+    ring->local_tail = *ring->sq_tail;
+
+    // SQE i always sits in slot i of the index array
+    for (unsigned i = 0; i < params.sq_entries; ++i) {
+        ring->sq_array[i] = i;
+    }
+    return 0;
+}
+
+void uring_exit(Uring* ring) {
+    if (ring->sqes != NULL && ring->sqes != MAP_FAILED) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring != NULL) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+static int submit(Uring* ring, unsigned wait_count, WaitArg* arg) {
+    unsigned to_submit = ring->local_tail - *ring->sq_tail;
+    __atomic_store_n(ring->sq_tail, ring->local_tail, __ATOMIC_RELEASE);
+    if (to_submit == 0 && wait_count == 0) {
+        return 0;
+    }
+    unsigned flags = wait_count > 0 ? IORING_ENTER_GETEVENTS : 0;
+    if (arg != NULL) {
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+    while (1) {
+        int rc = enter(ring->fd, to_submit, wait_count, flags, arg);
+        if (rc >= 0) {
+            return rc;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+        // Interrupted after submitting counts as submitted
+        to_submit = 0;
+    }
+}
+
+int uring_submit(Uring* ring, unsigned wait_count) {
+    return submit(ring, wait_count, NULL);
+}
+
+int uring_wait_batch(Uring* ring, unsigned wait_count, unsigned min_wait_us) {
+    if (!(ring->features & IORING_FEAT_MIN_TIMEOUT) || min_wait_us == 0) {
+        return submit(ring, 1, NULL);
+    }
+    // The kernel applies the minimum wait only under an overall timeout;
+    // an idle loop wakes once a second for it and goes back to sleep
+    struct timespec idle = { URING_IDLE_SECONDS, 0 };
+    WaitArg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.min_wait_usec = min_wait_us;
+    arg.ts = (unsigned long)&idle;
+    int rc = submit(ring, wait_count, &arg);
+    if (rc < 0 && errno == ETIME) {
+        return 0;
+    }
+    if (rc < 0 && errno == EINVAL) {
+        // Header newer than the kernel: batch no more
+        ring->features &= ~IORING_FEAT_MIN_TIMEOUT;
+        return submit(ring, 1, NULL);
+    }
+    return rc;
+}
+
+struct io_uring_sqe* uring_get_sqe(Uring* ring) {
+    if (ring->local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+        if (uring_submit(ring, 0) < 0) {
+            return NULL;
+        }
+        if (ring->local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+            return NULL;
+        }
+    }
+    struct io_uring_sqe* sqe = &ring->sqes[ring->local_tail & *ring->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->local_tail++;
+    return sqe;
+}
+
+struct io_uring_cqe* uring_peek(Uring* ring) {
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return &ring->cqes[head & *ring->cq_mask];
+}
+
+void uring_seen(Uring* ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+int uring_buffers_init(Uring* ring, UringBuffers* buffers, unsigned short group) {
+    buffers->group = group;
+    buffers->ring_size = URING_RECV_BUFFERS * sizeof(struct io_uring_buf);
+    buffers->ring = mmap(NULL, buffers->ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    buffers->base = malloc((size_t)URING_RECV_BUFFERS * URING_RECV_BUFFER_SIZE);
+    if (buffers->ring == MAP_FAILED || buffers->base == NULL) {
+        if (buffers->ring != MAP_FAILED) {
+            munmap(buffers->ring, buffers->ring_size);
+        }
+        free(buffers->base);
+        buffers->ring = NULL;
+        buffers->base = NULL;
+        return -1;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (unsigned long)buffers->ring;
+    reg.ring_entries = URING_RECV_BUFFERS;
+    reg.bgid = group;
+    if (do_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        munmap(buffers->ring, buffers->ring_size);
+        free(buffers->base);
+        buffers->ring = NULL;
+        buffers->base = NULL;
+        return -1;
+    }
+
+    buffers->ring->tail = 0;
+    for (unsigned short id = 0; id < URING_RECV_BUFFERS; ++id) {
+        uring_buffer_recycle(buffers, id);
+    }
+    return 0;
+}
+
+unsigned char* uring_buffer(UringBuffers* buffers, unsigned short id) {
+    return buffers->base + (size_t)id * URING_RECV_BUFFER_SIZE;
+}
+
+// Hand a buffer back to the kernel once its bytes are copied out
+void uring_buffer_recycle(UringBuffers* buffers, unsigned short id) {
+    unsigned short tail = buffers->ring->tail;
+    struct io_uring_buf* buf = &buffers->ring->bufs[tail & (URING_RECV_BUFFERS - 1)];
+    buf->addr = (unsigned long)uring_buffer(buffers, id);
+    buf->len = URING_RECV_BUFFER_SIZE;
+    buf->bid = id;
+    __atomic_store_n(&buffers->ring->tail, (unsigned short)(tail + 1), __ATOMIC_RELEASE);
+}
+
+void uring_buffers_free(Uring* ring, UringBuffers* buffers) {
+    if (buffers->ring == NULL) {
+        return;
+    }
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = buffers->group;
+    do_register(ring->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    munmap(buffers->ring, buffers->ring_size);
+    free(buffers->base);
+    buffers->ring = NULL;
+    buffers->base = NULL;
+}
+
+// Probed once: the ring itself, every opcode we submit, and provided
+// buffer rings (5.19+). Seccomp or io_uring_disabled fail the first step.
+int uring_supported(void) {
+    static int supported = -1;
+    if (supported >= 0) {
+        return supported;
+    }
+    supported = 0;
+
+    Uring ring;
+    if (uring_init(&ring, 8) < 0) {
+        return 0;
+    }
+    size_t probe_size = sizeof(struct io_uring_probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = calloc(1, probe_size);
+    if (probe != NULL && do_register(ring.fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) >= 0) {
+        supported = 1;
+        for (size_t i = 0; i < sizeof(needed_ops) / sizeof(needed_ops[0]); ++i) {
+            if (needed_ops[i] > probe->last_op || !(probe->ops[needed_ops[i]].flags & IO_URING_OP_SUPPORTED)) {
+                supported = 0;
+            }
+        }
+    }
+    free(probe);
+
+    UringBuffers buffers;
+    if (supported && uring_buffers_init(&ring, &buffers, 0) < 0) {
+        supported = 0;
+    }
+    if (supported) {
+        uring_buffers_free(&ring, &buffers);
+    }
+    uring_exit(&ring);
+    return supported;
+}
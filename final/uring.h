@@ -0,0 +1,62 @@
+#ifndef URING_H
+#define URING_H
+
+#include <stddef.h>
+#include <linux/io_uring.h>
+
+// Thin io_uring wrapper over the raw syscalls, no liburing needed.
+// One ring per thread; nothing here is thread safe.
+
+#define URING_ENTRIES 256
+#define URING_RECV_BUFFERS 256     // Provided receive buffers per ring, power of two
+#define URING_RECV_BUFFER_SIZE 4096
+#define URING_IDLE_SECONDS 1      // Timeout under a batched wait
+
+typedef struct {
+    int fd;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    unsigned sq_entries;
+    unsigned local_tail; // SQEs handed out, published on submit
+    unsigned features;   // IORING_FEAT_* from setup
+} Uring;
+
+// Receive buffers the kernel picks from (IORING_REGISTER_PBUF_RING), so a
+// multishot recv needs no buffer of its own per connection
+typedef struct {
+    struct io_uring_buf_ring* ring;
+    unsigned char* base;
+    size_t ring_size;
+    unsigned short group;
+} UringBuffers;
+
+int uring_supported(void); // 1 if this kernel has everything the backends use
+int uring_init(Uring* ring, unsigned entries);
+void uring_exit(Uring* ring);
+struct io_uring_sqe* uring_get_sqe(Uring* ring); // Zeroed, submits first if the queue is full
+int uring_submit(Uring* ring, unsigned wait_count); // One io_uring_enter, -1 on error
+// Like uring_submit(ring, 1), but once one completion is in it keeps waiting
+// up to min_wait_us for wait_count of them, so a busy loop reaps a batch per
+// enter and an idle one still sleeps. Plain uring_submit before kernel 6.12.
+int uring_wait_batch(Uring* ring, unsigned wait_count, unsigned min_wait_us);
+struct io_uring_cqe* uring_peek(Uring* ring);     // NULL if the completion queue is empty
+void uring_seen(Uring* ring);                     // Done with the cqe from uring_peek
+
+int uring_buffers_init(Uring* ring, UringBuffers* buffers, unsigned short group);
+unsigned char* uring_buffer(UringBuffers* buffers, unsigned short id);
+void uring_buffer_recycle(UringBuffers* buffers, unsigned short id);
+void uring_buffers_free(Uring* ring, UringBuffers* buffers);
+
+#endif